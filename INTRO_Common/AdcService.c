@@ -0,0 +1,182 @@
+/**
+ * \file
+ * \brief Continuous ADC acquisition service.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The timer interrupt collects the finished conversions and starts the next ones, so the ADCs are
+ * converting all the time. Each channel keeps the last ADCS_NOF_OVERSAMPLING samples in a ring buffer,
+ * and the value returned is their moving average.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_ADC_SERVICE
+#include "AdcService.h"
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_BATTERY_ADC
+  #include "ADC_Bat.h"
+#endif
+#if PL_CONFIG_HAS_JOYSTICK
+  #include "AD1.h"
+#endif
+
+#define ADCS_NOF_OVERSAMPLING_BITS  4 /* number of samples for the moving average, as power of two */
+#define ADCS_NOF_OVERSAMPLING       (1<<ADCS_NOF_OVERSAMPLING_BITS)
+
+typedef struct {
+  uint16_t buf[ADCS_NOF_OVERSAMPLING]; /* ring buffer with the last samples */
+  uint32_t sum; /* sum of all samples in buf[] */
+  uint8_t idx; /* index of the oldest sample in buf[] */
+  uint8_t nofSamples; /* number of samples in buf[], up to ADCS_NOF_OVERSAMPLING */
+  uint32_t nofConversions; /* total number of conversions, for statistics */
+} ADCS_ChannelDesc;
+
+static ADCS_ChannelDesc ADCS_channels[ADCS_NOF_CHANNELS];
+static bool ADCS_isInitialized = FALSE;
+
+static void PushSample(ADCS_Channel ch, uint16_t val) {
+  ADCS_ChannelDesc *desc = &ADCS_channels[ch];
+
+  desc->sum -= desc->buf[desc->idx]; /* remove oldest sample (zero if not filled yet) */
+  desc->buf[desc->idx] = val;
+  desc->sum += val;
+  desc->idx = (uint8_t)((desc->idx+1)&(ADCS_NOF_OVERSAMPLING-1));
+  if (desc->nofSamples<ADCS_NOF_OVERSAMPLING) {
+    desc->nofSamples++;
+  }
+  desc->nofConversions++;
+}
+
+uint8_t ADCS_GetValue(ADCS_Channel ch, uint16_t *val) {
+  uint32_t sum;
+  uint8_t nofSamples;
+
+  if (ch>=ADCS_NOF_CHANNELS) {
+    return ERR_FAILED;
+  }
+  FRTOS1_taskENTER_CRITICAL(); /* sum and nofSamples are updated from the interrupt */
+  sum = ADCS_channels[ch].sum;
+  nofSamples = ADCS_channels[ch].nofSamples;
+  FRTOS1_taskEXIT_CRITICAL();
+  if (nofSamples<ADCS_NOF_OVERSAMPLING) {
+    *val = 0;
+    return ERR_NOTAVAIL; /* not enough conversions yet */
+  }
+  *val = (uint16_t)(sum>>ADCS_NOF_OVERSAMPLING_BITS);
+  return ERR_OK;
+}
+
+void ADCS_OnInterrupt(void) {
+#if PL_CONFIG_HAS_BATTERY_ADC
+  ADC_Bat_TResultData result;
+#endif
+#if PL_CONFIG_HAS_JOYSTICK
+  uint16_t values[2];
+#endif
+
+  if (!ADCS_isInitialized) {
+    return;
+  }
+#if PL_CONFIG_HAS_BATTERY_ADC
+  if (ADC_Bat_GetMeasurementCompleteStatus(ADC_Bat_DeviceData)) {
+    if (ADC_Bat_GetMeasuredValues(ADC_Bat_DeviceData, &result)==ERR_OK) {
+      PushSample(ADCS_CH_BATTERY, result);
+    }
+    (void)ADC_Bat_StartSingleMeasurement(ADC_Bat_DeviceData); /* start next conversion */
+  }
+#endif
+#if PL_CONFIG_HAS_JOYSTICK
+  if (AD1_GetValue16(&values[0])==ERR_OK) {
+    PushSample(ADCS_CH_JOY_X, values[0]);
+    PushSample(ADCS_CH_JOY_Y, values[1]);
+    (void)AD1_Measure(FALSE); /* start next conversion, do not wait */
+  }
+#endif
+}
+
+#if PL_CONFIG_HAS_SHELL
+static const unsigned char *ChannelName(ADCS_Channel ch) {
+  switch(ch) {
+#if PL_CONFIG_HAS_BATTERY_ADC
+    case ADCS_CH_BATTERY: return (const unsigned char*)"battery";
+#endif
+#if PL_CONFIG_HAS_JOYSTICK
+    case ADCS_CH_JOY_X:   return (const unsigned char*)"joystick x";
+    case ADCS_CH_JOY_Y:   return (const unsigned char*)"joystick y";
+#endif
+    default:              return (const unsigned char*)"unknown";
+  }
+}
+
+static void ADCS_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"adcs", (unsigned char*)"Group of ADC service commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows ADC service help or status\r\n", io->stdOut);
+}
+
+static void ADCS_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48], label[16];
+  ADCS_Channel ch;
+  uint16_t val;
+  uint32_t nofConversions;
+
+  CLS1_SendStatusStr((unsigned char*)"adcs", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), ADCS_NOF_OVERSAMPLING);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" samples\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  oversampling", buf, io->stdOut);
+  for(ch=(ADCS_Channel)0; ch<ADCS_NOF_CHANNELS; ch++) {
+    FRTOS1_taskENTER_CRITICAL();
+    nofConversions = ADCS_channels[ch].nofConversions;
+    FRTOS1_taskEXIT_CRITICAL();
+    if (ADCS_GetValue(ch, &val)==ERR_OK) {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"0x");
+      UTIL1_strcatNum16Hex(buf, sizeof(buf), val);
+    } else {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"n/a");
+    }
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", conversions: ");
+    UTIL1_strcatNum32u(buf, sizeof(buf), nofConversions);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    UTIL1_strcpy(label, sizeof(label), (unsigned char*)"  ");
+    UTIL1_strcat(label, sizeof(label), ChannelName(ch));
+    CLS1_SendStatusStr(label, buf, io->stdOut);
+  }
+}
+
+uint8_t ADCS_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, "adcs help")==0) {
+    ADCS_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, "adcs status")==0) {
+    ADCS_PrintStatus(io);
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void ADCS_Deinit(void) {
+  ADCS_isInitialized = FALSE;
+}
+
+void ADCS_Init(void) {
+#if PL_CONFIG_HAS_BATTERY_ADC
+  LDD_ADC_TSample sampleGroup[1];
+#endif
+
+  ADCS_isInitialized = FALSE;
+#if PL_CONFIG_HAS_BATTERY_ADC
+  sampleGroup[0].ChannelIdx = 0U; /* one-sample group with the battery channel, used for all conversions */
+  if (ADC_Bat_CreateSampleGroup(ADC_Bat_DeviceData, (LDD_ADC_TSample *)sampleGroup, 1)!=ERR_OK) {
+    for(;;){} /* error */
+  }
+  if (ADC_Bat_StartSingleMeasurement(ADC_Bat_DeviceData)!=ERR_OK) {
+    for(;;){} /* error */
+  }
+#endif
+#if PL_CONFIG_HAS_JOYSTICK
+  (void)AD1_Measure(FALSE); /* start first conversion */
+#endif
+  ADCS_isInitialized = TRUE;
+}
+
+#endif /* PL_CONFIG_HAS_ADC_SERVICE */
@@ -0,0 +1,60 @@
+/**
+ * \file
+ * \brief Interface to the continuous ADC acquisition service.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module converts the analog channels (battery, joystick) continuously in the background.
+ * Consumers get the latest oversampled value without waiting for a conversion.
+ */
+
+#ifndef ADCSERVICE_H_
+#define ADCSERVICE_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_ADC_SERVICE
+
+typedef enum {
+#if PL_CONFIG_HAS_BATTERY_ADC
+  ADCS_CH_BATTERY,  /*!< battery voltage divider */
+#endif
+#if PL_CONFIG_HAS_JOYSTICK
+  ADCS_CH_JOY_X,    /*!< joystick x axis */
+  ADCS_CH_JOY_Y,    /*!< joystick y axis */
+#endif
+  ADCS_NOF_CHANNELS /*!< must be last! */
+} ADCS_Channel;
+
+/*!
+ * \brief Returns the latest value of a channel, averaged over the last ADCS_NOF_OVERSAMPLING conversions. Never waits.
+ * \param ch Channel.
+ * \param val Where to store the 16bit ADC value.
+ * \return ERR_OK if everything was fine, ERR_NOTAVAIL if there are not enough conversions yet.
+ */
+uint8_t ADCS_GetValue(ADCS_Channel ch, uint16_t *val);
+
+/*!
+ * \brief Called from the timer interrupt every TMR_TICK_MS: collects the finished conversions and starts the next ones.
+ */
+void ADCS_OnInterrupt(void);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t ADCS_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void ADCS_Deinit(void);
+
+/*! \brief Initialization of the module */
+void ADCS_Init(void);
+
+#endif /* PL_CONFIG_HAS_ADC_SERVICE */
+
+#endif /* ADCSERVICE_H_ */
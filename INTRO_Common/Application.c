@@ -33,6 +33,9 @@
 #if PL_CONFIG_HAS_QUADRATURE
   #include "Q4CLeft.h"
   #include "Q4CRight.h"
+  #if PL_CONFIG_HAS_QUAD_FTM
+    #include "QuadFtm.h"
+  #endif
 #endif
 #if PL_CONFIG_HAS_MOTOR
   #include "Motor.h"
@@ -59,10 +62,13 @@
   #include "Turn.h"
 #endif
 #include "Distance.h"
+#if PL_CONFIG_HAS_OPPONENT
+  #include "Opponent.h"
+#endif
 #include "Sumo.h"
 #include "stdlib.h"
 
-#define PROGRAM_MODE 1 				// 0 = None, 1 = Primitive sumofighter , 2 = SpiralSumo, 3= Line following
+#define PROGRAM_MODE 1 				// 0 = None, 1 = Primitive sumofighter , 2 = SpiralSumo, 3= Line following, 4 = Sumo strategy engine (strategy selected with 'sumo strategy')
 
 #if PL_CONFIG_BOARD_IS_ROBO
 
@@ -203,6 +209,31 @@ void APP_EventHandler(EVNT_Handle event) {
   case EVNT_SW7_RELEASED:
      BtnMsg(7, "released");
      break;
+#endif
+#if PL_CONFIG_HAS_BATTERY_ADC
+  case EVNT_BATT_LOW:
+     SHELL_SendString((unsigned char*)"Battery low!\r\n");
+     break;
+  case EVNT_BATT_CRITICAL:
+     SHELL_SendString((unsigned char*)"Battery critical, motor power reduced!\r\n");
+     break;
+  case EVNT_BATT_OK:
+     SHELL_SendString((unsigned char*)"Battery ok.\r\n");
+     break;
+#endif
+#if PL_CONFIG_HAS_TRACTION
+  case EVNT_TRAC_GRIP:
+     SHELL_SendString((unsigned char*)"Traction: grip.\r\n");
+     break;
+  case EVNT_TRAC_SLIP:
+     SHELL_SendString((unsigned char*)"Traction: slip!\r\n");
+     break;
+  case EVNT_TRAC_PUSH:
+     SHELL_SendString((unsigned char*)"Traction: push!\r\n");
+     break;
+  case EVNT_TRAC_STALL:
+     SHELL_SendString((unsigned char*)"Traction: stall!\r\n");
+     break;
 #endif
     default:
       break;
@@ -401,6 +432,88 @@ static void drive(Drive_Mode mode) {
 	}
 }
 
+/*
+ * Maneuver engine: the strategies queue timed drive steps (turn away, back off, charge, spiral) instead of
+ * blocking with vTaskDelay(). maneuverRun() is called every cycle of the strategy loop and switches to the next
+ * step when the time is over, so border and ToF are still checked while a maneuver is running. A new maneuver
+ * replaces a running one if it has a higher priority (e.g. border escape over an obstacle turn).
+ */
+typedef enum {
+	MP_NONE,	// no maneuver running
+	MP_SEARCH,	// turning towards an opponent
+	MP_BORDER	// escaping from the ring border
+} MANEUVER_PRIO;
+
+typedef struct {
+	Drive_Mode mode;
+	uint16_t ms; // duration of the step
+} MANEUVER_STEP;
+
+#define MANEUVER_MAX_STEPS 4
+
+static MANEUVER_STEP maneuverSteps[MANEUVER_MAX_STEPS];
+static uint8_t maneuverNofSteps = 0; // number of queued steps
+static uint8_t maneuverCurrStep = 0; // step running, maneuverNofSteps if the last one has finished
+static MANEUVER_PRIO maneuverPrio = MP_NONE;
+static TickType_t maneuverStepEnd;
+static Drive_Mode maneuverDefault = DR_ST; // driven when no maneuver is running
+
+static bool maneuverBusy(void) {
+	return maneuverPrio != MP_NONE;
+}
+
+/* drives mode now or, if a maneuver is running, after it has finished */
+static void maneuverSetDefault(Drive_Mode mode) {
+	maneuverDefault = mode;
+	if(!maneuverBusy()) {
+		drive(mode);
+	}
+}
+
+/* starts a new maneuver, returns FALSE if a maneuver with the same or a higher priority is running */
+static bool maneuverStart(MANEUVER_PRIO prio) {
+	if(prio <= maneuverPrio) {
+		return FALSE;
+	}
+	maneuverPrio = prio;
+	maneuverNofSteps = 0;
+	maneuverCurrStep = 0;
+	return TRUE;
+}
+
+static void maneuverAdd(Drive_Mode mode, uint16_t ms) {
+	if(maneuverNofSteps < MANEUVER_MAX_STEPS) {
+		maneuverSteps[maneuverNofSteps].mode = mode;
+		maneuverSteps[maneuverNofSteps].ms = ms;
+		if(maneuverNofSteps == 0) { // first step starts immediately
+			drive(mode);
+			maneuverStepEnd = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+		}
+		maneuverNofSteps++;
+	}
+}
+
+static void maneuverStop(void) {
+	maneuverPrio = MP_NONE;
+	maneuverNofSteps = 0;
+	maneuverCurrStep = 0;
+}
+
+/* called every cycle of the strategy loop */
+static void maneuverRun(void) {
+	if(!maneuverBusy() || (int32_t)(xTaskGetTickCount() - maneuverStepEnd) < 0) {
+		return; // nothing to do or step still running
+	}
+	maneuverCurrStep++;
+	if(maneuverCurrStep < maneuverNofSteps) {
+		drive(maneuverSteps[maneuverCurrStep].mode);
+		maneuverStepEnd += pdMS_TO_TICKS(maneuverSteps[maneuverCurrStep].ms);
+	} else {
+		maneuverStop();
+		drive(maneuverDefault);
+	}
+}
+
 static void PrimitiveFight(void* PcParameters){
 	int randCount = 0;
 	int rando[] = {400, 300, 400, 450};
@@ -408,6 +521,11 @@ static void PrimitiveFight(void* PcParameters){
 
 	// read front and back ToF sensors
 	bool prox_f, last_prox_f, prox_b, last_prox_b;
+	bool reflex;
+#if PL_CONFIG_HAS_OPPONENT
+	#define APP_PURSUIT_BEARING_DEG 20 // turn towards the tracked opponent if it is more than this off the center
+	int16_t oppBearing, oppRange;
+#endif
 
 	DRIVER_STATE state = SETUP;
 	TickType_t xLastWakeTime = xTaskGetTickCount();
@@ -424,7 +542,9 @@ static void PrimitiveFight(void* PcParameters){
 				} else if(REF_IsReady()) {
 					SHELL_SendString("DRIVE\n");
 					vTaskDelay(pdMS_TO_TICKS(4000));
-					drive(DR_FW);
+					maneuverStop();
+					maneuverSetDefault(DR_FW);
+					REF_SetBorderReflex(TRUE);
 					SHELL_SendString("GO!\n");
 					state = DRIVE;
 				} else {
@@ -448,61 +568,90 @@ static void PrimitiveFight(void* PcParameters){
 			prox_b = DIST_NearRearObstacle(100);
 
 			if(xSemaphoreTake(btn1Sem, 0)){
+				REF_SetBorderReflex(FALSE);
+				maneuverStop();
 				drive(DR_ST);
 				SHELL_SendString("SETUP\n");
 				state = SETUP;
+				break;
 			}
 
-			else if(REF_GetLineKind() !=  REF_LINE_FULL){
-				uint16_t refValues[REF_NOF_SENSORS];
-				REF_GetSensorValues(refValues, REF_NOF_SENSORS);
-
-				if(refValues[0] < 300) {
-					// backup to the right
-					drive(DR_RT);
-				} else {
-					// back up to the left
-					drive(DR_LT);
+			reflex = REF_BorderReflexTriggered();
+			if(reflex || REF_GetLineKind() !=  REF_LINE_FULL){
+				if(reflex) {
+					maneuverStop(); // motors have been set by the reflex: take over with a new escape
+				}
+				if(maneuverStart(MP_BORDER)) { // pre-empts any other maneuver
+					uint16_t refValues[REF_NOF_SENSORS];
+					REF_GetSensorValues(refValues, REF_NOF_SENSORS);
+
+					if(refValues[0] < REF_BORDER_THRESHOLD) {
+						// backup to the right
+						maneuverAdd(DR_RT, rando[randCount]);
+					} else {
+						// back up to the left
+						maneuverAdd(DR_LT, rando[randCount]);
+					}
+					randCount++;
+					if(randCount == maxRand) randCount = 0;
+					maneuverSetDefault(DR_FW);
 				}
+			}
 
-				vTaskDelay(pdMS_TO_TICKS(rando[randCount]));
-				randCount++;
-				if(randCount == maxRand) randCount = 0;
-				drive(DR_FW);
+			else if(maneuverPrio == MP_BORDER) {
+				// keep on escaping
 			}
 
 			else if(prox_f != last_prox_f){
 				if(prox_f){
-					drive(DR_FSF);
+					maneuverStop(); // charge
+					maneuverSetDefault(DR_FSF);
 				} else {
-					drive(DR_FW);
+					maneuverSetDefault(DR_FW);
 				}
 			}
 
 			else if(prox_b != last_prox_b){
 				if(prox_b){
-					drive(DR_FSB);
+					maneuverStop(); // back off
+					maneuverSetDefault(DR_FSB);
 				} else {
-					drive(DR_FW);
+					maneuverSetDefault(DR_FW);
 				}
 			}
 
 			else if(DIST_NearLeftObstacle(200)) {
-				drive(DR_L90);
-				vTaskDelay(pdMS_TO_TICKS(200)); // old 100
-				drive(DR_FW);
-				vTaskDelay(pdMS_TO_TICKS(200)); // old 100
+				if(maneuverStart(MP_SEARCH)) {
+					maneuverAdd(DR_L90, 200); // old 100
+					maneuverAdd(DR_FW, 200); // old 100
+				}
 			}
 
 			else if(DIST_NearRightObstacle(200)) {
-				drive(DR_R90);
-				vTaskDelay(pdMS_TO_TICKS(200));
-				drive(DR_FW);
-				vTaskDelay(pdMS_TO_TICKS(200));
+				if(maneuverStart(MP_SEARCH)) {
+					maneuverAdd(DR_R90, 200);
+					maneuverAdd(DR_FW, 200);
+				}
+			}
+
+#if PL_CONFIG_HAS_OPPONENT
+			else if(!prox_f && !prox_b && OPP_GetTarget(&oppBearing, &oppRange)) {
+				// opponent has left the sensors: turn to where the tracker expects it
+				if(oppBearing > APP_PURSUIT_BEARING_DEG) {
+					maneuverSetDefault(DR_L90);
+				} else if(oppBearing < -APP_PURSUIT_BEARING_DEG) {
+					maneuverSetDefault(DR_R90);
+				} else {
+					maneuverSetDefault(DR_FW);
+				}
 			}
+#endif
 
-			last_prox_f = prox_f;
-			last_prox_b = prox_b;
+			if(maneuverPrio != MP_BORDER) { // changes while escaping are handled afterwards
+				last_prox_f = prox_f;
+				last_prox_b = prox_b;
+			}
+			maneuverRun();
 
 			break;
 		}
@@ -515,6 +664,7 @@ static void PrimitiveFight(void* PcParameters){
 static void SpiralFight(void* PcParameters){
 	//uint16_t refValues[REF_NOF_SENSORS];
 	//int counter = 0;
+	bool prox, last_prox = FALSE, reflex;
 	DRIVER_STATE state = SETUP;
 	TickType_t xLastWakeTime = xTaskGetTickCount();
 
@@ -546,33 +696,40 @@ static void SpiralFight(void* PcParameters){
 
 		case READY:
 			if(REF_GetLineKind()==  REF_LINE_FULL){
-				drive(DR_SPO);
+				maneuverStop();
+				maneuverSetDefault(DR_SPO);
+				REF_SetBorderReflex(TRUE);
 				state = DRIVE;
 			}
 			break;
 
 
 		case DRIVE:
-			if(REF_GetLineKind() !=  REF_LINE_FULL){
-				uint16_t refValues[REF_NOF_SENSORS];
-				REF_GetSensorValues(refValues, REF_NOF_SENSORS);
-				drive(DR_SPI);
-				vTaskDelay(pdMS_TO_TICKS(500));
-				drive(DR_SPO);
+			reflex = REF_BorderReflexTriggered();
+			if(reflex || REF_GetLineKind() !=  REF_LINE_FULL){
+				if(reflex) {
+					maneuverStop(); // motors have been set by the reflex: take over with a new escape
+				}
+				if(maneuverStart(MP_BORDER)) {
+					maneuverAdd(DR_SPI, 500); // spiral back into the ring
+					maneuverSetDefault(DR_SPO);
+				}
 			}
 
-			bool prox, last_prox;
 			prox = DIST_NearFrontObstacle(100);
-			if(prox != last_prox){
+			if(prox != last_prox && maneuverPrio != MP_BORDER){
 				if(prox){
-					drive(DR_FSF);
+					maneuverSetDefault(DR_FSF);
 				} else {
-					drive(DR_SPO);
+					maneuverSetDefault(DR_SPO);
 				}
+				last_prox = prox;
 			}
-			last_prox = prox;
+			maneuverRun();
 
 			if(xSemaphoreTake(btn1Sem, 0)){
+				REF_SetBorderReflex(FALSE);
+				maneuverStop();
 				drive(DR_ST);
 				state = SETUP;
 			}
@@ -642,6 +799,55 @@ static void LineFollowing(void* pvParameters) {
     vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(30));
   }
 }
+
+#if PL_CONFIG_HAS_SUMO
+// calibration and start/stop with the button, the strategy itself runs in the Sumo task
+static void SumoEngine(void* pvParameters) {
+	DRIVER_STATE state = SETUP;
+	TickType_t xLastWakeTime = xTaskGetTickCount();
+
+	while(!0){
+		switch (state){
+		case SETUP:
+			if(xSemaphoreTake(btn1Sem, 0)){
+				if(xSemaphoreTake(btn1LongSem, 600)) {
+					if(REF_CalibrateStart()) {
+						LED2_On();
+						state = CALIB;
+					}
+				} else if(REF_IsReady()) {
+					SUMO_StartSumo();
+					state = DRIVE;
+				} else {
+					SHELL_SendString("Line Sensors not ready\n");
+				}
+			}
+			break;
+
+		case CALIB:
+			if(xSemaphoreTake(btn1Sem, 0)) {
+				if(REF_CalibrateStop()) {
+					LED2_Off();
+					state = SETUP;
+				}
+			}
+			break;
+
+		case DRIVE:
+			if(xSemaphoreTake(btn1Sem, 0)){
+				SUMO_StopSumo();
+				state = SETUP;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(30));
+	}
+}
+#endif
 #endif
 
 
@@ -720,6 +926,20 @@ void APP_Start(void) {
   }
 #endif
 
+#if PROGRAM_MODE == 4 && PL_CONFIG_HAS_SUMO
+  xTaskHandle taskHandleSumoEngine;
+  res = xTaskCreate(SumoEngine,
+   	  	  "SumoEngine",
+ 		  configMINIMAL_STACK_SIZE + 50,
+ 		  (void*)NULL,
+ 		  tskIDLE_PRIORITY+1,
+ 		  &taskHandleSumoEngine
+ 		 );
+  if(res != pdPASS) {
+	  for(;;) {} // shiit
+  }
+#endif
+
 #if PROGRAM_MODE == 3
 
   xTaskHandle taskHandleLineFollowing;
@@ -9,17 +9,56 @@
 #include "Platform.h"
 #if PL_CONFIG_HAS_BATTERY_ADC
 #include "Battery.h"
-#include "ADC_Bat.h"
+#if PL_CONFIG_HAS_ADC_SERVICE
+  #include "AdcService.h"
+#else
+  #include "ADC_Bat.h"
+#endif
 #include "CLS1.h"
 #include "FRTOS1.h"
+#if PL_CONFIG_HAS_MOTOR
+  #include "Motor.h"
+#endif
+#if PL_CONFIG_HAS_EVENTS
+  #include "Event.h"
+#endif
 
+/*! \todo adopt the voltages for your battery */
+#define BATT_NOMINAL_CV       480 /* nominal battery voltage (4xAA NiMH), motor duties are compensated to this voltage */
+#define BATT_LOW_CV           440 /* below this voltage the battery is low */
+#define BATT_CRITICAL_CV      420 /* below this voltage the battery is critical */
+#define BATT_HYSTERESIS_CV    10  /* voltage has to raise by this amount above a level to leave the state */
+#define BATT_CRITICAL_DERATE  75  /* motor power in percent if battery is critical */
+#define BATT_FILTER_SHIFT     3   /* filter constant: new value is weighted with 1/8 */
+#define BATT_TASK_PERIOD_MS   100 /* measurement period */
+
+static uint32_t BATT_FilteredCv16 = 0; /* filtered voltage in 1/16 centi-volt units */
+static bool BATT_HasFiltered = FALSE; /* if BATT_FilteredCv16 is valid */
+static BATT_State BATT_state = BATT_STATE_OK;
+
+#define BAT_V_DIVIDER_UP   62 /* voltage divider pull-up */
+#define BAT_V_DIVIDER_DOWN 30 /* voltage divider pull-down */
+
+#if PL_CONFIG_HAS_ADC_SERVICE
+uint8_t BATT_MeasureBatteryVoltage(uint16_t *cvP) {
+  uint16_t raw;
+  uint32_t milliVolts;
+
+  *cvP = 0; /* init */
+  if (ADCS_GetValue(ADCS_CH_BATTERY, &raw)!=ERR_OK) { /* latest oversampled value, does not wait */
+    return ERR_FAILED;
+  }
+  /* reference voltage is 3.3V. Battry Voltage is using a voltage divider (R29, 62KOhm pullup to VBat, R30 30kOhm pull down to GND) */
+  milliVolts = (uint32_t)raw*330*(BAT_V_DIVIDER_UP+BAT_V_DIVIDER_DOWN)/BAT_V_DIVIDER_DOWN/0xffff; /* scale it to centi-volt. Do multiplication first to avoid numerical issues */
+  *cvP = milliVolts;
+  return ERR_OK;
+}
+#else
 uint8_t BATT_MeasureBatteryVoltage(uint16_t *cvP) {
   #define SAMPLE_GROUP_SIZE 1U
   ADC_Bat_TResultData results[SAMPLE_GROUP_SIZE]={0};
   LDD_ADC_TSample SampleGroup[SAMPLE_GROUP_SIZE];
   uint32_t milliVolts;
-#define BAT_V_DIVIDER_UP   62 /* voltage divider pull-up */
-#define BAT_V_DIVIDER_DOWN 30 /* voltage divider pull-down */
 
   *cvP = 0; /* init */
   SampleGroup[0].ChannelIdx = 0U;  /* Create one-sample group */
@@ -40,6 +79,115 @@ uint8_t BATT_MeasureBatteryVoltage(uint16_t *cvP) {
   *cvP = milliVolts;
   return ERR_OK;
 }
+#endif /* PL_CONFIG_HAS_ADC_SERVICE */
+
+uint8_t BATT_GetFilteredVoltage(uint16_t *cvP) {
+  uint32_t cv16;
+  bool valid;
+
+  FRTOS1_taskENTER_CRITICAL();
+  cv16 = BATT_FilteredCv16;
+  valid = BATT_HasFiltered;
+  FRTOS1_taskEXIT_CRITICAL();
+  if (!valid) {
+    *cvP = 0;
+    return ERR_FAILED;
+  }
+  *cvP = (uint16_t)((cv16+8)>>4);
+  return ERR_OK;
+}
+
+BATT_State BATT_GetState(void) {
+  return BATT_state;
+}
+
+static BATT_State NewState(BATT_State state, uint16_t cv) {
+  switch(state) {
+    case BATT_STATE_OK:
+      if (cv<BATT_CRITICAL_CV) {
+        return BATT_STATE_CRITICAL;
+      } else if (cv<BATT_LOW_CV) {
+        return BATT_STATE_LOW;
+      }
+      break;
+    case BATT_STATE_LOW:
+      if (cv<BATT_CRITICAL_CV) {
+        return BATT_STATE_CRITICAL;
+      } else if (cv>=BATT_LOW_CV+BATT_HYSTERESIS_CV) {
+        return BATT_STATE_OK;
+      }
+      break;
+    case BATT_STATE_CRITICAL:
+      if (cv>=BATT_LOW_CV+BATT_HYSTERESIS_CV) {
+        return BATT_STATE_OK;
+      } else if (cv>=BATT_CRITICAL_CV+BATT_HYSTERESIS_CV) {
+        return BATT_STATE_LOW;
+      }
+      break;
+    default:
+      break;
+  }
+  return state;
+}
+
+#if PL_CONFIG_HAS_MOTOR
+static void UpdateMotorCompensation(uint16_t cv) {
+  uint32_t factor;
+
+  if (cv==0) {
+    return;
+  }
+  factor = ((uint32_t)BATT_NOMINAL_CV*MOT_COMP_ONE)/cv; /* nominal/actual */
+  if (BATT_state==BATT_STATE_LOW && factor>MOT_COMP_ONE) {
+    factor = MOT_COMP_ONE; /* derate: do not boost an empty battery */
+  } else if (BATT_state==BATT_STATE_CRITICAL) {
+    factor = (MOT_COMP_ONE*BATT_CRITICAL_DERATE)/100; /* reduce power */
+  }
+  if (factor>MOT_COMP_MAX) {
+    factor = MOT_COMP_MAX;
+  }
+  MOT_SetSupplyCompensation((uint16_t)factor);
+}
+#endif
+
+static void BatteryTask(void *pvParameters) {
+  TickType_t xLastWakeTime;
+  uint16_t cv;
+  BATT_State state;
+
+  (void)pvParameters;
+  xLastWakeTime = xTaskGetTickCount();
+  for(;;) {
+    if (BATT_MeasureBatteryVoltage(&cv)==ERR_OK) {
+      FRTOS1_taskENTER_CRITICAL();
+      if (!BATT_HasFiltered) {
+        BATT_FilteredCv16 = (uint32_t)cv<<4; /* first value */
+        BATT_HasFiltered = TRUE;
+      } else { /* first order low pass */
+        BATT_FilteredCv16 = BATT_FilteredCv16-(BATT_FilteredCv16>>BATT_FILTER_SHIFT)+(((uint32_t)cv<<4)>>BATT_FILTER_SHIFT);
+      }
+      FRTOS1_taskEXIT_CRITICAL();
+      (void)BATT_GetFilteredVoltage(&cv);
+      state = NewState(BATT_state, cv);
+      if (state!=BATT_state) {
+        BATT_state = state;
+#if PL_CONFIG_HAS_EVENTS
+        if (state==BATT_STATE_CRITICAL) {
+          EVNT_SetEvent(EVNT_BATT_CRITICAL);
+        } else if (state==BATT_STATE_LOW) {
+          EVNT_SetEvent(EVNT_BATT_LOW);
+        } else {
+          EVNT_SetEvent(EVNT_BATT_OK);
+        }
+#endif
+      }
+#if PL_CONFIG_HAS_MOTOR
+      UpdateMotorCompensation(cv);
+#endif
+    }
+    vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(BATT_TASK_PERIOD_MS));
+  }
+}
 
 static uint8_t BATT_PrintStatus(const CLS1_StdIOType *io) {
   uint8_t buf[32];
@@ -47,13 +195,26 @@ static uint8_t BATT_PrintStatus(const CLS1_StdIOType *io) {
 
   CLS1_SendStatusStr((unsigned char*)"battery", (unsigned char*)"\r\n", io->stdOut);
   buf[0] = '\0';
-  if (BATT_MeasureBatteryVoltage(&cv)==ERR_OK) {
+  if (BATT_GetFilteredVoltage(&cv)==ERR_OK) {
     UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), cv);
     UTIL1_strcat(buf, sizeof(buf), (uint8_t*)" V\r\n");
   } else {
     UTIL1_strcat(buf, sizeof(buf), (uint8_t*)"ERROR\r\n");
   }
   CLS1_SendStatusStr((unsigned char*)"  Battery", buf, io->stdOut);
+  switch(BATT_state) {
+    case BATT_STATE_OK:       UTIL1_strcpy(buf, sizeof(buf), (uint8_t*)"ok\r\n"); break;
+    case BATT_STATE_LOW:      UTIL1_strcpy(buf, sizeof(buf), (uint8_t*)"low\r\n"); break;
+    case BATT_STATE_CRITICAL: UTIL1_strcpy(buf, sizeof(buf), (uint8_t*)"critical\r\n"); break;
+    default:                  UTIL1_strcpy(buf, sizeof(buf), (uint8_t*)"unknown\r\n"); break;
+  }
+  CLS1_SendStatusStr((unsigned char*)"  State", buf, io->stdOut);
+#if PL_CONFIG_HAS_MOTOR
+  buf[0] = '\0';
+  UTIL1_strcatNum32sDotValue100(buf, sizeof(buf), (int32_t)(((uint32_t)MOT_GetSupplyCompensation()*100)/MOT_COMP_ONE));
+  UTIL1_strcat(buf, sizeof(buf), (uint8_t*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  Motor comp", buf, io->stdOut);
+#endif
   return ERR_OK;
 }
 
@@ -78,9 +239,17 @@ uint8_t BATT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
 
 
 void BATT_Init(void){
+  BATT_HasFiltered = FALSE;
+  BATT_state = BATT_STATE_OK;
+  if (xTaskCreate(BatteryTask, "Battery", 400/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+1, NULL) != pdPASS) {
+    for(;;){} /* error */
+  }
 }
 
 void BATT_Deinit(void) {
+#if PL_CONFIG_HAS_MOTOR
+  MOT_SetSupplyCompensation(MOT_COMP_ONE);
+#endif
 }
 
 #endif /* PL_CONFIG_HAS_BATTERY_ADC */
@@ -30,6 +30,24 @@ uint8_t BATT_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
  */
 uint8_t BATT_MeasureBatteryVoltage(uint16_t *cvP);
 
+typedef enum {
+  BATT_STATE_OK,       /*!< battery voltage is fine */
+  BATT_STATE_LOW,      /*!< battery voltage is low, motor compensation does not boost any more */
+  BATT_STATE_CRITICAL  /*!< battery voltage is critical, motor power is reduced */
+} BATT_State;
+
+/*!
+ * \brief Returns the filtered battery voltage of the background monitor, does not wait for a measurement.
+ * \param cvP Pointer to variable where to store the voltage in centi-voltage units (330 is 3.3V)
+ * \return Error code, ERR_OK if everything was fine, ERR_FAILED if there is no measurement yet.
+ */
+uint8_t BATT_GetFilteredVoltage(uint16_t *cvP);
+
+/*!
+ * \brief Returns the battery state of the background monitor.
+ * \return Battery state.
+ */
+BATT_State BATT_GetState(void);
 
 /*!
  * \brief Module Initialization.
@@ -16,6 +16,7 @@
 #endif
 #include "Shell.h"
 #if PL_HAS_FRONT_DISTANCE
+  #include "CS1.h"
   #include "RSig.h"
   #include "REn.h"
   #include "MSig.h"
@@ -37,11 +38,15 @@
   #include "TofCE2.h"
   #include "TofCE3.h"
   #include "TofCE4.h"
+  #include "ToFHealth.h"
 #endif
 
 #if PL_HAS_TOF_SENSOR
 
 #define VL_NOF_DEVICES 4 /* we have a sensor on each side of the robot */
+#if VL_NOF_DEVICES>TOFH_MAX_DEVICES
+  #error "too many ToF devices for ToFHealth"
+#endif
 
 static void DIST_TOF_CEPinAction_1(VL6180X_PIN_ACTION action) {
   switch(action) {
@@ -83,11 +88,11 @@ static void DIST_TOF_CEPinAction_4(VL6180X_PIN_ACTION action) {
   }
 }
 
-typedef struct {
-  int16_t mm; /* distance in mm, negative values are error values */
-} DIST_ToF_DeviceDesc;
+#define DIST_TOF_REINIT_DELAY_MS         10 /* time to keep the CE pin low and to wait for the device to boot */
+
+static uint16_t DIST_ToF_NofBusResets = 0; /* number of times the whole ToF bus has been power-cycled */
 
-static DIST_ToF_DeviceDesc ToFDevice[VL_NOF_DEVICES]; /* ToF sensor distance in millimeters */
+static TOFH_Device ToFDevice[VL_NOF_DEVICES]; /* ToF sensor distance in millimeters */
 static VL6180X_Device DIST_ToF_Devices[] = {
   {.ptp_offset=0, .deviceAddr=VL6180X_DEFAULT_I2C_ADDRESS+1, .scale=VL6180X_SCALING_DEFAULT, .pinAction=DIST_TOF_CEPinAction_1},
   {.ptp_offset=0, .deviceAddr=VL6180X_DEFAULT_I2C_ADDRESS+2, .scale=VL6180X_SCALING_DEFAULT, .pinAction=DIST_TOF_CEPinAction_2},
@@ -105,7 +110,14 @@ typedef enum {
 #endif
 
 #if PL_HAS_FRONT_DISTANCE
-  #define DIST_IR_WAIT_MS   1
+  #define DIST_IR_NOF_PIN_SAMPLES   4 /* number of receiver samples in each timer interrupt */
+  #define DIST_IR_NOF_SCAN_ROUNDS   4 /* number of scan rounds over all emitters accumulated into one echo matrix */
+
+  static volatile bool DIST_IR_ScanEnabled = TRUE; /* if the timer interrupt scans the emitters */
+  static uint8_t DIST_IR_Emitter = 0; /* emitter currently turned on */
+  static uint8_t DIST_IR_Round = 0; /* current scan round */
+  static uint8_t DIST_IR_Accu[DIST_IR_NOF_EMITTERS][DIST_IR_NOF_RECEIVERS]; /* echo counters of current scan */
+  static DIST_IR_EchoMatrix DIST_IR_Matrix; /* last complete echo matrix */
 #endif
 
 #if PL_HAS_SIDE_DISTANCE
@@ -179,81 +191,146 @@ static uint8_t LMRBits(void) {
   
   val = 0;
   if (LSig_GetVal()==FALSE) { /* sensor received echo */
-    val |= (1<<2);
+    val |= DIST_IR_LEFT;
   }
   if (MSig_GetVal()==FALSE) { /* sensor received echo */
-    val |= (1<<1);
+    val |= DIST_IR_MIDDLE;
   }
   if (RSig_GetVal()==FALSE) { /* sensor received echo */
-    val |= (1<<0);
+    val |= DIST_IR_RIGHT;
   }
   return val;
 }
 
-uint8_t DIST_GetSensorBitsLeft(void) {
-  uint8_t i, val = 0;
+static void DIST_IR_EmitterOn(uint8_t emitter) {
+  switch(emitter) {
+    case DIST_IR_POS_LEFT:   LEn_SetVal(); break; /* HIGH: enable sensor */
+    case DIST_IR_POS_MIDDLE: MEn_SetVal(); break;
+    case DIST_IR_POS_RIGHT:  REn_SetVal(); break;
+    default: break;
+  }
+}
 
-  LEn_SetVal(); /* HIGH: enable sensor */
-  WAIT1_WaitOSms(DIST_IR_WAIT_MS); /* wait until IR LED is turned on */
-  for(i=0;i<10;i++) {
-    val |= LMRBits();
+static void DIST_IR_EmitterOff(uint8_t emitter) {
+  switch(emitter) {
+    case DIST_IR_POS_LEFT:   LEn_ClrVal(); break; /* LOW: disable sensor */
+    case DIST_IR_POS_MIDDLE: MEn_ClrVal(); break;
+    case DIST_IR_POS_RIGHT:  REn_ClrVal(); break;
+    default: break;
   }
-  LEn_ClrVal(); /* LOW: disable sensor */
-  return val;
 }
 
-uint8_t DIST_GetSensorBitsMiddle(void) {
-  uint8_t i, val = 0;
-  
-  MEn_SetVal(); /* HIGH: enable sensor */
-  WAIT1_WaitOSms(DIST_IR_WAIT_MS); /* wait until IR LED is turned on */
-  for(i=0;i<10;i++) {
-    val |= LMRBits();
+void DIST_IR_OnInterrupt(void) {
+  uint8_t i, bits;
+
+  if (!DIST_IR_ScanEnabled) {
+    return;
   }
-  MEn_ClrVal(); /* LOW: disable sensor */
-  return val;
+  /* emitter has been turned on in the previous interrupt, so the IR LED is on now: sample the receivers */
+  for(i=0;i<DIST_IR_NOF_PIN_SAMPLES;i++) {
+    bits = LMRBits();
+    if (bits&DIST_IR_LEFT) {
+      DIST_IR_Accu[DIST_IR_Emitter][DIST_IR_POS_LEFT]++;
+    }
+    if (bits&DIST_IR_MIDDLE) {
+      DIST_IR_Accu[DIST_IR_Emitter][DIST_IR_POS_MIDDLE]++;
+    }
+    if (bits&DIST_IR_RIGHT) {
+      DIST_IR_Accu[DIST_IR_Emitter][DIST_IR_POS_RIGHT]++;
+    }
+  }
+  DIST_IR_EmitterOff(DIST_IR_Emitter);
+  DIST_IR_Emitter++;
+  if (DIST_IR_Emitter==DIST_IR_NOF_EMITTERS) { /* scan round finished */
+    DIST_IR_Emitter = 0;
+    DIST_IR_Round++;
+    if (DIST_IR_Round==DIST_IR_NOF_SCAN_ROUNDS) { /* publish matrix */
+      DIST_IR_Round = 0;
+      for(i=0;i<DIST_IR_NOF_EMITTERS;i++) {
+        DIST_IR_Matrix.cnt[i][DIST_IR_POS_LEFT] = DIST_IR_Accu[i][DIST_IR_POS_LEFT];
+        DIST_IR_Matrix.cnt[i][DIST_IR_POS_MIDDLE] = DIST_IR_Accu[i][DIST_IR_POS_MIDDLE];
+        DIST_IR_Matrix.cnt[i][DIST_IR_POS_RIGHT] = DIST_IR_Accu[i][DIST_IR_POS_RIGHT];
+        DIST_IR_Accu[i][DIST_IR_POS_LEFT] = 0;
+        DIST_IR_Accu[i][DIST_IR_POS_MIDDLE] = 0;
+        DIST_IR_Accu[i][DIST_IR_POS_RIGHT] = 0;
+      }
+      DIST_IR_Matrix.seq++;
+    }
+  }
+  DIST_IR_EmitterOn(DIST_IR_Emitter); /* will be sampled in the next interrupt */
 }
 
-uint8_t DIST_GetSensorBitsRight(void) {
-  uint8_t i, val = 0;
+void DIST_IR_ScanEnable(bool on) {
+  uint8_t i;
+  CS1_CriticalVariable()
 
-  REn_SetVal(); /* HIGH: enable sensor */
-  WAIT1_WaitOSms(DIST_IR_WAIT_MS); /* wait until IR LED is turned on */
-  for(i=0;i<10;i++) {
-    val |= LMRBits();
+  CS1_EnterCritical();
+  DIST_IR_ScanEnabled = on;
+  for(i=0;i<DIST_IR_NOF_EMITTERS;i++) {
+    DIST_IR_EmitterOff(i);
+    DIST_IR_Accu[i][DIST_IR_POS_LEFT] = 0;
+    DIST_IR_Accu[i][DIST_IR_POS_MIDDLE] = 0;
+    DIST_IR_Accu[i][DIST_IR_POS_RIGHT] = 0;
+  }
+  DIST_IR_Emitter = 0;
+  DIST_IR_Round = 0;
+  if (on) {
+    DIST_IR_EmitterOn(DIST_IR_Emitter);
+  }
+  CS1_ExitCritical();
+}
+
+bool DIST_IR_ScanIsEnabled(void) {
+  return DIST_IR_ScanEnabled;
+}
+
+void DIST_IR_GetEchoMatrix(DIST_IR_EchoMatrix *matrix) {
+  CS1_CriticalVariable()
+
+  CS1_EnterCritical();
+  *matrix = DIST_IR_Matrix; /* copy it, as the timer interrupt might update it */
+  CS1_ExitCritical();
+}
+
+static uint8_t DIST_IR_GetBits(uint8_t emitter) {
+  DIST_IR_EchoMatrix matrix;
+  uint8_t val = 0;
+
+  DIST_IR_GetEchoMatrix(&matrix);
+  if (matrix.cnt[emitter][DIST_IR_POS_LEFT]!=0) {
+    val |= DIST_IR_LEFT;
+  }
+  if (matrix.cnt[emitter][DIST_IR_POS_MIDDLE]!=0) {
+    val |= DIST_IR_MIDDLE;
+  }
+  if (matrix.cnt[emitter][DIST_IR_POS_RIGHT]!=0) {
+    val |= DIST_IR_RIGHT;
   }
-  REn_ClrVal(); /* LOW: disable sensor */
   return val;
 }
 
+uint8_t DIST_GetSensorBitsLeft(void) {
+  return DIST_IR_GetBits(DIST_IR_POS_LEFT);
+}
+
+uint8_t DIST_GetSensorBitsMiddle(void) {
+  return DIST_IR_GetBits(DIST_IR_POS_MIDDLE);
+}
+
+uint8_t DIST_GetSensorBitsRight(void) {
+  return DIST_IR_GetBits(DIST_IR_POS_RIGHT);
+}
+
 bool DIST_LeftOn(void){
- bool isOn;
- 
- LEn_SetVal(); /* HIGH: enable sensor */
- WAIT1_WaitOSms(DIST_IR_WAIT_MS); /* wait until IR LED is turned on */
- isOn = LSig_GetVal()==FALSE; /* LOW means something is in range */
- LEn_ClrVal(); /* LOW: disable sensor */
- return isOn;
+  return (DIST_GetSensorBitsLeft()&DIST_IR_LEFT)!=0; /* echo of left emitter on left receiver */
 }
 
 bool DIST_MiddleOn(void){
- bool isOn;
- 
- MEn_SetVal(); /* HIGH: enable sensor */
- WAIT1_WaitOSms(DIST_IR_WAIT_MS); /* wait until IR LED is turned on */
- isOn = MSig_GetVal()==FALSE; /* LOW means something is in range */
- MEn_ClrVal(); /* LOW: disable sensor */
- return isOn;
+  return (DIST_GetSensorBitsMiddle()&DIST_IR_MIDDLE)!=0; /* echo of middle emitter on middle receiver */
 }
 
 bool DIST_RightOn(void){
- bool isOn;
- 
- REn_SetVal(); /* HIGH: enable sensor */
- WAIT1_WaitOSms(DIST_IR_WAIT_MS); /* wait until IR LED is turned on */
- isOn = RSig_GetVal()==FALSE; /* LOW means something is in range */
- REn_ClrVal(); /* LOW: disable sensor */
- return isOn;
+  return (DIST_GetSensorBitsRight()&DIST_IR_RIGHT)!=0; /* echo of right emitter on right receiver */
 }
 #endif
 
@@ -391,9 +468,13 @@ static void DIST_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"dist", (unsigned char*)"Group of distance commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows line help or status\r\n", io->stdOut);
 #if PL_HAS_FRONT_DISTANCE
-  CLS1_SendHelpStr((unsigned char*)"  (l|m|r) (on|off)", (unsigned char*)"Turn sensor (left, middle, right) on or off\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  scan (on|off)", (unsigned char*)"Enable or disable scanning of the front sensors in the timer interrupt\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  (l|m|r) (on|off)", (unsigned char*)"Turn sensor (left, middle, right) on or off, disables scanning\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  test", (unsigned char*)"Test sensors\r\n", io->stdOut);
 #endif
+#if PL_HAS_TOF_SENSOR && TOFH_CONFIG_FAULT_INJECTION
+  CLS1_SendHelpStr((unsigned char*)"  tof fault <dev> <nof>", (unsigned char*)"Simulate <nof> I2C faults on ToF device (0: rear, 1: right, 2: front, 3: left)\r\n", io->stdOut);
+#endif
 }
 
 static void DIST_PrintStatus(const CLS1_StdIOType *io) {
@@ -423,6 +504,27 @@ static void DIST_PrintStatus(const CLS1_StdIOType *io) {
   }
 #endif
 #if PL_HAS_FRONT_DISTANCE
+  {
+    DIST_IR_EchoMatrix matrix;
+    uint8_t buf[48];
+    int i;
+
+    CLS1_SendStatusStr((unsigned char*)"  scan", DIST_IR_ScanIsEnabled()?(unsigned char*)"on\r\n":(unsigned char*)"off\r\n", io->stdOut);
+    DIST_IR_GetEchoMatrix(&matrix);
+    UTIL1_Num32uToStr(buf, sizeof(buf), matrix.seq);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  matrix #", buf, io->stdOut);
+    for(i=0;i<DIST_IR_NOF_EMITTERS;i++) {
+      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"L:");
+      UTIL1_strcatNum8u(buf, sizeof(buf), matrix.cnt[i][DIST_IR_POS_LEFT]);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" M:");
+      UTIL1_strcatNum8u(buf, sizeof(buf), matrix.cnt[i][DIST_IR_POS_MIDDLE]);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" R:");
+      UTIL1_strcatNum8u(buf, sizeof(buf), matrix.cnt[i][DIST_IR_POS_RIGHT]);
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+      CLS1_SendStatusStr(i==DIST_IR_POS_LEFT?(unsigned char*)"  emitter L":(i==DIST_IR_POS_MIDDLE?(unsigned char*)"  emitter M":(unsigned char*)"  emitter R"), buf, io->stdOut);
+    }
+  }
   CLS1_SendStatusStr((unsigned char*)"  left", DIST_LeftOn()?(unsigned char*)"on\r\n":(unsigned char*)"off\r\n", io->stdOut);
   CLS1_SendStatusStr((unsigned char*)"  middle", DIST_MiddleOn()?(unsigned char*)"on\r\n":(unsigned char*)"off\r\n", io->stdOut);
   CLS1_SendStatusStr((unsigned char*)"  right", DIST_RightOn()?(unsigned char*)"on\r\n":(unsigned char*)"off\r\n", io->stdOut);
@@ -501,6 +603,33 @@ static void DIST_PrintStatus(const CLS1_StdIOType *io) {
     UTIL1_strcatNum16s(buf, sizeof(buf), DIST_GetDistance(DIST_SENSOR_RIGHT));
     UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
     CLS1_SendStatusStr((unsigned char*)"  range", buf, io->stdOut);
+    {
+      static const unsigned char *const names[VL_NOF_DEVICES] = {(unsigned char*)"  ToF rear", (unsigned char*)"  ToF right", (unsigned char*)"  ToF front", (unsigned char*)"  ToF left"};
+      int i;
+
+      for(i=0;i<VL_NOF_DEVICES;i++) {
+        switch(ToFDevice[i].state) {
+          case TOFH_STATE_OK:     UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"ok"); break;
+          case TOFH_STATE_RETRY:  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"retry"); break;
+          case TOFH_STATE_REINIT: UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"re-init"); break;
+          case TOFH_STATE_FAILED: UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"failed"); break;
+          default:                UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"unknown"); break;
+        }
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", errors: ");
+        UTIL1_strcatNum16u(buf, sizeof(buf), ToFDevice[i].nofErrors);
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", re-init: ");
+        UTIL1_strcatNum16u(buf, sizeof(buf), ToFDevice[i].nofReinit);
+#if TOFH_CONFIG_FAULT_INJECTION
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", inject: ");
+        UTIL1_strcatNum8u(buf, sizeof(buf), ToFDevice[i].nofInjectedFaults);
+#endif
+        UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+        CLS1_SendStatusStr(names[i], buf, io->stdOut);
+      }
+    }
+    UTIL1_Num16uToStr(buf, sizeof(buf), DIST_ToF_NofBusResets);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  bus resets", buf, io->stdOut);
 #if 0
     res = VL_ReadAmbientSingle(&ambient);
     if (res!=ERR_OK) {
@@ -528,19 +657,28 @@ uint8_t DIST_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
     DIST_PrintStatus(io);
     *handled = TRUE;
 #if PL_HAS_FRONT_DISTANCE
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"dist scan on")==0) {
+    DIST_IR_ScanEnable(TRUE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"dist scan off")==0) {
+    DIST_IR_ScanEnable(FALSE);
+    *handled = TRUE;
   } else if (UTIL1_strcmp((char*)cmd, (char*)"dist l on")==0) {
+    DIST_IR_ScanEnable(FALSE); /* otherwise the timer interrupt would turn it off again */
     LEn_SetVal(); /* HIGH: enable sensor */
     *handled = TRUE;
   } else if (UTIL1_strcmp((char*)cmd, (char*)"dist l off")==0) {
     LEn_ClrVal(); /* LOW: disable sensor */
     *handled = TRUE;
   } else if (UTIL1_strcmp((char*)cmd, (char*)"dist m on")==0) {
+    DIST_IR_ScanEnable(FALSE); /* otherwise the timer interrupt would turn it off again */
     MEn_SetVal(); /* HIGH: enable sensor */
     *handled = TRUE;
   } else if (UTIL1_strcmp((char*)cmd, (char*)"dist m off")==0) {
     MEn_ClrVal(); /* LOW: disable sensor */
     *handled = TRUE;
   } else if (UTIL1_strcmp((char*)cmd, (char*)"dist r on")==0) {
+    DIST_IR_ScanEnable(FALSE); /* otherwise the timer interrupt would turn it off again */
     REn_SetVal(); /* HIGH: enable sensor */
     *handled = TRUE;
   } else if (UTIL1_strcmp((char*)cmd, (char*)"dist r off")==0) {
@@ -548,25 +686,36 @@ uint8_t DIST_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
     *handled = TRUE;
   } else if (UTIL1_strcmp((char*)cmd, (char*)"dist test")==0) {
     uint8_t i;
-    
+
+    DIST_IR_ScanEnable(TRUE);
     for(i=0;i<10;i++) {
-      LEn_SetVal(); /* HIGH: enable sensor */
       WAIT1_WaitOSms(1000);
       CLS1_SendStr((uint8_t*)"left: ", io->stdOut);
       CLS1_SendNum8u(DIST_GetSensorBitsLeft(), io->stdOut);
-      
-      MEn_SetVal(); /* HIGH: enable sensor */s
-      WAIT1_WaitOSms(1000);
       CLS1_SendStr((uint8_t*)" middle: ", io->stdOut);
       CLS1_SendNum8u(DIST_GetSensorBitsMiddle(), io->stdOut);
-      
-      REn_SetVal(); /* HIGH: enable sensor */
-      WAIT1_WaitOSms(1000);
       CLS1_SendStr((uint8_t*)" right: ", io->stdOut);
       CLS1_SendNum8u(DIST_GetSensorBitsRight(), io->stdOut);
       CLS1_SendStr((uint8_t*)"\r\n", io->stdOut);
     }
     *handled = TRUE;
+#endif
+#if PL_HAS_TOF_SENSOR && TOFH_CONFIG_FAULT_INJECTION
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"dist tof fault ", sizeof("dist tof fault ")-1)==0) {
+    const unsigned char *p;
+    uint8_t dev, nof;
+
+    *handled = TRUE;
+    p = cmd+sizeof("dist tof fault ")-1;
+    if (UTIL1_ScanDecimal8uNumber(&p, &dev)!=ERR_OK || dev>=VL_NOF_DEVICES) {
+      CLS1_SendStr((unsigned char*)"**** error parsing device, must be 0, 1, 2 or 3!\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    if (UTIL1_ScanDecimal8uNumber(&p, &nof)!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"**** error parsing number of faults!\r\n", io->stdErr);
+      return ERR_FAILED;
+    }
+    TOFH_InjectFaults(&ToFDevice[dev], nof); /* e.g. 2: device recovers with retries, 4: device gets re-initialized, 6: bus reset */
 #endif
   }
   return res;
@@ -577,10 +726,7 @@ static uint8_t InitToF(void) {
   uint8_t res;
   int i;
 
-  /* initialize data structure */
-  for(i=0;i<VL_NOF_DEVICES;i++) {
-    ToFDevice[i].mm = 0;
-  }
+  TOFH_Reset(ToFDevice, VL_NOF_DEVICES); /* initialize data structure */
   /* disable all devices (CE pin LOW): we will bring them up later one by one.... */
   for(i=0;i<VL_NOF_DEVICES;i++) {
     (void)VL6180X_ChipEnable(&DIST_ToF_Devices[i], FALSE); /* disable device */
@@ -610,10 +756,49 @@ static uint8_t InitToF(void) {
   return ERR_OK;
 }
 
+static uint8_t ReadToFMultiple(const uint8_t devIdx[], int16_t range[], uint8_t nof) {
+  VL6180X_Device devices[VL_NOF_DEVICES];
+  uint8_t i;
+
+  for(i=0;i<nof;i++) {
+    devices[i] = DIST_ToF_Devices[devIdx[i]];
+  }
+  return VL6180X_ReadRangeSingleMultiple(&devices[0], &range[0], nof)==ERR_OK;
+}
+
+static uint8_t ReadToFDevice(uint8_t dev, int16_t *rangeP) {
+  return VL6180X_ReadRangeSingle(&DIST_ToF_Devices[dev], rangeP)==ERR_OK;
+}
+
+/*!
+ * \brief Re-addresses and re-initializes a single device, while the other devices stay untouched.
+ * Pulling CE low resets the device I2C address. As all other devices are using their own address, the
+ * failing device is the only one on the default address after enabling it again.
+ * \param dev Device index.
+ * \return 1 if the device has been re-initialized, 0 otherwise.
+ */
+static uint8_t ReInitToFDevice(uint8_t dev) {
+  CLS1_SendStr((unsigned char*)"Re-init ToF device: ", SHELL_GetStdio()->stdErr);
+  CLS1_SendNum8u(dev, SHELL_GetStdio()->stdErr);
+  CLS1_SendStr((unsigned char*)"\r\n", SHELL_GetStdio()->stdErr);
+  (void)VL6180X_ChipEnable(&DIST_ToF_Devices[dev], FALSE); /* disable device, this resets the I2C address */
+  vTaskDelay(pdMS_TO_TICKS(DIST_TOF_REINIT_DELAY_MS));
+  (void)VL6180X_ChipEnable(&DIST_ToF_Devices[dev], TRUE); /* enable device, it will be on the default address */
+  vTaskDelay(pdMS_TO_TICKS(DIST_TOF_REINIT_DELAY_MS)); /* give device time to boot */
+  if (VL6180X_SetI2CDeviceAddress(&DIST_ToF_Devices[dev])!=ERR_OK) {
+    return 0;
+  }
+  return VL6180X_InitAndConfigureDevice(&DIST_ToF_Devices[dev])==ERR_OK;
+}
+
+static const TOFH_Bus DIST_ToF_Bus = {
+  .readMultiple = ReadToFMultiple,
+  .readSingle = ReadToFDevice,
+  .reInit = ReInitToFDevice,
+};
+
 static void TofTask(void *param) {
   uint8_t res;
-  int errCntr = 0;
-  int i;
   bool initDevices = TRUE;
 
   (void)param;
@@ -634,46 +819,26 @@ static void TofTask(void *param) {
       CLS1_SendStr((unsigned char*)"ToF enabled!\r\n", SHELL_GetStdio()->stdOut);
       initDevices = FALSE;
     }
-#if 0
-    for(i=0;i<VL_NOF_DEVICES;i++) {
-      int16_t range;
-
-      range = 0;
-      res = VL6180X_ReadRangeSingle(&DIST_ToF_Devices[i], &range);
-      if (res!=ERR_OK) {
-        CLS1_SendStr((unsigned char*)"Read ToF FAILED!\r\n", SHELL_GetStdio()->stdErr);
-        errCntr++;
-        //GI2C1_Deinit(); /* should not be necessary */
-        //GI2C1_Init();
-        initDevices = TRUE; /* re-init devices */
-        range = -3; /* error range */
-      }
-      ToFDevice[i].mm = range;
-    } /* for */
-#else
-    {
-      int16_t range[VL_NOF_DEVICES];
-
-      res = VL6180X_ReadRangeSingleMultiple(&DIST_ToF_Devices[0], &range[0], VL_NOF_DEVICES);
-      if (res!=ERR_OK) {
-        CLS1_SendStr((unsigned char*)"Read ToF FAILED!\r\n", SHELL_GetStdio()->stdErr);
-        errCntr++;
-        initDevices = TRUE; /* re-init devices */
-      }
-      for(i=0;i<VL_NOF_DEVICES;i++) {
-        ToFDevice[i].mm = range[i];
-      }
+    if (!TOFH_Read(ToFDevice, VL_NOF_DEVICES, &DIST_ToF_Bus)) { /* last resort: power cycle all devices */
+      CLS1_SendStr((unsigned char*)"ToF device failed, reset bus!\r\n", SHELL_GetStdio()->stdErr);
+      DIST_ToF_NofBusResets++;
+      initDevices = TRUE;
     }
-#endif
     vTaskDelay(pdMS_TO_TICKS(10));
   }
 }
 #endif /* PL_HAS_TOF_SENSOR */
 
 void DIST_Deinit(void) {
+#if PL_HAS_FRONT_DISTANCE
+  DIST_IR_ScanEnable(FALSE);
+#endif
 }
 
 void DIST_Init(void) {
+#if PL_HAS_FRONT_DISTANCE
+  DIST_IR_ScanEnable(TRUE);
+#endif
 #if PL_HAS_TOF_SENSOR
   if (xTaskCreate(TofTask, "ToF", 1000/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+2, NULL) != pdPASS) {
     for(;;){} /* error */
@@ -34,13 +34,51 @@ bool DIST_10cmRightOn(void);
 #define DIST_IR_LEFT   (1<<2)
 #define DIST_IR_MIDDLE (1<<1)
 #define DIST_IR_RIGHT  (1<<0)
+
+#define DIST_IR_NOF_EMITTERS   3 /* left, middle and right emitter */
+#define DIST_IR_NOF_RECEIVERS  3 /* left, middle and right receiver */
+
+typedef enum {
+  DIST_IR_POS_LEFT = 0,
+  DIST_IR_POS_MIDDLE = 1,
+  DIST_IR_POS_RIGHT = 2
+} DIST_IR_Pos;
+
+typedef struct {
+  uint8_t cnt[DIST_IR_NOF_EMITTERS][DIST_IR_NOF_RECEIVERS]; /*!< number of echo samples for each emitter (first index) and receiver (second index) */
+  uint32_t seq; /*!< sequence number, incremented for each published matrix */
+} DIST_IR_EchoMatrix;
+
 /*!
- * \brief Return front sensor status
+ * \brief Return front sensor status, non-blocking from the latest echo matrix.
  * \return Bit pattern, 0b111 means echo on all sensors, 0b100 only on left, 0b010 only on middle, 0b001 only on right, and so on.
  */
 uint8_t DIST_GetSensorBitsLeft(void);
 uint8_t DIST_GetSensorBitsMiddle(void);
 uint8_t DIST_GetSensorBitsRight(void);
+
+/*!
+ * \brief Returns a copy of the latest complete echo matrix.
+ * \param matrix Where to store the matrix.
+ */
+void DIST_IR_GetEchoMatrix(DIST_IR_EchoMatrix *matrix);
+
+/*!
+ * \brief Enables or disables scanning of the front emitters. Disabling it turns all emitters off.
+ * \param on TRUE to enable scanning, FALSE to disable it.
+ */
+void DIST_IR_ScanEnable(bool on);
+
+/*!
+ * \brief Returns if the front emitters are scanned.
+ * \return TRUE if scanning is enabled.
+ */
+bool DIST_IR_ScanIsEnabled(void);
+
+/*!
+ * \brief Called from the timer interrupt every TMR_TICK_MS: samples the receivers for the current emitter and turns on the next one.
+ */
+void DIST_IR_OnInterrupt(void);
 #endif
 
 uint8_t DIST_SpeedIntoObstacle(int speedL, int speedR);
@@ -13,13 +13,20 @@
 #include "Tacho.h"
 #include "Pid.h"
 #include "Motor.h"
+#include "IntMath.h"
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
 #endif
 #include "Q4CLeft.h"
 #include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
 #include "Shell.h"
 #include "WAIT1.h"
+#if PL_CONFIG_HAS_TRACTION
+  #include "Traction.h"
+#endif
 
 struct {
   DRV_Mode mode;
@@ -33,33 +40,223 @@ struct {
 
 typedef enum {
   DRV_SET_MODE,
-  DRV_SET_SPEED,
-  DRV_SET_POS,
 } DRV_Commands;
 
 typedef struct {
   DRV_Commands cmd;
   union {
     DRV_Mode mode; /* DRV_SET_MODE */
-    struct {
-      int32_t left, right;
-    } speed; /* DRV_SET_SPEED */
-   struct {
-      int32_t left, right;
-    } pos; /* DRV_SET_POS */
   } u;
 } DRV_Command;
 
+#if PL_CONFIG_HAS_TRACTION
+#define DRV_TRACTION_SLEW_LIMIT  0x0400 /* maximum effort change per control cycle while a wheel slips */
+static bool DRV_tractionControl = TRUE; /* if traction control is enabled */
+
+void DRV_SetTractionControl(bool on) {
+  DRV_tractionControl = on;
+  if (!on) {
+    PID_SetSlewLimit(0);
+  }
+}
+
+bool DRV_GetTractionControl(void) {
+  return DRV_tractionControl;
+}
+#endif
+
+/*! \todo adopt the values for your robot */
+#define DRV_CASCADE_MAX_SPEED   2000 /* maximum speed (steps/sec) of the velocity profile in cascaded position mode */
+#define DRV_CASCADE_MAX_ACCEL   8000 /* maximum acceleration (steps/sec^2) of the velocity profile */
+#define DRV_CASCADE_BRAKE_ACCEL (DRV_CASCADE_MAX_ACCEL/2) /* deceleration of the braking curve, leaves margin for the lag of the speed loop */
+#define DRV_CASCADE_KP          10   /* position gain (1/sec) close to the target */
+#define DRV_CASCADE_MIN_SPEED   150  /* minimum speed (steps/sec) outside the margin, so the wheels do not stall in the motor deadband */
+#define DRV_CASCADE_MARGIN      10   /* position in steps within the target is reached in cascaded mode */
+#define DRV_TASK_PERIOD_MS      5    /* period of the drive task */
+
+static bool DRV_posCascaded = FALSE; /* if position mode uses the cascaded position->velocity controller, off until measured on the robot */
+static int32_t DRV_cascadeSpeed[2]; /* velocity setpoints of the profile, left and right */
+
+void DRV_SetPosCascaded(bool on) {
+  DRV_posCascaded = on;
+}
+
+bool DRV_GetPosCascaded(void) {
+  return DRV_posCascaded;
+}
+
+#define DRV_SYNC_KP             20   /* gain (1/sec) from the left/right difference error to the speed correction */
+#define DRV_SYNC_MAX_ERROR      200  /* maximum difference error in steps, limits the windup */
+#define DRV_SYNC_MAX_CORRECTION 400  /* maximum speed correction in steps/sec */
+
+static bool DRV_sync = TRUE; /* if the wheels are cross-coupled */
+static int32_t DRV_syncError; /* left/right difference error, in 1/1000 steps: positive if the left wheel is ahead */
+static Q4CLeft_QuadCntrType DRV_syncLastLeft; /* encoder positions of the last cycle */
+static Q4CRight_QuadCntrType DRV_syncLastRight;
+
+void DRV_SetSync(bool on) {
+  DRV_sync = on;
+}
+
+bool DRV_GetSync(void) {
+  return DRV_sync;
+}
+
+static void SyncReset(void) {
+  DRV_syncError = 0;
+  DRV_syncLastLeft = Q4CLeft_GetPos();
+  DRV_syncLastRight = Q4CRight_GetPos();
+}
+
+/*!
+ * \brief Cross-coupling of the two wheels: compares the left/right encoder difference with the difference of the
+ * speed setpoints, and corrects both setpoints in opposite directions so the heading error goes back to zero.
+ * \param leftP Left speed setpoint, corrected.
+ * \param rightP Right speed setpoint, corrected.
+ */
+static void SyncSpeeds(int32_t *leftP, int32_t *rightP) {
+  Q4CLeft_QuadCntrType left;
+  Q4CRight_QuadCntrType right;
+  int32_t correction;
+
+  left = Q4CLeft_GetPos();
+  right = Q4CRight_GetPos();
+  /* measured minus expected difference in this cycle */
+  DRV_syncError += ((int32_t)(left-DRV_syncLastLeft)-(int32_t)(right-DRV_syncLastRight))*1000
+                  -(*leftP-*rightP)*DRV_TASK_PERIOD_MS;
+  DRV_syncLastLeft = left;
+  DRV_syncLastRight = right;
+  if (!DRV_sync) {
+    DRV_syncError = 0;
+    return;
+  }
+  if (DRV_syncError>DRV_SYNC_MAX_ERROR*1000) {
+    DRV_syncError = DRV_SYNC_MAX_ERROR*1000;
+  } else if (DRV_syncError<-DRV_SYNC_MAX_ERROR*1000) {
+    DRV_syncError = -DRV_SYNC_MAX_ERROR*1000;
+  }
+  correction = (DRV_syncError/1000)*DRV_SYNC_KP;
+  if (correction>DRV_SYNC_MAX_CORRECTION) {
+    correction = DRV_SYNC_MAX_CORRECTION;
+  } else if (correction<-DRV_SYNC_MAX_CORRECTION) {
+    correction = -DRV_SYNC_MAX_CORRECTION;
+  }
+  *leftP -= correction; /* slow down the wheel which is ahead, speed up the other one */
+  *rightP += correction;
+}
+
+/*!
+ * \brief Outer position loop of the cascaded position mode: computes the velocity setpoint for the speed PID.
+ * The velocity is limited by the maximum speed, by the speed from which the wheel can still brake to the target
+ * (braking curve), and close to the target by a proportional gain, but not below the minimum speed
+ * which overcomes the motor deadband. The change of the velocity is limited by the maximum acceleration.
+ * \param currPos Current position of the wheel.
+ * \param setPos Target position of the wheel.
+ * \param idx 0 for the left wheel, 1 for the right wheel.
+ * \return Velocity setpoint in steps/sec.
+ */
+static int32_t CascadeSpeed(int32_t currPos, int32_t setPos, int idx) {
+  int32_t error, absError, speed, brakeSpeed, maxDelta;
+
+  error = setPos-currPos;
+  absError = IMATH_Abs32(error);
+  if (absError<=DRV_CASCADE_MARGIN/2) {
+    speed = 0; /* avoid jitter around the target */
+  } else {
+    brakeSpeed = IMATH_Sqrt32(2*DRV_CASCADE_BRAKE_ACCEL*(absError>100000?100000:absError)); /* v = sqrt(2*a*s), limited to avoid overflow */
+    speed = absError*DRV_CASCADE_KP;
+    if (speed>brakeSpeed) {
+      speed = brakeSpeed;
+    }
+    if (speed>DRV_CASCADE_MAX_SPEED) {
+      speed = DRV_CASCADE_MAX_SPEED;
+    }
+    if (speed<DRV_CASCADE_MIN_SPEED) {
+      speed = DRV_CASCADE_MIN_SPEED; /* keep moving until the target is reached */
+    }
+    if (error<0) {
+      speed = -speed;
+    }
+  }
+  maxDelta = (DRV_CASCADE_MAX_ACCEL*DRV_TASK_PERIOD_MS)/1000;
+  if (speed>DRV_cascadeSpeed[idx]+maxDelta) {
+    speed = DRV_cascadeSpeed[idx]+maxDelta;
+  } else if (speed<DRV_cascadeSpeed[idx]-maxDelta) {
+    speed = DRV_cascadeSpeed[idx]-maxDelta;
+  }
+  DRV_cascadeSpeed[idx] = speed;
+  return speed;
+}
+
 #define QUEUE_LENGTH      4 /* number of items in queue, that's my buffer size */
 #define QUEUE_ITEM_SIZE   sizeof(DRV_Command) /* each item is a single drive command */
-static xQueueHandle DRV_Queue;
+static xQueueHandle DRV_Queue; /* queue for mode changes, setpoints are passed with the mailboxes below */
+
+typedef struct {
+  int32_t left, right;
+} DRV_Setpoint;
+
+/*!
+ * Mailbox for speed or position setpoints: a new setpoint overwrites the previous one,
+ * and the drive task always uses the latest value. The poster fills the buffer which is not
+ * published and then increments the sequence counter, which selects the published buffer.
+ */
+typedef struct {
+  volatile DRV_Setpoint buf[2]; /* double buffer, buf[seq&1] is the latest setpoint */
+  volatile uint32_t seq; /* sequence counter, incremented with each setpoint */
+} DRV_Mailbox;
+
+static DRV_Mailbox DRV_SpeedMailbox, DRV_PosMailbox;
+static volatile uint32_t DRV_SpeedSeqUsed, DRV_PosSeqUsed; /* sequence number of the setpoint used by the drive task */
+
+static void PostSetpoint(DRV_Mailbox *mb, int32_t left, int32_t right) {
+  uint32_t seq;
+
+  /* the critical section only serializes multiple posters, it never waits for the drive task */
+  FRTOS1_taskENTER_CRITICAL();
+  seq = mb->seq+1;
+  mb->buf[seq&1].left = left;
+  mb->buf[seq&1].right = right;
+  mb->seq = seq; /* publish it */
+  FRTOS1_taskEXIT_CRITICAL();
+}
+
+static bool FetchSetpoint(DRV_Mailbox *mb, volatile uint32_t *usedSeq, DRV_Setpoint *setpoint) {
+  uint32_t seq;
+
+  do {
+    seq = mb->seq;
+    if (seq==*usedSeq) {
+      return FALSE; /* nothing new */
+    }
+    setpoint->left = mb->buf[seq&1].left;
+    setpoint->right = mb->buf[seq&1].right;
+  } while (seq!=mb->seq); /* posted twice while copying it: buffer might have been overwritten, try again */
+  *usedSeq = seq;
+  return TRUE;
+}
+
+static bool IsCmdPending(void) {
+  return FRTOS1_uxQueueMessagesWaiting(DRV_Queue)>0
+      || DRV_SpeedMailbox.seq!=DRV_SpeedSeqUsed
+      || DRV_PosMailbox.seq!=DRV_PosSeqUsed;
+}
+
+#define DRV_NOF_WAITERS  4 /* number of tasks which can wait for a drive condition at the same time */
+typedef struct {
+  TaskHandle_t task; /* registered task, NULL if entry is not used */
+  DRV_WaitCondition cond; /* condition the task is waiting for */
+  bool pending; /* condition not met yet */
+  xSemaphoreHandle sem; /* given by the drive task as soon as the condition is met */
+} DRV_Waiter;
+static DRV_Waiter DRV_Waiters[DRV_NOF_WAITERS];
 
 bool DRV_IsStopped(void) {
   Q4CLeft_QuadCntrType leftPos;
   Q4CRight_QuadCntrType rightPos;
 
-  if (FRTOS1_uxQueueMessagesWaiting(DRV_Queue)>0) {
-    return FALSE; /* still messages in command queue, so there is something pending */
+  if (IsCmdPending()) {
+    return FALSE; /* still commands or setpoints not used, so there is something pending */
   }
   /* do *not* use/calculate speed: too slow! Use position encoder instead */
   leftPos = Q4CLeft_GetPos();
@@ -82,19 +279,120 @@ bool DRV_IsStopped(void) {
 
 uint8_t DRV_Stop(int32_t timeoutMs) {
   DRV_SetMode(DRV_MODE_STOP); /* stop it */
-  do {
-    if (DRV_IsStopped()) {
+  return DRV_WaitFor(DRV_WAIT_STOPPED, timeoutMs);
+}
+
+static DRV_Waiter *FindWaiter(TaskHandle_t task) {
+  int i;
+
+  for(i=0;i<DRV_NOF_WAITERS;i++) {
+    if (DRV_Waiters[i].task==task) {
+      return &DRV_Waiters[i];
+    }
+  }
+  return NULL;
+}
+
+uint8_t DRV_WaitRegister(DRV_WaitCondition cond) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  DRV_Waiter *free = NULL;
+  int i;
+
+  FRTOS1_taskENTER_CRITICAL();
+  for(i=0;i<DRV_NOF_WAITERS;i++) {
+    if (DRV_Waiters[i].task==self) {
+      free = &DRV_Waiters[i]; /* already registered: reuse entry */
       break;
     }
-    WAIT1_WaitOSms(5);
-    timeoutMs -= 5;
-  } while (timeoutMs>0);
-  if (timeoutMs<0) {
-    return ERR_BUSY; /* timeout */
+    if (free==NULL && DRV_Waiters[i].task==NULL) {
+      free = &DRV_Waiters[i];
+    }
+  }
+  if (free!=NULL) {
+    free->pending = FALSE; /* drive task shall not give the semaphore until it is set up */
+    free->task = self;
+  }
+  FRTOS1_taskEXIT_CRITICAL();
+  if (free==NULL) {
+    return ERR_OVERFLOW;
   }
+  /* remove a completion of a previous wait which came in after its timeout */
+  (void)FRTOS1_xSemaphoreTake(free->sem, 0);
+  FRTOS1_taskENTER_CRITICAL();
+  free->cond = cond;
+  free->pending = TRUE;
+  FRTOS1_taskEXIT_CRITICAL();
   return ERR_OK;
 }
 
+void DRV_WaitUnregister(void) {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  int i;
+
+  FRTOS1_taskENTER_CRITICAL();
+  for(i=0;i<DRV_NOF_WAITERS;i++) {
+    if (DRV_Waiters[i].task==self) {
+      DRV_Waiters[i].pending = FALSE;
+      DRV_Waiters[i].task = NULL;
+    }
+  }
+  FRTOS1_taskEXIT_CRITICAL();
+}
+
+uint8_t DRV_WaitCompletion(int32_t timeoutMs) {
+  DRV_Waiter *waiter;
+
+  waiter = FindWaiter(xTaskGetCurrentTaskHandle()); /* entry is only changed by the task itself */
+  if (waiter==NULL) {
+    return ERR_FAILED; /* not registered */
+  }
+  if (timeoutMs<0) {
+    timeoutMs = 0;
+  }
+  if (FRTOS1_xSemaphoreTake(waiter->sem, timeoutMs/portTICK_PERIOD_MS)==pdTRUE) {
+    return ERR_OK;
+  }
+  return ERR_BUSY; /* timeout */
+}
+
+uint8_t DRV_WaitFor(DRV_WaitCondition cond, int32_t timeoutMs) {
+  uint8_t res;
+
+  res = DRV_WaitRegister(cond);
+  if (res!=ERR_OK) {
+    return res;
+  }
+  res = DRV_WaitCompletion(timeoutMs);
+  DRV_WaitUnregister();
+  return res;
+}
+
+/* called by the drive task after each control cycle: gives the semaphore of the tasks for which the condition is met */
+static void NotifyWaiters(void) {
+  bool done, give;
+  int i;
+
+  for(i=0;i<DRV_NOF_WAITERS;i++) {
+    if (!DRV_Waiters[i].pending) {
+      continue;
+    }
+    if (DRV_Waiters[i].cond==DRV_WAIT_STOPPED) {
+      done = DRV_IsStopped();
+    } else {
+      done = DRV_HasTurned();
+    }
+    if (done) {
+      FRTOS1_taskENTER_CRITICAL();
+      give = DRV_Waiters[i].pending; /* might have been unregistered in the meantime */
+      DRV_Waiters[i].pending = FALSE;
+      FRTOS1_taskEXIT_CRITICAL();
+      if (give) {
+        (void)FRTOS1_xSemaphoreGive(DRV_Waiters[i].sem);
+      }
+    }
+  }
+}
+
 bool DRV_IsDrivingBackward(void) {
   return DRV_Status.mode==DRV_MODE_SPEED
       && DRV_Status.speed.left<0
@@ -103,14 +401,16 @@ bool DRV_IsDrivingBackward(void) {
 
 static bool match(int32_t pos, int32_t target) {
   #define MATCH_MARGIN  100
-  return (pos>=target-MATCH_MARGIN && pos<=target+MATCH_MARGIN);
+  int32_t margin = DRV_posCascaded?DRV_CASCADE_MARGIN:MATCH_MARGIN; /* cascaded mode settles within a few steps */
+
+  return (pos>=target-margin && pos<=target+margin);
 }
 
 bool DRV_HasTurned(void) {
   int32_t pos;
 
-  if (FRTOS1_uxQueueMessagesWaiting(DRV_Queue)>0) {
-    return FALSE; /* still messages in command queue, so there is something pending */
+  if (IsCmdPending()) {
+    return FALSE; /* still commands or setpoints not used, so there is something pending */
   }
   if (DRV_Status.mode==DRV_MODE_POS) {
     #define DRV_TURN_SPEED_LOW 200
@@ -149,28 +449,12 @@ uint8_t DRV_SetMode(DRV_Mode mode) {
 }
 
 uint8_t DRV_SetSpeed(int32_t left, int32_t right) {
-  DRV_Command cmd;
-
-  cmd.cmd = DRV_SET_SPEED;
-  cmd.u.speed.left = left;
-  cmd.u.speed.right = right;
-  if (FRTOS1_xQueueSendToBack(DRV_Queue, &cmd, portMAX_DELAY)!=pdPASS) {
-    return ERR_FAILED;
-  }
-  FRTOS1_taskYIELD(); /* yield so drive task has a chance to read message */
+  PostSetpoint(&DRV_SpeedMailbox, left, right); /* does not block, overwrites a setpoint not used yet */
   return ERR_OK;
 }
 
 uint8_t DRV_SetPos(int32_t left, int32_t right) {
-  DRV_Command cmd;
-
-  cmd.cmd = DRV_SET_POS;
-  cmd.u.pos.left = left;
-  cmd.u.pos.right = right;
-  if (FRTOS1_xQueueSendToBack(DRV_Queue, &cmd, portMAX_DELAY)!=pdPASS) {
-    return ERR_FAILED;
-  }
-  FRTOS1_taskYIELD(); /* yield so drive task has a chance to read message */
+  PostSetpoint(&DRV_PosMailbox, left, right); /* does not block, overwrites a setpoint not used yet */
   return ERR_OK;
 }
 
@@ -192,6 +476,11 @@ static void DRV_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"  speed <left> <right>", (unsigned char*)"Move left and right motors with given speed\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  pos <left> <right>", (unsigned char*)"Move left and right wheels to given position\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  pos reset", (unsigned char*)"Reset drive and wheel position\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  sync (on|off)", (unsigned char*)"Cross-couple the wheels to keep the heading\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  cascade (on|off)", (unsigned char*)"Position mode with position loop feeding the speed loop\r\n", io->stdOut);
+#if PL_CONFIG_HAS_TRACTION
+  CLS1_SendHelpStr((unsigned char*)"  traction (on|off)", (unsigned char*)"Limit the motor effort slew rate while a wheel slips\r\n", io->stdOut);
+#endif
 }
 
 static void DRV_PrintStatus(const CLS1_StdIOType *io) {
@@ -225,6 +514,15 @@ static void DRV_PrintStatus(const CLS1_StdIOType *io) {
   UTIL1_strcatNum32s(buf, sizeof(buf), (int32_t)Q4CRight_GetPos());
   UTIL1_strcat(buf, sizeof(buf), (unsigned char*)")\r\n");
   CLS1_SendStatusStr((unsigned char*)"  pos right", buf, io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), DRV_sync?(unsigned char*)"on":(unsigned char*)"off");
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", error ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), DRV_syncError/1000);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  sync", buf, io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  cascade", DRV_posCascaded?(unsigned char*)"on\r\n":(unsigned char*)"off\r\n", io->stdOut);
+#if PL_CONFIG_HAS_TRACTION
+  CLS1_SendStatusStr((unsigned char*)"  traction", DRV_tractionControl?(unsigned char*)"on\r\n":(unsigned char*)"off\r\n", io->stdOut);
+#endif
 }
 
 uint8_t DRV_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
@@ -275,6 +573,26 @@ uint8_t DRV_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_Std
       CLS1_SendStr((unsigned char*)"Wrong argument(s)\r\n", io->stdErr);
       res = ERR_FAILED;
     }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"drive sync on")==0) {
+    DRV_SetSync(TRUE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"drive sync off")==0) {
+    DRV_SetSync(FALSE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"drive cascade on")==0) {
+    DRV_SetPosCascaded(TRUE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"drive cascade off")==0) {
+    DRV_SetPosCascaded(FALSE);
+    *handled = TRUE;
+#if PL_CONFIG_HAS_TRACTION
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"drive traction on")==0) {
+    DRV_SetTractionControl(TRUE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"drive traction off")==0) {
+    DRV_SetTractionControl(FALSE);
+    *handled = TRUE;
+#endif
   } else if (UTIL1_strncmp((char*)cmd, (char*)"drive mode ", sizeof("drive mode ")-1)==0) {
     p = cmd+sizeof("drive mode");
     if (UTIL1_strcmp((char*)p, (char*)"none")==0) {
@@ -318,53 +636,103 @@ static uint8_t GetCmd(void) {
   if (cmd.cmd==DRV_SET_MODE) {
     PID_Start(); /* reset PID, especially integral counters */
     DRV_Status.mode = cmd.u.mode;
-  } else if (cmd.cmd==DRV_SET_SPEED) {
-    DRV_Status.speed.left = cmd.u.speed.left;
-    DRV_Status.speed.right = cmd.u.speed.right;
-  } else if (cmd.cmd==DRV_SET_POS) {
-    DRV_Status.pos.left = cmd.u.pos.left;
-    DRV_Status.pos.right = cmd.u.pos.right;
+    DRV_cascadeSpeed[0] = TACHO_GetSpeed(TRUE); /* profile starts with the current speed */
+    DRV_cascadeSpeed[1] = TACHO_GetSpeed(FALSE);
+    SyncReset();
   }
   FRTOS1_taskEXIT_CRITICAL();
   return ERR_OK;
 }
 
+static void GetSetpoints(void) {
+  DRV_Setpoint setpoint;
+
+  if (FetchSetpoint(&DRV_SpeedMailbox, &DRV_SpeedSeqUsed, &setpoint)) {
+    FRTOS1_taskENTER_CRITICAL();
+    DRV_Status.speed.left = setpoint.left;
+    DRV_Status.speed.right = setpoint.right;
+    FRTOS1_taskEXIT_CRITICAL();
+  }
+  if (FetchSetpoint(&DRV_PosMailbox, &DRV_PosSeqUsed, &setpoint)) {
+    FRTOS1_taskENTER_CRITICAL();
+    DRV_Status.pos.left = setpoint.left;
+    DRV_Status.pos.right = setpoint.right;
+    FRTOS1_taskEXIT_CRITICAL();
+  }
+}
+
 static void DriveTask(void *pvParameters) {
   portTickType xLastWakeTime;
+  int32_t speedL, speedR;
 
   (void)pvParameters;
   xLastWakeTime = xTaskGetTickCount();
   for(;;) {
     while (GetCmd()==ERR_OK) { /* returns ERR_RXEMPTY if queue is empty */
-      /* process incoming commands */
+      /* process incoming mode changes */
     }
+    GetSetpoints(); /* use latest speed and position setpoints */
     TACHO_CalcSpeed();
     if (DRV_Status.mode==DRV_MODE_SPEED) {
-      PID_Speed(TACHO_GetSpeed(TRUE), DRV_Status.speed.left, TRUE);
-      PID_Speed(TACHO_GetSpeed(FALSE), DRV_Status.speed.right, FALSE);
+      speedL = DRV_Status.speed.left;
+      speedR = DRV_Status.speed.right;
+      SyncSpeeds(&speedL, &speedR);
+      PID_Speed(TACHO_GetSpeed(TRUE), speedL, TRUE);
+      PID_Speed(TACHO_GetSpeed(FALSE), speedR, FALSE);
     } else if (DRV_Status.mode==DRV_MODE_STOP) {
       PID_Speed(TACHO_GetSpeed(TRUE), 0, TRUE);
       PID_Speed(TACHO_GetSpeed(FALSE), 0, FALSE);
+    } else if (DRV_Status.mode==DRV_MODE_POS && DRV_posCascaded) {
+      speedL = CascadeSpeed((int32_t)Q4CLeft_GetPos(), DRV_Status.pos.left, 0);
+      speedR = CascadeSpeed((int32_t)Q4CRight_GetPos(), DRV_Status.pos.right, 1);
+      SyncSpeeds(&speedL, &speedR);
+      PID_Speed(TACHO_GetSpeed(TRUE), speedL, TRUE);
+      PID_Speed(TACHO_GetSpeed(FALSE), speedR, FALSE);
     } else if (DRV_Status.mode==DRV_MODE_POS) {
       PID_Pos(Q4CLeft_GetPos(), DRV_Status.pos.left, TRUE);
       PID_Pos(Q4CRight_GetPos(), DRV_Status.pos.right, FALSE);
     } else if (DRV_Status.mode==DRV_MODE_NONE) {
       /* do nothing */
     }
-    FRTOS1_vTaskDelayUntil(&xLastWakeTime, 5/portTICK_PERIOD_MS);
+#if PL_CONFIG_HAS_TRACTION
+    if (TRAC_Update(DRV_Status.mode==DRV_MODE_SPEED || DRV_Status.mode==DRV_MODE_POS)==TRAC_STATE_SLIP && DRV_tractionControl) {
+      PID_SetSlewLimit(DRV_TRACTION_SLEW_LIMIT); /* ramp the effort slowly until the wheels have grip again */
+    } else {
+      PID_SetSlewLimit(0);
+    }
+#endif
+    NotifyWaiters();
+    FRTOS1_vTaskDelayUntil(&xLastWakeTime, DRV_TASK_PERIOD_MS/portTICK_PERIOD_MS);
   } /* for */
 }
 
 void DRV_Deinit(void) {
+  int i;
+
+  for(i=0;i<DRV_NOF_WAITERS;i++) {
+    FRTOS1_vSemaphoreDelete(DRV_Waiters[i].sem);
+  }
   FRTOS1_vQueueDelete(DRV_Queue);
 }
 
 void DRV_Init(void) {
+  int i;
+
   DRV_Status.mode = DRV_MODE_NONE;
   DRV_Status.speed.left = 0;
   DRV_Status.speed.right = 0;
   DRV_Status.pos.left = 0;
   DRV_Status.pos.right = 0;
+  DRV_SpeedMailbox.seq = DRV_SpeedSeqUsed = 0;
+  DRV_PosMailbox.seq = DRV_PosSeqUsed = 0;
+  for(i=0;i<DRV_NOF_WAITERS;i++) {
+    DRV_Waiters[i].task = NULL;
+    DRV_Waiters[i].pending = FALSE;
+    DRV_Waiters[i].sem = xSemaphoreCreateBinary(); /* created empty */
+    if (DRV_Waiters[i].sem==NULL) {
+      for(;;){} /* out of memory? */
+    }
+  }
   DRV_Queue = FRTOS1_xQueueCreate(QUEUE_LENGTH, QUEUE_ITEM_SIZE);
   if (DRV_Queue==NULL) {
     for(;;){} /* out of memory? */
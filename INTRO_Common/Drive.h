@@ -40,6 +40,80 @@ DRV_Mode DRV_GetMode(void);
 bool DRV_IsStopped(void);
 bool DRV_HasTurned(void);
 
+/*!
+ * \brief Enables or disables the cross-coupling of the wheels: in speed and cascaded position mode, the difference
+ * of the wheel encoders is compared with the difference of the setpoints, and both setpoints are corrected
+ * to keep the heading, e.g. to drive straight without sensors.
+ * \param on TRUE to enable the cross-coupling.
+ */
+void DRV_SetSync(bool on);
+
+/*!
+ * \brief Returns if the wheels are cross-coupled.
+ * \return TRUE if cross-coupling is enabled.
+ */
+bool DRV_GetSync(void);
+
+/*!
+ * \brief Selects the position controller: cascaded, the position loop creates a velocity profile (with acceleration
+ * limits) for the speed PID, otherwise (default) the position PID sets the motor effort directly.
+ * \param on TRUE for the cascaded position controller.
+ */
+void DRV_SetPosCascaded(bool on);
+
+/*!
+ * \brief Returns if the cascaded position controller is used.
+ * \return TRUE if position mode is cascaded.
+ */
+bool DRV_GetPosCascaded(void);
+
+#if PL_CONFIG_HAS_TRACTION
+/*!
+ * \brief Enables or disables traction control: while a wheel slips, the change of the motor effort is limited.
+ * \param on TRUE to enable traction control, FALSE to disable it.
+ */
+void DRV_SetTractionControl(bool on);
+
+/*!
+ * \brief Returns if traction control is enabled.
+ * \return TRUE if traction control is enabled.
+ */
+bool DRV_GetTractionControl(void);
+#endif
+
+typedef enum {
+  DRV_WAIT_STOPPED,        /*!< robot has stopped, or reached the position in position mode, see DRV_IsStopped() */
+  DRV_WAIT_TARGET_REACHED, /*!< position target reached, see DRV_HasTurned() */
+} DRV_WaitCondition;
+
+/*!
+ * \brief Registers the calling task to be signaled by the drive task as soon as the condition is met.
+ * The drive task uses a semaphore of its own, the task notification of the calling task is not touched.
+ * \param cond Condition to wait for.
+ * \return ERR_OK if registered, ERR_OVERFLOW if there are too many waiting tasks.
+ */
+uint8_t DRV_WaitRegister(DRV_WaitCondition cond);
+
+/*!
+ * \brief Removes the registration of the calling task.
+ */
+void DRV_WaitUnregister(void);
+
+/*!
+ * \brief Blocks the calling task until the registered condition is met.
+ * \param timeoutMs Timeout in milliseconds, 0 only checks if the condition has been met.
+ * \return ERR_OK if the condition has been met, ERR_BUSY for timeout condition, ERR_FAILED if the task is not registered.
+ */
+uint8_t DRV_WaitCompletion(int32_t timeoutMs);
+
+/*!
+ * \brief Waits until the condition is met: registers the calling task, waits for the completion and removes the registration.
+ * \param cond Condition to wait for.
+ * \param timeoutMs Timeout in milliseconds.
+ * \return ERR_OK if the condition has been met, ERR_BUSY for timeout condition, ERR_OVERFLOW if there are too many waiting tasks.
+ */
+uint8_t DRV_WaitFor(DRV_WaitCondition cond, int32_t timeoutMs);
+
 /*!
  * \brief Stops the engines
  * \param timoutMs timout in milliseconds for operation
@@ -54,6 +54,17 @@ typedef enum EVNT_Handle {
   EVNT_SW7_RELEASED,
   EVNT_SW7_LPRESSED,
   #endif
+#endif
+#if PL_CONFIG_HAS_BATTERY_ADC
+  EVNT_BATT_LOW,          /*!< battery voltage is low, motor supply compensation is derated */
+  EVNT_BATT_CRITICAL,     /*!< battery voltage is critical, motor power is reduced */
+  EVNT_BATT_OK,           /*!< battery voltage is back to normal */
+#endif
+#if PL_CONFIG_HAS_TRACTION
+  EVNT_TRAC_GRIP,         /*!< wheels have grip again */
+  EVNT_TRAC_SLIP,         /*!< a wheel slips */
+  EVNT_TRAC_PUSH,         /*!< robot has contact and is pushing */
+  EVNT_TRAC_STALL,        /*!< a wheel is stalled */
 #endif
   /*!< \todo Your extra events here */
   EVNT_NOF_EVENTS       /*!< Must be last one! */
@@ -0,0 +1,86 @@
+/**
+ * \file
+ * \brief Integer math helpers.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Hardware independent, so it can be compiled for the host too (see INTRO_HostTest).
+ */
+
+#include "IntMath.h"
+#include <stddef.h> /* NULL */
+
+int32_t IMATH_Abs32(int32_t val) {
+  return val<0?-val:val;
+}
+
+int32_t IMATH_Sqrt32(int32_t val) {
+  int32_t res = 0, bit = 1L<<30;
+
+  if (val<=0) {
+    return 0;
+  }
+  while (bit>val) {
+    bit >>= 2;
+  }
+  while (bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return res;
+}
+
+uint32_t IMATH_Sqrt64(uint64_t val) {
+  uint64_t res = 0, bit = 1ULL<<62;
+
+  while (bit>val) {
+    bit >>= 2;
+  }
+  while (bit!=0) {
+    if (val>=res+bit) {
+      val -= res+bit;
+      res = (res>>1)+bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)res;
+}
+
+uint8_t IMATH_FitLine(const int32_t *pos, uint8_t nofPos, int32_t *slopeQ8, int32_t *residualQ8) {
+  int64_t n, sk, skk, sp, skp, den, slope, intercept, dev, sum;
+  int i;
+
+  if (nofPos<2) {
+    return 0;
+  }
+  n = nofPos;
+  sk = skk = sp = skp = 0;
+  for(i=0;i<nofPos;i++) {
+    sk += i;
+    skk += i*i;
+    sp += pos[i];
+    skp += (int64_t)i*pos[i];
+  }
+  den = n*skk-sk*sk;
+  slope = ((n*skp-sk*sp)*256)/den;
+  if (slope<=0) {
+    return 0; /* positions do not increase */
+  }
+  intercept = (sp*256-slope*sk)/n;
+  *slopeQ8 = (int32_t)slope;
+  if (residualQ8!=NULL) {
+    sum = 0;
+    for(i=0;i<nofPos;i++) {
+      dev = (int64_t)pos[i]*256-(intercept+slope*i);
+      sum += dev*dev;
+    }
+    *residualQ8 = (int32_t)IMATH_Sqrt64((uint64_t)(sum/n));
+  }
+  return 1;
+}
@@ -0,0 +1,47 @@
+/**
+ * \file
+ * \brief Interface to the integer math helpers.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Small integer routines shared by the odometry, drive, maze, calibration and line following modules, so they do
+ * not need floating point. It does not use any hardware or RTOS, so it is checked on the host in INTRO_HostTest.
+ */
+
+#ifndef INTMATH_H_
+#define INTMATH_H_
+
+#include <stdint.h>
+
+/*!
+ * \brief Absolute value.
+ * \param val Value, INT32_MIN is not supported.
+ * \return Absolute value of val.
+ */
+int32_t IMATH_Abs32(int32_t val);
+
+/*!
+ * \brief Integer square root.
+ * \param val Value.
+ * \return Square root of val, rounded down, or 0 if val is not positive.
+ */
+int32_t IMATH_Sqrt32(int32_t val);
+
+/*!
+ * \brief Integer square root of a 64bit value, e.g. a sum of squares.
+ * \param val Value.
+ * \return Square root of val, rounded down.
+ */
+uint32_t IMATH_Sqrt64(uint64_t val);
+
+/*!
+ * \brief Fits a straight line through equally spaced measurements (least squares), e.g. the encoder steps at
+ * line crossings during a calibration.
+ * \param pos Measured positions, one for each event, the events are equally spaced.
+ * \param nofPos Number of measurements, at least 2.
+ * \param slopeQ8 Where to store the increase between two events, as Q8 (256 is one step).
+ * \param residualQ8 Where to store the RMS deviation of the measurements from the line, as Q8, or NULL.
+ * \return 1 if the fit is valid, 0 if there are too few measurements or the positions do not increase.
+ */
+uint8_t IMATH_FitLine(const int32_t *pos, uint8_t nofPos, int32_t *slopeQ8, int32_t *residualQ8);
+
+#endif /* INTMATH_H_ */
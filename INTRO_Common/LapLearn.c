@@ -0,0 +1,503 @@
+/**
+ * \file
+ * \brief Lap learning.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * On the first lap, the course is recorded as a sequence of segments with length and heading change from the
+ * odometry. A segment ends at a marker or intersection seen by the line sensor, or where the course changes
+ * between straight and bend. The lap ends when the start line is crossed again close to where the lap has started.
+ * On the following laps, the position on the course is the driven distance along the segments, and it is aligned
+ * with the map at each marker and intersection. Each segment has a speed, from its curvature after the first lap,
+ * and the line following speed is limited to the speed of the current segment and to the braking curve to the next
+ * slower segments. After each lap, the speed of a segment is lowered if the robot has nearly lost the line on it,
+ * and raised if it stayed close to the line.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LAP_LEARN
+#include "LapLearn.h"
+#include "Reflectance.h"
+#include "Odometry.h"
+#include "IntMath.h"
+#include "Pid.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#include "Shell.h"
+#if PL_CONFIG_HAS_RADIO
+  #include "RNet_App.h"
+  #include "RNet_AppConfig.h"
+#endif
+
+/*! \todo adopt the values to your robot and course */
+#define LAP_MAX_SEGMENTS      64   /* maximum number of segments of a lap */
+#define LAP_SAMPLE_MM         20   /* distance between two heading samples */
+#define LAP_BEND_HEADING      15   /* heading change in 0.1 degree over LAP_SAMPLE_MM to be a bend */
+#define LAP_MIN_SEGMENT_MM    60   /* segments are not split between straight and bend below this length */
+#define LAP_EVENT_MIN_MM      30   /* minimum distance between two markers or intersections */
+#define LAP_MIN_LAP_MM        1000 /* minimum length of a lap */
+#define LAP_CLOSE_MM          150  /* start line is within this distance of the lap start */
+#define LAP_SEARCH_SEGMENTS   8    /* markers are searched in this number of segments ahead */
+#define LAP_CURV_FULL         6000 /* curvature in 0.1 degree per m for the minimum speed */
+#define LAP_MIN_SPEED         40   /* speed in the sharpest bends, percent */
+#define LAP_DECEL             20   /* braking, in percent^2 per mm: (v^2-v0^2)/(2*distance) */
+#define LAP_LOOKAHEAD_MM      600  /* distance checked ahead for slower segments */
+#define LAP_ERROR_HIGH        50   /* line error in percent: robot nearly lost the line, segment is too fast */
+#define LAP_ERROR_LOW         20   /* line error in percent: robot stayed on the line, segment can be faster */
+#define LAP_SPEED_DOWN        10   /* speed reduction of a too fast segment, percent */
+#define LAP_SPEED_UP          5    /* speed increase of a good segment, percent */
+
+typedef enum {
+  LAP_EVENT_NONE,  /* segment ends because of a change between straight and bend */
+  LAP_EVENT_LEFT,  /* marker or intersection on the left side */
+  LAP_EVENT_RIGHT, /* marker or intersection on the right side */
+  LAP_EVENT_CROSS, /* line across the course */
+  LAP_EVENT_START  /* start line, end of the lap */
+} LAP_Event;
+
+typedef enum {
+  LAP_STATE_OFF,        /* not active */
+  LAP_STATE_WAIT_START, /* waiting for the start line */
+  LAP_STATE_LEARN,      /* first lap, recording the course */
+  LAP_STATE_RUN         /* following laps, driving the speed profile */
+} LAP_State;
+
+typedef struct {
+  uint16_t lengthMm; /* length of the segment */
+  int16_t heading; /* heading change over the segment, in 0.1 degree, counter clockwise positive */
+  uint8_t event; /* LAP_Event at the end of the segment */
+  uint8_t speed; /* speed on this segment, percent */
+  uint8_t maxError; /* maximum line error on the current lap, percent */
+} LAP_Segment;
+
+static LAP_Segment LAP_segments[LAP_MAX_SEGMENTS];
+static uint8_t LAP_nofSegments = 0; /* number of segments, 0 if no course has been learned */
+static volatile LAP_State LAP_state = LAP_STATE_OFF;
+static bool LAP_isLearned = FALSE; /* if LAP_segments contains a complete lap */
+
+/* position */
+static int32_t LAP_lastLeft, LAP_lastRight; /* encoder positions of the last sample */
+static int32_t LAP_steps; /* driven steps since the start */
+static int32_t LAP_segStartMm; /* driven distance at the start of the current segment */
+static uint8_t LAP_segIdx; /* current segment */
+/* learning */
+static int32_t LAP_sampleMm; /* driven distance of the last heading sample */
+static int16_t LAP_sampleHeading; /* heading at the last sample */
+static int32_t LAP_segHeading; /* heading change of the current segment */
+static bool LAP_segIsBend; /* if the current segment is a bend */
+static int32_t LAP_startX, LAP_startY; /* position of the start line */
+/* events */
+static bool LAP_inEvent; /* if the sensors are on a marker */
+static LAP_Event LAP_eventKind; /* kind of the current marker */
+static int32_t LAP_eventMm; /* distance at the start of the current marker */
+static int32_t LAP_lastEventMm; /* distance of the last reported marker */
+/* lap times */
+static TickType_t LAP_lapStartTicks;
+static uint16_t LAP_lapCount; /* number of completed laps */
+static uint32_t LAP_lastLapMs, LAP_bestLapMs;
+
+static int16_t Heading(void) {
+  ODO_Pose pose;
+
+  ODO_GetPose(&pose, NULL);
+  return pose.heading;
+}
+
+/* heading difference in 0.1 degree, wrapped to -1800..1799 */
+static int32_t HeadingDiff(int16_t to, int16_t from) {
+  int32_t diff;
+
+  diff = (int32_t)to-from;
+  if (diff>=1800) {
+    diff -= 3600;
+  } else if (diff<-1800) {
+    diff += 3600;
+  }
+  return diff;
+}
+
+static uint8_t SegmentSpeed(const LAP_Segment *seg) {
+  int32_t curv, speed;
+
+  if (seg->lengthMm==0) {
+    return 100;
+  }
+  curv = (IMATH_Abs32(seg->heading)*1000)/seg->lengthMm; /* 0.1 degree per m */
+  if (curv>LAP_CURV_FULL) {
+    curv = LAP_CURV_FULL;
+  }
+  speed = 100-((100-LAP_MIN_SPEED)*curv)/LAP_CURV_FULL;
+  return (uint8_t)speed;
+}
+
+static void CloseSegment(int32_t endMm, LAP_Event event) {
+  LAP_Segment *seg;
+
+  if (LAP_nofSegments>=LAP_MAX_SEGMENTS) {
+    LAP_segments[LAP_MAX_SEGMENTS-1].event = (uint8_t)event; /* no space: extend the last one */
+    return;
+  }
+  seg = &LAP_segments[LAP_nofSegments];
+  seg->lengthMm = (uint16_t)(endMm-LAP_segStartMm);
+  seg->heading = (int16_t)LAP_segHeading;
+  seg->event = (uint8_t)event;
+  seg->speed = SegmentSpeed(seg);
+  seg->maxError = 0;
+  LAP_nofSegments++;
+  LAP_segStartMm = endMm;
+  LAP_segHeading = 0;
+}
+
+static void ReportLap(void) {
+  TickType_t now;
+  unsigned char buf[48];
+
+  now = FRTOS1_xTaskGetTickCount();
+  LAP_lastLapMs = (uint32_t)(now-LAP_lapStartTicks)*portTICK_PERIOD_MS;
+  LAP_lapStartTicks = now;
+  LAP_lapCount++;
+  if (LAP_bestLapMs==0 || LAP_lastLapMs<LAP_bestLapMs) {
+    LAP_bestLapMs = LAP_lastLapMs;
+  }
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"LAP: ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), LAP_lapCount);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" time ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), LAP_lastLapMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  SHELL_SendString(buf);
+#if PL_CONFIG_HAS_RADIO
+  (void)RNETA_SendIdValuePairMessage(RAPP_MSG_TYPE_NOTIFY_VALUE, RAPP_MSG_TYPE_DATA_ID_LAP_TIME, LAP_lastLapMs, RNETA_GetDestAddr(), RPHY_PACKET_FLAGS_NONE);
+#endif
+}
+
+/* adapts the speed of the segments with the line errors of the last lap */
+static void RefineSpeeds(void) {
+  LAP_Segment *seg;
+  int i;
+
+  for(i=0;i<LAP_nofSegments;i++) {
+    seg = &LAP_segments[i];
+    if (seg->maxError>LAP_ERROR_HIGH) {
+      seg->speed = (uint8_t)(seg->speed>LAP_MIN_SPEED+LAP_SPEED_DOWN?seg->speed-LAP_SPEED_DOWN:LAP_MIN_SPEED);
+    } else if (seg->maxError<LAP_ERROR_LOW) {
+      seg->speed = (uint8_t)(seg->speed+LAP_SPEED_UP<100?seg->speed+LAP_SPEED_UP:100);
+    }
+    seg->maxError = 0;
+  }
+}
+
+static void StartLap(int32_t distMm) {
+  ODO_Pose pose;
+
+  ODO_GetPose(&pose, NULL);
+  LAP_startX = pose.x;
+  LAP_startY = pose.y;
+  LAP_lapStartTicks = FRTOS1_xTaskGetTickCount();
+  LAP_segStartMm = distMm;
+  LAP_segIdx = 0;
+  LAP_segHeading = 0;
+  LAP_sampleMm = distMm;
+  LAP_sampleHeading = Heading();
+  LAP_segIsBend = FALSE;
+}
+
+/* a marker or intersection has been passed in learning mode */
+static void LearnEvent(LAP_Event event, int32_t distMm) {
+  ODO_Pose pose;
+  int32_t dx, dy;
+
+  if (event==LAP_EVENT_CROSS && distMm-LAP_segStartMm>=0) {
+    ODO_GetPose(&pose, NULL);
+    dx = pose.x-LAP_startX;
+    dy = pose.y-LAP_startY;
+    if (IMATH_Abs32(dx)<LAP_CLOSE_MM && IMATH_Abs32(dy)<LAP_CLOSE_MM && LAP_nofSegments>0) {
+      int32_t lapMm = 0;
+      int i;
+
+      for(i=0;i<LAP_nofSegments;i++) {
+        lapMm += LAP_segments[i].lengthMm;
+      }
+      if (lapMm+distMm-LAP_segStartMm>=LAP_MIN_LAP_MM) { /* back at the start: lap is complete */
+        CloseSegment(distMm, LAP_EVENT_START);
+        LAP_isLearned = TRUE;
+        ReportLap();
+        LAP_segIdx = 0;
+        LAP_segStartMm = distMm;
+        LAP_state = LAP_STATE_RUN;
+        return;
+      }
+    }
+  }
+  CloseSegment(distMm, event);
+}
+
+/* a marker or intersection has been passed in running mode: align the position with the map */
+static void RunEvent(LAP_Event event, int32_t distMm) {
+  uint8_t idx;
+  int i;
+
+  idx = LAP_segIdx;
+  for(i=0;i<LAP_SEARCH_SEGMENTS && i<LAP_nofSegments;i++) {
+    if (LAP_segments[idx].event==event || (event==LAP_EVENT_CROSS && LAP_segments[idx].event==LAP_EVENT_START)) {
+      if (LAP_segments[idx].event==LAP_EVENT_START) {
+        RefineSpeeds();
+        ReportLap();
+        LAP_segIdx = 0;
+      } else {
+        LAP_segIdx = (uint8_t)((idx+1)%LAP_nofSegments);
+      }
+      LAP_segStartMm = distMm;
+      return;
+    }
+    idx = (uint8_t)((idx+1)%LAP_nofSegments);
+  }
+  /* not found ahead: false detection, ignore it */
+}
+
+static void OnEvent(LAP_Event event, int32_t distMm) {
+  switch(LAP_state) {
+    case LAP_STATE_WAIT_START:
+      if (event==LAP_EVENT_CROSS) {
+        StartLap(distMm);
+        LAP_state = LAP_isLearned?LAP_STATE_RUN:LAP_STATE_LEARN;
+      }
+      break;
+    case LAP_STATE_LEARN:
+      LearnEvent(event, distMm);
+      break;
+    case LAP_STATE_RUN:
+      RunEvent(event, distMm);
+      break;
+    default:
+      break;
+  }
+}
+
+static void Learn(int32_t distMm) {
+  int16_t heading;
+  int32_t dh;
+  bool isBend;
+
+  if (distMm-LAP_sampleMm<LAP_SAMPLE_MM) {
+    return;
+  }
+  heading = Heading();
+  dh = HeadingDiff(heading, LAP_sampleHeading);
+  isBend = IMATH_Abs32(dh)>=LAP_BEND_HEADING;
+  if (isBend!=LAP_segIsBend && LAP_sampleMm-LAP_segStartMm>=LAP_MIN_SEGMENT_MM) {
+    CloseSegment(LAP_sampleMm, LAP_EVENT_NONE); /* course changes between straight and bend */
+  }
+  LAP_segIsBend = isBend;
+  LAP_segHeading += dh;
+  LAP_sampleMm = distMm;
+  LAP_sampleHeading = heading;
+}
+
+static void Run(int32_t distMm, uint16_t lineValue) {
+  LAP_Segment *seg;
+  int32_t ahead, cap, v, error;
+  uint8_t idx;
+  int i;
+
+  seg = &LAP_segments[LAP_segIdx];
+  if (seg->event==LAP_EVENT_NONE && distMm-LAP_segStartMm>=seg->lengthMm) { /* no marker at the end: advance by distance */
+    LAP_segStartMm += seg->lengthMm;
+    LAP_segIdx = (uint8_t)((LAP_segIdx+1)%LAP_nofSegments);
+    seg = &LAP_segments[LAP_segIdx];
+  }
+  error = (IMATH_Abs32((int32_t)lineValue-REF_MIDDLE_LINE_VALUE)*100)/(REF_MAX_LINE_VALUE/2);
+  if (error>seg->maxError) {
+    seg->maxError = (uint8_t)(error>255?255:error);
+  }
+  /* speed of this segment, and braking curve to the slower segments ahead */
+  cap = seg->speed;
+  ahead = seg->lengthMm-(distMm-LAP_segStartMm);
+  if (ahead<0) {
+    ahead = 0;
+  }
+  idx = LAP_segIdx;
+  for(i=1;i<LAP_nofSegments && ahead<LAP_LOOKAHEAD_MM;i++) {
+    idx = (uint8_t)((idx+1)%LAP_nofSegments);
+    v = IMATH_Sqrt32(LAP_segments[idx].speed*LAP_segments[idx].speed+2*LAP_DECEL*ahead);
+    if (v<cap) {
+      cap = v;
+    }
+    ahead += LAP_segments[idx].lengthMm;
+  }
+  PID_SetLineSpeedLimit((uint8_t)cap);
+}
+
+void LAP_Sample(REF_LineKind kind, uint16_t lineValue) {
+  int32_t left, right, distMm;
+
+  if (LAP_state==LAP_STATE_OFF) {
+    return;
+  }
+  left = (int32_t)Q4CLeft_GetPos();
+  right = (int32_t)Q4CRight_GetPos();
+  LAP_steps += ((left-LAP_lastLeft)+(right-LAP_lastRight))/2;
+  LAP_lastLeft = left;
+  LAP_lastRight = right;
+  distMm = ODO_StepsToMm(LAP_steps);
+  /* markers and intersections: reported when the sensors have passed them */
+  if (kind!=REF_LINE_STRAIGHT && kind!=REF_LINE_NONE) {
+    if (!LAP_inEvent) {
+      LAP_inEvent = TRUE;
+      LAP_eventMm = distMm;
+      LAP_eventKind = LAP_EVENT_NONE;
+    }
+    if (kind==REF_LINE_FULL) {
+      LAP_eventKind = LAP_EVENT_CROSS; /* has priority over the sides, line might not be exactly across */
+    } else if (LAP_eventKind==LAP_EVENT_NONE) {
+      LAP_eventKind = kind==REF_LINE_LEFT?LAP_EVENT_LEFT:LAP_EVENT_RIGHT;
+    }
+  } else if (LAP_inEvent) {
+    LAP_inEvent = FALSE;
+    if (LAP_eventMm-LAP_lastEventMm>=LAP_EVENT_MIN_MM) {
+      LAP_lastEventMm = LAP_eventMm;
+      OnEvent(LAP_eventKind, LAP_eventMm);
+    }
+  }
+  if (LAP_state==LAP_STATE_LEARN) {
+    Learn(distMm);
+  } else if (LAP_state==LAP_STATE_RUN) {
+    Run(distMm, lineValue);
+  }
+}
+
+void LAP_Start(bool relearn) {
+  LAP_state = LAP_STATE_OFF; /* stop sampling while initializing */
+  if (relearn || !LAP_isLearned) {
+    LAP_nofSegments = 0;
+    LAP_isLearned = FALSE;
+    LAP_bestLapMs = 0;
+  }
+  LAP_lastLeft = (int32_t)Q4CLeft_GetPos();
+  LAP_lastRight = (int32_t)Q4CRight_GetPos();
+  LAP_steps = 0;
+  LAP_inEvent = FALSE;
+  LAP_lastEventMm = -LAP_EVENT_MIN_MM;
+  LAP_lapCount = 0;
+  PID_SetLineSpeedLimit(100);
+  LAP_state = LAP_STATE_WAIT_START;
+}
+
+void LAP_Stop(void) {
+  LAP_state = LAP_STATE_OFF;
+  if (!LAP_isLearned) {
+    LAP_nofSegments = 0; /* incomplete lap */
+  }
+  PID_SetLineSpeedLimit(100);
+}
+
+bool LAP_IsActive(void) {
+  return LAP_state!=LAP_STATE_OFF;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static const unsigned char *EventStr(uint8_t event) {
+  switch(event) {
+    case LAP_EVENT_NONE:  return (const unsigned char*)"-";
+    case LAP_EVENT_LEFT:  return (const unsigned char*)"LEFT";
+    case LAP_EVENT_RIGHT: return (const unsigned char*)"RIGHT";
+    case LAP_EVENT_CROSS: return (const unsigned char*)"CROSS";
+    case LAP_EVENT_START: return (const unsigned char*)"START";
+    default:              return (const unsigned char*)"?";
+  }
+}
+
+static void LAP_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"lap", (unsigned char*)"Group of lap learning commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows lap help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  learn", (unsigned char*)"Forgets the course and learns it on the next lap\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  start|stop", (unsigned char*)"Starts (learns the course if needed) or stops, start with 'line start'\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  print", (unsigned char*)"Prints the segments of the course\r\n", io->stdOut);
+}
+
+static void LAP_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+  const unsigned char *str;
+
+  switch(LAP_state) {
+    case LAP_STATE_OFF:        str = (const unsigned char*)"off\r\n"; break;
+    case LAP_STATE_WAIT_START: str = (const unsigned char*)"waiting for start line\r\n"; break;
+    case LAP_STATE_LEARN:      str = (const unsigned char*)"learning\r\n"; break;
+    case LAP_STATE_RUN:        str = (const unsigned char*)"running\r\n"; break;
+    default:                   str = (const unsigned char*)"?\r\n"; break;
+  }
+  CLS1_SendStatusStr((unsigned char*)"lap", (unsigned char*)"\r\n", io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  state", str, io->stdOut);
+  UTIL1_Num8uToStr(buf, sizeof(buf), LAP_nofSegments);
+  UTIL1_strcat(buf, sizeof(buf), LAP_isLearned?(unsigned char*)", learned\r\n":(unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  segments", buf, io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), LAP_lapCount);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  laps", buf, io->stdOut);
+  UTIL1_Num32uToStr(buf, sizeof(buf), LAP_lastLapMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms, best ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), LAP_bestLapMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  last lap", buf, io->stdOut);
+}
+
+static void LAP_PrintSegments(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  int i;
+
+  for(i=0;i<LAP_nofSegments;i++) {
+    UTIL1_Num16uToStr(buf, sizeof(buf), LAP_segments[i].lengthMm);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, ");
+    UTIL1_strcatNum16s(buf, sizeof(buf), LAP_segments[i].heading/10);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" deg, ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), LAP_segments[i].speed);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"%, ");
+    UTIL1_strcat(buf, sizeof(buf), EventStr(LAP_segments[i].event));
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  segment", buf, io->stdOut);
+  }
+}
+
+uint8_t LAP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"lap help")==0) {
+    LAP_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"lap status")==0) {
+    LAP_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap learn")==0) {
+    LAP_Start(TRUE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap start")==0) {
+    LAP_Start(FALSE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap stop")==0) {
+    LAP_Stop();
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"lap print")==0) {
+    LAP_PrintSegments(io);
+    *handled = TRUE;
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void LAP_Deinit(void) {
+  LAP_Stop();
+}
+
+void LAP_Init(void) {
+  LAP_state = LAP_STATE_OFF;
+  LAP_nofSegments = 0;
+  LAP_isLearned = FALSE;
+  LAP_lapCount = 0;
+  LAP_lastLapMs = 0;
+  LAP_bestLapMs = 0;
+}
+
+#endif /* PL_CONFIG_HAS_LAP_LEARN */
@@ -0,0 +1,61 @@
+/**
+ * \file
+ * \brief Interface to the lap learning.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module learns a closed line following course on the first lap and drives the following laps
+ * with a speed profile for each segment of the course, refined from lap to lap.
+ */
+
+#ifndef LAPLEARN_H_
+#define LAPLEARN_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_LAP_LEARN
+#include "Reflectance.h"
+
+/*!
+ * \brief Starts lap learning or lap running. The lap starts at the next start line (line across the course).
+ * \param relearn TRUE to forget the learned course and learn it again on the next lap.
+ */
+void LAP_Start(bool relearn);
+
+/*!
+ * \brief Stops lap learning or running, the learned course is kept and the speed limit is removed.
+ */
+void LAP_Stop(void);
+
+/*!
+ * \brief Returns if lap learning or running is active.
+ * \return TRUE if active.
+ */
+bool LAP_IsActive(void);
+
+/*!
+ * \brief Called by the line following for each control cycle: tracks the position on the course and sets the speed limit.
+ * \param kind Line kind seen by the sensors, markers and intersections are everything except REF_LINE_STRAIGHT and REF_LINE_NONE.
+ * \param lineValue Line position (0..REF_MAX_LINE_VALUE).
+ */
+void LAP_Sample(REF_LineKind kind, uint16_t lineValue);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t LAP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void LAP_Deinit(void);
+
+/*! \brief Initialization of the module */
+void LAP_Init(void);
+
+#endif /* PL_CONFIG_HAS_LAP_LEARN */
+
+#endif /* LAPLEARN_H_ */
@@ -19,8 +19,14 @@
 #endif
 #include "WAIT1.h"
 #include "Pid.h"
+#if PL_CONFIG_HAS_LAP_LEARN
+  #include "LapLearn.h"
+#endif
 #include "Drive.h"
 #include "Shell.h"
+#if PL_CONFIG_HAS_LINE_MAZE
+  #include "Maze.h"
+#endif
 #if PL_CONFIG_HAS_BUZZER
   #include "Buzzer.h"
 #endif
@@ -76,6 +82,15 @@ static bool FollowSegment(void) {
 
   currLine = REF_GetLineValue();
   currLineKind = REF_GetLineKind();
+#if PL_CONFIG_HAS_LAP_LEARN
+  if (LAP_IsActive()) {
+    LAP_Sample(currLineKind, currLine);
+    if (currLineKind!=REF_LINE_NONE) { /* markers and intersections are part of the course: drive over them */
+      PID_Line(currLine, REF_MIDDLE_LINE_VALUE);
+      return TRUE;
+    }
+  }
+#endif
   if (currLineKind==REF_LINE_STRAIGHT) {
     PID_Line(currLine, REF_MIDDLE_LINE_VALUE); /* move along the line */
     return TRUE;
@@ -104,9 +119,11 @@ static void StateMachine(void) {
       if (lineKind==REF_LINE_NONE) {
         LF_currState = STATE_FINISHED;
       } else{
-        TURN_Turn(TURN_LEFT180, NULL);
-        DRV_SetMode(DRV_MODE_NONE); /* disable position mode */
-        LF_currState = STATE_FOLLOW_SEGMENT;
+        if (TURN_TurnToLine(TURN_LEFT180, NULL)==ERR_OK) { /* ends centered on the line, still moving */
+          LF_currState = STATE_FOLLOW_SEGMENT;
+        } else {
+          LF_currState = STATE_STOP;
+        }
       }// else {
        // LF_currState = STATE_STOP;
       //}
@@ -122,6 +139,9 @@ static void StateMachine(void) {
       RNETA_SendSignal('C'); /*! \todo */
 #endif
       SHELL_SendString("Stopped!\r\n");
+#if PL_CONFIG_HAS_LAP_LEARN
+      LAP_Stop();
+#endif
       TURN_Turn(TURN_STOP, NULL);
       LF_currState = STATE_IDLE;
       break;
@@ -143,6 +163,9 @@ static void LineTask (void *pvParameters) {
       RNETA_SendSignal('B'); /*! \todo */
 #endif
       DRV_SetMode(DRV_MODE_NONE); /* disable any drive mode */
+#if PL_CONFIG_HAS_LINE_MAZE
+      MAZE_StartExploration(); /* map the maze from where we start */
+#endif
       PID_Start();
       LF_currState = STATE_FOLLOW_SEGMENT;
     }
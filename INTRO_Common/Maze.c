@@ -16,6 +16,13 @@
 #include "UTIL1.h"
 #include "Shell.h"
 #include "Reflectance.h"
+#include <stddef.h> /* offsetof() */
+#if PL_CONFIG_HAS_MAZE_MAP
+  #include "MazeMap.h"
+#endif
+#if PL_CONFIG_HAS_CONFIG_NVM
+  #include "NVM_Config.h"
+#endif
 
 #define MAZE_MIN_LINE_VAL      0x40   /* minimum value indicating a line */ /* \todo adapt to your needs */
 static uint16_t SensorHistory[REF_NOF_SENSORS]; /* value of history while moving forward */
@@ -76,12 +83,36 @@ void MAZE_ClearSensorHistory(void) {
 }
 
 
-#define MAZE_MAX_PATH        8 /*! \todo maximum number of turns in path */
+#if PL_CONFIG_HAS_MAZE_MAP
+  #define MAZE_MAX_PATH      MMAP_MAX_NODES /* at most one turn for each intersection */
+#else
+  #define MAZE_MAX_PATH      8 /*! \todo maximum number of turns in path */
+#endif
 
 static TURN_Kind path[MAZE_MAX_PATH]; /* recorded maze */
 static uint8_t pathLength; /* number of entries in path[] */
 static bool isSolved = FALSE; /* if we have solved the maze */
 
+#if PL_CONFIG_HAS_CONFIG_NVM
+#define MAZE_NVM_VERSION     1 /* increment if the content of MAZE_NvmData changes */
+
+typedef struct {
+  uint16_t version; /* MAZE_NVM_VERSION */
+  uint16_t size; /* sizeof(MAZE_NvmData), detects layout changes */
+  uint8_t pathLength;
+  uint8_t path[MAZE_MAX_PATH]; /* TURN_Kind as uint8_t */
+#if PL_CONFIG_HAS_MAZE_MAP
+  MMAP_Data map;
+#endif
+  uint16_t checksum; /* Fletcher-16 of all bytes before */
+} MAZE_NvmData; /* data stored in NVM */
+
+/* build fails if the data does not fit into NVM any more, e.g. after increasing MMAP_MAX_NODES or MMAP_MAX_EDGES */
+typedef char MAZE_NvmDataFits[(sizeof(MAZE_NvmData)<=NVMC_MAZE_DATA_SIZE)?1:-1];
+
+static MAZE_NvmData MAZE_nvmData; /* too large for the stack */
+#endif
+
 static TURN_Kind RevertTurn(TURN_Kind turn) {
   if (turn==TURN_LEFT90) {
     turn = TURN_RIGHT90;
@@ -121,15 +152,78 @@ TURN_Kind MAZE_SelectTurn(REF_LineKind prev, REF_LineKind curr) {
 
 void MAZE_SetSolved(void) {
   isSolved = TRUE;
-  /*! \todo here the path could be reverted */
-  MAZE_RevertPath();
+#if PL_CONFIG_HAS_MAZE_MAP
+  /* replace the recorded path with the fastest path from the start, found in the map */
+  if (MMAP_Solve(path, NULL, MAZE_MAX_PATH-1, &pathLength, NULL)!=ERR_OK) { /* keep one entry for the stop */
+    pathLength = 0;
+  }
+#endif
+  MAZE_RevertPath(); /* robot is at the finish: path back to the start */
   MAZE_AddPath(TURN_STOP); /* add an action to stop */
+#if PL_CONFIG_HAS_CONFIG_NVM
+  if (MAZE_SaveSolution()!=ERR_OK) { /* available for a speed run after a reset */
+    SHELL_SendString((unsigned char*)"MAZE: failed saving solution!\r\n");
+  }
+#endif
 }
 
 bool MAZE_IsSolved(void) {
   return isSolved;
 }
 
+#if PL_CONFIG_HAS_CONFIG_NVM
+uint8_t MAZE_SaveSolution(void) {
+  uint8_t *p;
+  size_t i;
+
+  if (!isSolved) {
+    return ERR_FAILED;
+  }
+  p = (uint8_t*)&MAZE_nvmData;
+  for(i=0;i<sizeof(MAZE_nvmData);i++) { /* deterministic padding bytes for the checksum */
+    p[i] = 0;
+  }
+  MAZE_nvmData.version = MAZE_NVM_VERSION;
+  MAZE_nvmData.size = sizeof(MAZE_NvmData);
+  MAZE_nvmData.pathLength = pathLength;
+  for(i=0;i<pathLength;i++) {
+    MAZE_nvmData.path[i] = (uint8_t)path[i];
+  }
+#if PL_CONFIG_HAS_MAZE_MAP
+  MMAP_GetData(&MAZE_nvmData.map);
+#endif
+  MAZE_nvmData.checksum = NVMC_Checksum(&MAZE_nvmData, offsetof(MAZE_NvmData, checksum));
+  return NVMC_SaveMazeData(&MAZE_nvmData, sizeof(MAZE_nvmData));
+}
+
+uint8_t MAZE_LoadSolution(void) {
+  MAZE_NvmData *ptr;
+  uint8_t i;
+
+  ptr = (MAZE_NvmData*)NVMC_GetMazeData();
+  if (ptr==NULL) {
+    return ERR_FAILED; /* nothing stored */
+  }
+  if (ptr->version!=MAZE_NVM_VERSION || ptr->size!=sizeof(MAZE_NvmData) || ptr->pathLength>MAZE_MAX_PATH) {
+    return ERR_FAILED; /* stored with a different firmware */
+  }
+  if (ptr->checksum!=NVMC_Checksum(ptr, offsetof(MAZE_NvmData, checksum))) {
+    return ERR_CRC;
+  }
+#if PL_CONFIG_HAS_MAZE_MAP
+  if (MMAP_SetData(&ptr->map)!=ERR_OK) {
+    return ERR_FAILED;
+  }
+#endif
+  for(i=0;i<ptr->pathLength;i++) {
+    path[i] = (TURN_Kind)ptr->path[i];
+  }
+  pathLength = ptr->pathLength;
+  isSolved = TRUE;
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_CONFIG_NVM */
+
 void MAZE_AddPath(TURN_Kind kind) {
   if (pathLength<MAZE_MAX_PATH) {
     path[pathLength] = kind;
@@ -155,11 +249,17 @@ void MAZE_SimplifyPath(void) {
 uint8_t MAZE_EvaluteTurn(bool *finished) {
   REF_LineKind historyLineKind, currLineKind;
   TURN_Kind turn;
+#if PL_CONFIG_HAS_MAZE_MAP
+  uint8_t exits;
+#endif
 
   *finished = FALSE;
   currLineKind = REF_GetLineKind();
   if (currLineKind==REF_LINE_NONE) { /* nothing, must be dead end */
     turn = TURN_LEFT180;
+#if PL_CONFIG_HAS_MAZE_MAP
+    exits = MMAP_EXIT_BACK;
+#endif
   } else {
     MAZE_ClearSensorHistory(); /* clear history values */
     MAZE_SampleSensorHistory(); /* store current values */
@@ -167,7 +267,27 @@ uint8_t MAZE_EvaluteTurn(bool *finished) {
     historyLineKind = MAZE_HistoryLineKind(); /* new read new values */
     currLineKind = REF_GetLineKind();
     turn = MAZE_SelectTurn(historyLineKind, currLineKind);
+#if PL_CONFIG_HAS_MAZE_MAP
+    exits = MMAP_EXIT_BACK;
+    if (historyLineKind==REF_LINE_LEFT || historyLineKind==REF_LINE_FULL) {
+      exits |= MMAP_EXIT_LEFT;
+    }
+    if (historyLineKind==REF_LINE_RIGHT || historyLineKind==REF_LINE_FULL) {
+      exits |= MMAP_EXIT_RIGHT;
+    }
+    if (currLineKind!=REF_LINE_NONE) {
+      exits |= MMAP_EXIT_STRAIGHT;
+    }
+#endif
+  }
+#if PL_CONFIG_HAS_MAZE_MAP
+  if (turn!=TURN_STOP) {
+    (void)MMAP_AddIntersection(exits, turn);
+    if (turn==TURN_FINISHED) {
+      MMAP_SetFinish();
+    }
   }
+#endif
   if (turn==TURN_FINISHED) {
     *finished = TRUE;
     LF_StopFollowing();
@@ -191,6 +311,9 @@ static void MAZE_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"maze", (unsigned char*)"Group of maze following commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows maze help or status\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  clear", (unsigned char*)"Clear the maze solution\r\n", io->stdOut);
+#if PL_CONFIG_HAS_CONFIG_NVM
+  CLS1_SendHelpStr((unsigned char*)"  save|load", (unsigned char*)"Save or load the maze solution to/from FLASH\r\n", io->stdOut);
+#endif
 }
 
 #if PL_CONFIG_HAS_SHELL
@@ -221,6 +344,20 @@ uint8_t MAZE_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
   } else if (UTIL1_strcmp((char*)cmd, (char*)"maze clear")==0) {
     MAZE_ClearSolution();
     *handled = TRUE;
+#if PL_CONFIG_HAS_CONFIG_NVM
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze save")==0) {
+    *handled = TRUE;
+    res = MAZE_SaveSolution();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"**** failed saving to FLASH\r\n", io->stdErr);
+    }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"maze load")==0) {
+    *handled = TRUE;
+    res = MAZE_LoadSolution();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"**** no valid solution in FLASH\r\n", io->stdErr);
+    }
+#endif
   }
   return res;
 }
@@ -234,9 +371,20 @@ TURN_Kind MAZE_GetSolvedTurn(uint8_t *solvedIdx) {
   }
 }
 
+void MAZE_StartExploration(void) {
+#if PL_CONFIG_HAS_MAZE_MAP
+  if (!isSolved) { /* keep the map of a solved maze for the speed run */
+    MMAP_Start(); /* new map, robot is at the start */
+  }
+#endif
+}
+
 void MAZE_ClearSolution(void) {
   isSolved = FALSE;
   pathLength = 0;
+#if PL_CONFIG_HAS_MAZE_MAP
+  MMAP_Start(); /* new map, robot has to be at the start */
+#endif
 }
 
 void MAZE_Deinit(void) {
@@ -244,5 +392,8 @@ void MAZE_Deinit(void) {
 
 void MAZE_Init(void) {
   MAZE_ClearSolution();
+#if PL_CONFIG_HAS_CONFIG_NVM
+  (void)MAZE_LoadSolution(); /* solved before reset: ready for a speed run */
+#endif
 }
 #endif /* PL_HAS_LINE_SENSOR */
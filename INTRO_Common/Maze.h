@@ -31,10 +31,32 @@ void MAZE_SimplifyPath(void);
 bool MAZE_IsSolved(void);
 
 /*!
- * \brief Marks the maze as solved.
+ * \brief Marks the maze as solved. The solution returned by MAZE_GetSolvedTurn() is the path from the finish back to the
+ * start, as the robot is at the finish. With the maze map this is the fastest path found in the map, otherwise the
+ * reverted recorded path.
  */
 void MAZE_SetSolved(void);
 
+#if PL_CONFIG_HAS_CONFIG_NVM
+/*!
+ * \brief Stores the solution (and the maze map) in FLASH, together with a version and a checksum.
+ * \return Error code, ERR_OK if everything was fine, ERR_FAILED if the maze is not solved.
+ */
+uint8_t MAZE_SaveSolution(void);
+
+/*!
+ * \brief Loads the solution stored with MAZE_SaveSolution(), so MAZE_IsSolved() returns TRUE.
+ * \return Error code, ERR_OK if everything was fine, ERR_FAILED if there is no valid solution, ERR_CRC for a wrong checksum.
+ */
+uint8_t MAZE_LoadSolution(void);
+#endif
+
+/*!
+ * \brief Has to be called when the robot starts to explore the maze from the start: starts a new maze map at the
+ * current robot pose, unless the maze is solved already.
+ */
+void MAZE_StartExploration(void);
+
 /*!
  * This clears the solution, and MAZE_IsSolved() will return FALSE
  */
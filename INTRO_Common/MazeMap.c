@@ -0,0 +1,445 @@
+/**
+ * \file
+ * \brief Maze map and path planning.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * While exploring, each intersection is added as node with its odometry position and the absolute directions
+ * of its exits. Nodes closer than MMAP_NODE_TOLERANCE_MM are the same intersection, so loops are detected.
+ * The segments are stored as edges with the driven length and the directions at both ends.
+ * The fastest path is searched with A* over the states (node, arriving direction), because the time needed
+ * at an intersection depends on the turn. The heuristic is the Chebyshev distance to the finish at full speed,
+ * which never overestimates the time, so the found path is optimal.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MAZE_MAP
+#include "MazeMap.h"
+#include "Odometry.h"
+#include "UTIL1.h"
+
+/*! \todo adopt the values to your robot and maze */
+#define MMAP_NODE_TOLERANCE_MM  60   /* nodes closer than this are the same intersection */
+#define MMAP_SPEED_MM_S         300  /* expected speed on a segment */
+#define MMAP_INTERSECTION_MS    100  /* expected time to pass an intersection */
+#define MMAP_TURN90_MS          300  /* additional time for a 90 degree turn */
+#define MMAP_TURN180_MS         600  /* additional time for a 180 degree turn */
+#define MMAP_COST_INFINITE      0xffffffffUL
+
+#define MMAP_NOF_STATES         (MMAP_MAX_NODES*4) /* node and arriving direction */
+#define MMAP_STATE_NONE         0xff
+#if MMAP_NOF_STATES>=MMAP_STATE_NONE
+  #error "states have to fit into an uint8_t"
+#endif
+#if MMAP_MAX_EDGES>64
+  #error "edge index has to fit into bits 10-15 of MMAP_prev"
+#endif
+
+/* absolute directions: 0 is the start heading (x axis), counting counter clockwise in steps of 90 degree */
+#define MMAP_DIR(dir)           ((uint8_t)((dir)&3))
+
+static MMAP_Node MMAP_nodes[MMAP_MAX_NODES];
+static uint8_t MMAP_nofNodes;
+static MMAP_Edge MMAP_edges[MMAP_MAX_EDGES];
+static uint8_t MMAP_nofEdges;
+static uint8_t MMAP_startDir; /* heading at the start node */
+static uint8_t MMAP_finishNode = MMAP_NODE_NONE;
+static uint8_t MMAP_currNode = MMAP_NODE_NONE; /* last node, where the robot is coming from */
+static uint8_t MMAP_departDir; /* direction the robot has left MMAP_currNode */
+static int32_t MMAP_departSteps; /* wheel steps when leaving MMAP_currNode */
+
+/* search data, static as too large for the task stacks: 6 bytes and 1 bit per state, 1176 bytes with 48 nodes */
+static uint32_t MMAP_cost[MMAP_NOF_STATES]; /* time from the start to the state */
+static uint16_t MMAP_prev[MMAP_NOF_STATES]; /* bits 0-7: previous state, bits 8-9: turn made at the previous node, bits 10-15: segment driven to the state */
+static uint8_t MMAP_closed[(MMAP_NOF_STATES+7)/8]; /* bit for each state which has been expanded */
+
+#define MMAP_IS_CLOSED(s)       ((MMAP_closed[(s)/8]>>((s)%8))&1)
+#define MMAP_SET_CLOSED(s)      (MMAP_closed[(s)/8] |= (uint8_t)(1<<((s)%8)))
+
+static uint8_t HeadingDir(int16_t heading) {
+  return (uint8_t)(((heading+450+3600)%3600)/900); /* heading in 0.1 degree, round to the next 90 degree */
+}
+
+static uint8_t FindNode(int32_t x, int32_t y) {
+  uint8_t i;
+
+  for(i=0;i<MMAP_nofNodes;i++) {
+    if (   x>=MMAP_nodes[i].x-MMAP_NODE_TOLERANCE_MM && x<=MMAP_nodes[i].x+MMAP_NODE_TOLERANCE_MM
+        && y>=MMAP_nodes[i].y-MMAP_NODE_TOLERANCE_MM && y<=MMAP_nodes[i].y+MMAP_NODE_TOLERANCE_MM)
+    {
+      return i;
+    }
+  }
+  return MMAP_NODE_NONE;
+}
+
+static void AddEdge(uint8_t a, uint8_t leaveDir, uint8_t b, uint8_t arriveDir, uint16_t lengthMm) {
+  uint8_t i, dirs, revDirs;
+  MMAP_Edge *e;
+
+  dirs = (uint8_t)(leaveDir|(arriveDir<<2));
+  revDirs = (uint8_t)(MMAP_DIR(arriveDir+2)|(MMAP_DIR(leaveDir+2)<<2)); /* same segment, driven from b to a */
+  for(i=0;i<MMAP_nofEdges;i++) {
+    e = &MMAP_edges[i];
+    if ((e->a==a && e->b==b && e->dirs==dirs) || (e->a==b && e->b==a && e->dirs==revDirs)) { /* known segment */
+      if (lengthMm<e->lengthMm) {
+        e->lengthMm = lengthMm; /* keep the shortest measurement */
+      }
+      return;
+    }
+  }
+  if (MMAP_nofEdges<MMAP_MAX_EDGES) {
+    e = &MMAP_edges[MMAP_nofEdges];
+    e->a = a;
+    e->b = b;
+    e->dirs = dirs;
+    e->lengthMm = lengthMm;
+    MMAP_nofEdges++;
+  }
+}
+
+void MMAP_Start(void) {
+  ODO_Pose pose;
+
+  ODO_GetPose(&pose, NULL);
+  MMAP_nofEdges = 0;
+  MMAP_finishNode = MMAP_NODE_NONE;
+  MMAP_startDir = HeadingDir(pose.heading);
+  MMAP_nodes[0].x = (int16_t)pose.x;
+  MMAP_nodes[0].y = (int16_t)pose.y;
+  MMAP_nodes[0].exits = (uint8_t)(1<<MMAP_startDir);
+  MMAP_nofNodes = 1;
+  MMAP_currNode = 0;
+  MMAP_departDir = MMAP_startDir;
+  MMAP_departSteps = ODO_GetDrivenSteps();
+}
+
+uint8_t MMAP_AddIntersection(uint8_t exits, TURN_Kind turn) {
+  ODO_Pose pose;
+  uint8_t node, arriveDir, absExits, rel;
+  int32_t steps;
+
+  if (MMAP_currNode==MMAP_NODE_NONE) {
+    return MMAP_NODE_NONE; /* not started */
+  }
+  ODO_GetPose(&pose, NULL);
+  arriveDir = HeadingDir(pose.heading);
+  absExits = 0;
+  for(rel=0;rel<4;rel++) { /* relative exits are in the same order as the directions */
+    if (exits&(1<<rel)) {
+      absExits |= (uint8_t)(1<<MMAP_DIR(arriveDir+rel));
+    }
+  }
+  node = FindNode(pose.x, pose.y);
+  if (node==MMAP_NODE_NONE) { /* new intersection */
+    if (MMAP_nofNodes>=MMAP_MAX_NODES) {
+      return MMAP_NODE_NONE; /* map full */
+    }
+    node = MMAP_nofNodes;
+    MMAP_nodes[node].x = (int16_t)pose.x;
+    MMAP_nodes[node].y = (int16_t)pose.y;
+    MMAP_nodes[node].exits = absExits;
+    MMAP_nofNodes++;
+  } else { /* been here before: correct the odometry drift */
+    MMAP_nodes[node].exits |= absExits;
+    pose.x = MMAP_nodes[node].x;
+    pose.y = MMAP_nodes[node].y;
+    ODO_SetPose(&pose);
+  }
+  steps = ODO_GetDrivenSteps()-MMAP_departSteps;
+  if (steps<0) {
+    steps = -steps;
+  }
+  AddEdge(MMAP_currNode, MMAP_departDir, node, arriveDir, (uint16_t)ODO_StepsToMm(steps));
+  switch(turn) {
+    case TURN_LEFT90:   rel = 1; break;
+    case TURN_LEFT180:
+    case TURN_RIGHT180: rel = 2; break;
+    case TURN_RIGHT90:  rel = 3; break;
+    default:            rel = 0; break;
+  }
+  MMAP_currNode = node;
+  MMAP_departDir = MMAP_DIR(arriveDir+rel);
+  MMAP_departSteps = ODO_GetDrivenSteps();
+  return node;
+}
+
+void MMAP_SetFinish(void) {
+  MMAP_finishNode = MMAP_currNode;
+}
+
+void MMAP_GetData(MMAP_Data *data) {
+  uint8_t i;
+
+  for(i=0;i<MMAP_MAX_NODES;i++) {
+    data->nodes[i] = MMAP_nodes[i];
+  }
+  for(i=0;i<MMAP_MAX_EDGES;i++) {
+    data->edges[i] = MMAP_edges[i];
+  }
+  data->nofNodes = MMAP_nofNodes;
+  data->nofEdges = MMAP_nofEdges;
+  data->startDir = MMAP_startDir;
+  data->finishNode = MMAP_finishNode;
+}
+
+uint8_t MMAP_SetData(const MMAP_Data *data) {
+  uint8_t i;
+
+  if (data->nofNodes>MMAP_MAX_NODES || data->nofEdges>MMAP_MAX_EDGES
+      || (data->finishNode!=MMAP_NODE_NONE && data->finishNode>=data->nofNodes))
+  {
+    return ERR_RANGE;
+  }
+  for(i=0;i<MMAP_MAX_NODES;i++) {
+    MMAP_nodes[i] = data->nodes[i];
+  }
+  for(i=0;i<MMAP_MAX_EDGES;i++) {
+    MMAP_edges[i] = data->edges[i];
+  }
+  MMAP_nofNodes = data->nofNodes;
+  MMAP_nofEdges = data->nofEdges;
+  MMAP_startDir = MMAP_DIR(data->startDir);
+  MMAP_finishNode = data->finishNode;
+  MMAP_currNode = MMAP_NODE_NONE; /* not recording until the next MMAP_Start() */
+  return ERR_OK;
+}
+
+static uint32_t TurnTime(uint8_t rel) {
+  if (rel==0) {
+    return MMAP_INTERSECTION_MS;
+  } else if (rel==2) {
+    return MMAP_INTERSECTION_MS+MMAP_TURN180_MS;
+  }
+  return MMAP_INTERSECTION_MS+MMAP_TURN90_MS;
+}
+
+static uint32_t Heuristic(uint8_t node) {
+  int32_t dx, dy;
+
+  dx = MMAP_nodes[node].x-MMAP_nodes[MMAP_finishNode].x;
+  dy = MMAP_nodes[node].y-MMAP_nodes[MMAP_finishNode].y;
+  if (dx<0) {
+    dx = -dx;
+  }
+  if (dy<0) {
+    dy = -dy;
+  }
+  return (uint32_t)((dx>dy?dx:dy)*1000/MMAP_SPEED_MM_S);
+}
+
+static void Relax(uint8_t from, uint8_t leaveDir, uint8_t to, uint8_t arriveDir, uint8_t edge) {
+  uint8_t rel, next;
+  uint32_t cost;
+
+  rel = MMAP_DIR(leaveDir-from); /* from%4 is the arriving direction */
+  if (from==MMAP_startDir) { /* start: the robot is placed on the line, there is no turn */
+    if (rel!=0) {
+      return;
+    }
+    cost = MMAP_cost[from];
+  } else {
+    cost = MMAP_cost[from]+TurnTime(rel);
+  }
+  cost += ((uint32_t)MMAP_edges[edge].lengthMm*1000)/MMAP_SPEED_MM_S;
+  next = (uint8_t)(to*4+arriveDir);
+  if (!MMAP_IS_CLOSED(next) && cost<MMAP_cost[next]) {
+    MMAP_cost[next] = cost;
+    MMAP_prev[next] = (uint16_t)(from|(rel<<8)|(edge<<10));
+  }
+}
+
+static TURN_Kind RelTurn(uint8_t rel) {
+  switch(rel) {
+    case 1:  return TURN_LEFT90;
+    case 2:  return TURN_LEFT180;
+    case 3:  return TURN_RIGHT90;
+    default: return TURN_STRAIGHT;
+  }
+}
+
+uint8_t MMAP_Solve(TURN_Kind *path, uint16_t *lengthsMm, uint8_t maxPath, uint8_t *pathLength, uint32_t *timeMs) {
+  uint8_t i, s, best, goal, len;
+  uint32_t f, bestF;
+  MMAP_Edge *e;
+
+  *pathLength = 0;
+  if (MMAP_finishNode==MMAP_NODE_NONE || MMAP_nofNodes==0) {
+    return ERR_FAILED; /* finish not found yet */
+  }
+  for(s=0;s<MMAP_NOF_STATES;s++) {
+    MMAP_cost[s] = MMAP_COST_INFINITE;
+    MMAP_prev[s] = MMAP_STATE_NONE;
+  }
+  for(i=0;i<sizeof(MMAP_closed);i++) {
+    MMAP_closed[i] = 0;
+  }
+  MMAP_cost[MMAP_startDir] = 0; /* node 0, arriving in start direction */
+  goal = MMAP_STATE_NONE;
+  for(;;) {
+    best = MMAP_STATE_NONE;
+    bestF = MMAP_COST_INFINITE;
+    for(s=0;s<MMAP_nofNodes*4;s++) { /* select the open state with the lowest estimated total time */
+      if (!MMAP_IS_CLOSED(s) && MMAP_cost[s]!=MMAP_COST_INFINITE) {
+        f = MMAP_cost[s]+Heuristic((uint8_t)(s/4));
+        if (f<bestF) {
+          bestF = f;
+          best = s;
+        }
+      }
+    }
+    if (best==MMAP_STATE_NONE) {
+      return ERR_FAILED; /* finish not reachable */
+    }
+    if (best/4==MMAP_finishNode) {
+      goal = best;
+      break;
+    }
+    MMAP_SET_CLOSED(best);
+    for(i=0;i<MMAP_nofEdges;i++) { /* segments are driven in both directions */
+      e = &MMAP_edges[i];
+      if (e->a==best/4) {
+        Relax(best, MMAP_DIR(e->dirs), e->b, MMAP_DIR(e->dirs>>2), i);
+      }
+      if (e->b==best/4) {
+        Relax(best, MMAP_DIR((e->dirs>>2)+2), e->a, MMAP_DIR(e->dirs+2), i);
+      }
+    }
+  }
+  /* count the intersections between start and finish */
+  len = 0;
+  for(s=goal; (MMAP_prev[s]&0xff)!=MMAP_STATE_NONE; s=(uint8_t)MMAP_prev[s]) {
+    len++;
+  }
+  if (len>0) {
+    len--; /* no turn at the start */
+  }
+  if (len>maxPath) {
+    return ERR_OVERFLOW;
+  }
+  *pathLength = len;
+  if (timeMs!=NULL) {
+    *timeMs = MMAP_cost[goal];
+  }
+  /* the turn at a node is stored in the following state, so walk back and fill in from the end */
+  for(s=goal; (MMAP_prev[s]&0xff)!=MMAP_STATE_NONE; s=(uint8_t)MMAP_prev[s]) {
+    if (lengthsMm!=NULL) {
+      lengthsMm[len] = MMAP_edges[MMAP_prev[s]>>10].lengthMm;
+    }
+    if (len>0) {
+      path[len-1] = RelTurn((uint8_t)((MMAP_prev[s]>>8)&3));
+      len--;
+    }
+  }
+  return ERR_OK;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void MMAP_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"mmap", (unsigned char*)"Group of maze map commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows maze map help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  print", (unsigned char*)"Prints the nodes and segments of the map\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  solve", (unsigned char*)"Computes and prints the fastest path\r\n", io->stdOut);
+}
+
+static void MMAP_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+
+  CLS1_SendStatusStr((unsigned char*)"mmap", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_Num8uToStr(buf, sizeof(buf), MMAP_nofNodes);
+  UTIL1_chcat(buf, sizeof(buf), '/');
+  UTIL1_strcatNum8u(buf, sizeof(buf), MMAP_MAX_NODES);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  nodes", buf, io->stdOut);
+  UTIL1_Num8uToStr(buf, sizeof(buf), MMAP_nofEdges);
+  UTIL1_chcat(buf, sizeof(buf), '/');
+  UTIL1_strcatNum8u(buf, sizeof(buf), MMAP_MAX_EDGES);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  segments", buf, io->stdOut);
+  if (MMAP_finishNode==MMAP_NODE_NONE) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"not found\r\n");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"node ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), MMAP_finishNode);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  finish", buf, io->stdOut);
+}
+
+static void MMAP_PrintMap(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  uint8_t i;
+
+  for(i=0;i<MMAP_nofNodes;i++) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"node ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), i);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)": (");
+    UTIL1_strcatNum16s(buf, sizeof(buf), MMAP_nodes[i].x);
+    UTIL1_chcat(buf, sizeof(buf), ',');
+    UTIL1_strcatNum16s(buf, sizeof(buf), MMAP_nodes[i].y);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)") mm, exits 0x");
+    UTIL1_strcatNum8Hex(buf, sizeof(buf), MMAP_nodes[i].exits);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+  for(i=0;i<MMAP_nofEdges;i++) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"segment ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), MMAP_edges[i].a);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"-");
+    UTIL1_strcatNum8u(buf, sizeof(buf), MMAP_edges[i].b);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)": ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), MMAP_edges[i].lengthMm);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+}
+
+static uint8_t MMAP_PrintSolution(const CLS1_StdIOType *io) {
+  TURN_Kind path[MMAP_MAX_NODES];
+  uint8_t i, len, res;
+  uint32_t timeMs;
+
+  res = MMAP_Solve(path, NULL, sizeof(path)/sizeof(path[0]), &len, &timeMs);
+  if (res!=ERR_OK) {
+    CLS1_SendStr((unsigned char*)"*** no path to the finish\r\n", io->stdErr);
+    return res;
+  }
+  CLS1_SendStr((unsigned char*)"path: ", io->stdOut);
+  for(i=0;i<len;i++) {
+    CLS1_SendStr(TURN_TurnKindStr(path[i]), io->stdOut);
+    CLS1_SendStr((unsigned char*)" ", io->stdOut);
+  }
+  CLS1_SendStr((unsigned char*)"\r\nexpected time: ", io->stdOut);
+  CLS1_SendNum32u(timeMs, io->stdOut);
+  CLS1_SendStr((unsigned char*)" ms\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+uint8_t MMAP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, "mmap help")==0) {
+    MMAP_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, "mmap status")==0) {
+    MMAP_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, "mmap print")==0) {
+    MMAP_PrintMap(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, "mmap solve")==0) {
+    *handled = TRUE;
+    return MMAP_PrintSolution(io);
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void MMAP_Deinit(void) {
+}
+
+void MMAP_Init(void) {
+  MMAP_nofNodes = 0;
+  MMAP_nofEdges = 0;
+  MMAP_finishNode = MMAP_NODE_NONE;
+  MMAP_currNode = MMAP_NODE_NONE;
+}
+
+#endif /* PL_CONFIG_HAS_MAZE_MAP */
@@ -0,0 +1,113 @@
+/**
+ * \file
+ * \brief Interface to the maze map.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module builds a graph of the line maze while exploring it: the intersections are the nodes, tagged with
+ * their odometry position, and the line segments between them are the edges, with their driven length.
+ * The fastest path from start to finish is computed with A* on the expected traversal time.
+ */
+
+#ifndef MAZEMAP_H_
+#define MAZEMAP_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MAZE_MAP
+#include "Turn.h"
+
+#define MMAP_MAX_NODES        48   /*!< maximum number of intersections (including start, finish and dead ends) */
+#define MMAP_MAX_EDGES        64   /*!< maximum number of line segments */
+#define MMAP_NODE_NONE        0xff /*!< invalid node index */
+
+/* exits of an intersection, relative to the direction the robot arrives */
+#define MMAP_EXIT_STRAIGHT    (1<<0) /*!< line continues straight */
+#define MMAP_EXIT_LEFT        (1<<1) /*!< line to the left */
+#define MMAP_EXIT_BACK        (1<<2) /*!< line where the robot is coming from */
+#define MMAP_EXIT_RIGHT       (1<<3) /*!< line to the right */
+
+/*! \brief Intersection */
+typedef struct {
+  int16_t x, y; /*!< position in mm */
+  uint8_t exits; /*!< bit set for each absolute direction with a line */
+} MMAP_Node;
+
+/*! \brief Line segment between two intersections */
+typedef struct {
+  uint8_t a, b; /*!< nodes at both ends */
+  uint8_t dirs; /*!< bits 0-1: direction leaving a, bits 2-3: direction arriving at b */
+  uint16_t lengthMm; /*!< driven length of the segment */
+} MMAP_Edge;
+
+/*! \brief Complete map, e.g. to store it in non-volatile memory */
+typedef struct {
+  MMAP_Node nodes[MMAP_MAX_NODES];
+  MMAP_Edge edges[MMAP_MAX_EDGES];
+  uint8_t nofNodes, nofEdges;
+  uint8_t startDir; /*!< absolute direction at the start */
+  uint8_t finishNode; /*!< finish node or MMAP_NODE_NONE */
+} MMAP_Data;
+
+/*!
+ * \brief Clears the map and starts a new one at the current robot pose.
+ */
+void MMAP_Start(void);
+
+/*!
+ * \brief Adds the intersection at the current robot pose, together with the segment driven to it. If there is already a node
+ * at this position (e.g. because of a loop), it is reused and the odometry position is corrected to it.
+ * \param exits Exits of the intersection (MMAP_EXIT_xxx), relative to the arriving direction.
+ * \param turn Turn the robot will make to leave the intersection.
+ * \return Index of the node, or MMAP_NODE_NONE if the map is full or not started.
+ */
+uint8_t MMAP_AddIntersection(uint8_t exits, TURN_Kind turn);
+
+/*!
+ * \brief Marks the last added intersection as finish.
+ */
+void MMAP_SetFinish(void);
+
+/*!
+ * \brief Copies the map.
+ * \param data Where to store the map.
+ */
+void MMAP_GetData(MMAP_Data *data);
+
+/*!
+ * \brief Replaces the map, e.g. with a map loaded from non-volatile memory.
+ * \param data Map to be used.
+ * \return ERR_OK if everything was fine, ERR_RANGE if the map is not valid.
+ */
+uint8_t MMAP_SetData(const MMAP_Data *data);
+
+/*!
+ * \brief Computes the fastest path from the start to the finish.
+ * \param path Where to store the turns, one for each intersection after the start.
+ * \param lengthsMm Where to store the length of the segments before each turn and of the last one to the finish, so it needs maxPath+1 entries. Can be NULL.
+ * \param maxPath Number of entries in path.
+ * \param pathLength Where to store the number of turns.
+ * \param timeMs Where to store the expected time in milliseconds, can be NULL.
+ * \return ERR_OK if a path has been found, ERR_FAILED if there is no path, ERR_OVERFLOW if path is too small.
+ */
+uint8_t MMAP_Solve(TURN_Kind *path, uint16_t *lengthsMm, uint8_t maxPath, uint8_t *pathLength, uint32_t *timeMs);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t MMAP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void MMAP_Deinit(void);
+
+/*! \brief Initialization of the module */
+void MMAP_Init(void);
+
+#endif /* PL_CONFIG_HAS_MAZE_MAP */
+
+#endif /* MAZEMAP_H_ */
@@ -0,0 +1,340 @@
+/**
+ * \file
+ * \brief Maze speed run.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The fastest path of the maze map is compiled into a plan of straight segments and turns. The speed at the end
+ * of each segment is limited by the following turn, and a backward pass over the plan makes sure the robot can
+ * brake in time for all later turns. While driving, the speed is the minimum of the acceleration curve from the
+ * start of the segment, the braking curve to the next turn, and the maximum speed. The line sensor keeps the
+ * robot on the line and re-aligns the driven distance at the intersections. 90 degree turns are driven as arcs
+ * starting MRUN_ARC_RADIUS_MM before the intersection.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MAZE_RUN
+#include "MazeRun.h"
+#include "MazeMap.h"
+#include "Maze.h"
+#include "Drive.h"
+#include "Reflectance.h"
+#include "Odometry.h"
+#include "IntMath.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#include "Shell.h"
+
+/*! \todo adopt the values to your robot */
+#define MRUN_MAX_SPEED          3000 /* maximum speed on straights, steps/sec */
+#define MRUN_MIN_SPEED          300  /* minimum speed, to get started from standstill */
+#define MRUN_TURN_SPEED         1000 /* speed through a 90 degree arc, steps/sec */
+#define MRUN_ACCEL              6000 /* acceleration and deceleration, steps/sec^2 */
+#define MRUN_ARC_RADIUS_MM      60   /* radius of the arcs */
+#define MRUN_SENSOR_AHEAD_MM    30   /* distance of the line sensor in front of the wheel axle */
+#define MRUN_SYNC_WINDOW_MM     100  /* intersections are expected within this distance before the end of a segment */
+#define MRUN_LINE_KP            10   /* line error to speed difference, in percent */
+#define MRUN_TASK_PERIOD_MS     5
+
+#define MRUN_MM_TO_STEPS(mm)    ODO_MmToSteps(mm)
+#define MRUN_HALF_TRACK_STEPS   ((2000L*ODO_GetSteps90())/3142) /* half of the wheel distance in steps: a 90 degree turn on the spot is a quarter circle */
+#define MRUN_ARC_STEPS          MRUN_MM_TO_STEPS(MRUN_ARC_RADIUS_MM)
+
+typedef enum {
+  MRUN_STATE_IDLE,     /* not running */
+  MRUN_STATE_STRAIGHT, /* driving a segment */
+  MRUN_STATE_ARC,      /* turning at the end of a segment */
+  MRUN_STATE_DONE      /* reached the finish */
+} MRUN_State;
+
+/* task notification bits */
+#define MRUN_START_RUN  (1<<0)
+#define MRUN_STOP_RUN   (1<<1)
+
+static TURN_Kind MRUN_turns[MMAP_MAX_NODES]; /* turn at the end of each segment */
+static uint16_t MRUN_lengthsMm[MMAP_MAX_NODES+1]; /* length of the segments */
+static int32_t MRUN_exitSpeed[MMAP_MAX_NODES+1]; /* speed at the end of each segment */
+static uint8_t MRUN_nofTurns; /* number of turns, there is one segment more */
+
+static volatile MRUN_State MRUN_state = MRUN_STATE_IDLE;
+static uint8_t MRUN_segment; /* current segment */
+static int32_t MRUN_segStart; /* driven steps at the start of the segment */
+static int32_t MRUN_accelStart; /* driven steps where the segment has been entered, after the arc */
+static int32_t MRUN_arcStartDiff; /* right-left steps at the start of the arc */
+static bool MRUN_synced; /* if the segment has been aligned with the intersection */
+static TickType_t MRUN_startTicks;
+static uint32_t MRUN_lastRunMs; /* time of the last run */
+static xTaskHandle MRUN_TaskHandle;
+
+/* speed reachable from speed v over a distance of steps */
+static int32_t ReachableSpeed(int32_t v, int32_t steps) {
+  int64_t sq;
+
+  if (steps<0) {
+    steps = 0;
+  }
+  sq = (int64_t)v*v+2*(int64_t)MRUN_ACCEL*steps;
+  if (sq>(int64_t)MRUN_MAX_SPEED*MRUN_MAX_SPEED) {
+    return MRUN_MAX_SPEED;
+  }
+  return IMATH_Sqrt32((int32_t)sq);
+}
+
+static int32_t TurnedSteps(void) {
+  return (int32_t)Q4CRight_GetPos()-(int32_t)Q4CLeft_GetPos();
+}
+
+static bool IsArc(TURN_Kind turn) {
+  return turn==TURN_LEFT90 || turn==TURN_RIGHT90;
+}
+
+/* distance in steps from the start of the segment to the point where the segment ends, or the arc starts */
+static int32_t SegmentEnd(uint8_t seg) {
+  int32_t len;
+
+  len = MRUN_MM_TO_STEPS(MRUN_lengthsMm[seg]);
+  if (seg<MRUN_nofTurns && IsArc(MRUN_turns[seg])) {
+    len -= MRUN_ARC_STEPS;
+  }
+  return len;
+}
+
+static uint8_t Plan(void) {
+  uint8_t i, res;
+
+  if (!MAZE_IsSolved()) {
+    return ERR_FAILED;
+  }
+  res = MMAP_Solve(MRUN_turns, MRUN_lengthsMm, MMAP_MAX_NODES, &MRUN_nofTurns, NULL);
+  if (res!=ERR_OK) {
+    return res;
+  }
+  for(i=0;i<MRUN_nofTurns;i++) {
+    if (MRUN_turns[i]==TURN_STRAIGHT) {
+      MRUN_exitSpeed[i] = MRUN_MAX_SPEED;
+    } else if (IsArc(MRUN_turns[i])) {
+      MRUN_exitSpeed[i] = MRUN_TURN_SPEED;
+    } else {
+      return ERR_FAILED; /* U-turns are not expected in a solved path */
+    }
+  }
+  MRUN_exitSpeed[MRUN_nofTurns] = 0; /* stop at the finish */
+  /* look ahead: the exit speed of a segment is limited by braking for all later segments */
+  for(i=MRUN_nofTurns;i>0;i--) {
+    int32_t brakeSteps, maxSpeed;
+
+    brakeSteps = SegmentEnd(i);
+    if (IsArc(MRUN_turns[i-1])) {
+      brakeSteps -= MRUN_ARC_STEPS; /* segment is entered at the end of the arc, after the intersection */
+    }
+    maxSpeed = ReachableSpeed(MRUN_exitSpeed[i], brakeSteps);
+    if (MRUN_exitSpeed[i-1]>maxSpeed) {
+      MRUN_exitSpeed[i-1] = maxSpeed;
+    }
+  }
+  return ERR_OK;
+}
+
+static void StartSegment(uint8_t seg, int32_t startSteps) {
+  MRUN_segment = seg;
+  MRUN_segStart = startSteps;
+  MRUN_accelStart = ODO_GetDrivenSteps();
+  MRUN_synced = FALSE;
+  MRUN_state = MRUN_STATE_STRAIGHT;
+}
+
+static void Finish(void) {
+  (void)DRV_SetMode(DRV_MODE_STOP);
+  MRUN_lastRunMs = (uint32_t)(FRTOS1_xTaskGetTickCount()-MRUN_startTicks)*portTICK_PERIOD_MS;
+  MRUN_state = MRUN_STATE_DONE;
+  SHELL_SendString((unsigned char*)"MRUN: finished!\r\n");
+}
+
+static void DriveStraight(void) {
+  int32_t s, end, entrySpeed, speed, corr;
+  REF_LineKind lineKind;
+
+  s = ODO_GetDrivenSteps()-MRUN_segStart;
+  end = SegmentEnd(MRUN_segment);
+  lineKind = REF_GetLineKind();
+  if (!MRUN_synced && end-s<MRUN_MM_TO_STEPS(MRUN_SYNC_WINDOW_MM)
+      && (lineKind==REF_LINE_LEFT || lineKind==REF_LINE_RIGHT || lineKind==REF_LINE_FULL))
+  { /* sensor is on the intersection: align the driven distance */
+    s = MRUN_MM_TO_STEPS(MRUN_lengthsMm[MRUN_segment]-MRUN_SENSOR_AHEAD_MM);
+    MRUN_segStart = ODO_GetDrivenSteps()-s;
+    MRUN_synced = TRUE;
+  }
+  if (s>=end) { /* end of segment */
+    if (MRUN_segment>=MRUN_nofTurns) {
+      Finish();
+    } else if (IsArc(MRUN_turns[MRUN_segment])) {
+      MRUN_arcStartDiff = TurnedSteps();
+      MRUN_state = MRUN_STATE_ARC;
+    } else { /* straight over the intersection */
+      StartSegment((uint8_t)(MRUN_segment+1), MRUN_segStart+MRUN_MM_TO_STEPS(MRUN_lengthsMm[MRUN_segment]));
+    }
+    return;
+  }
+  entrySpeed = MRUN_segment==0?0:MRUN_exitSpeed[MRUN_segment-1];
+  speed = ReachableSpeed(entrySpeed, ODO_GetDrivenSteps()-MRUN_accelStart);
+  if (speed<MRUN_MIN_SPEED) {
+    speed = MRUN_MIN_SPEED;
+  }
+  if (speed>ReachableSpeed(MRUN_exitSpeed[MRUN_segment], end-s)) {
+    speed = ReachableSpeed(MRUN_exitSpeed[MRUN_segment], end-s); /* brake for the next turn */
+  }
+  corr = 0;
+  if (lineKind==REF_LINE_STRAIGHT) { /* steer to the line, otherwise keep the heading */
+    corr = (((int32_t)REF_GetLineValue()-REF_MIDDLE_LINE_VALUE)*MRUN_LINE_KP)/100;
+    if (corr>speed/4) {
+      corr = speed/4;
+    } else if (corr<-speed/4) {
+      corr = -speed/4;
+    }
+  }
+  (void)DRV_SetSpeed(speed+corr, speed-corr); /* line on the right: turn right */
+}
+
+static void DriveArc(void) {
+  int32_t speed, diff, turned;
+
+  speed = MRUN_exitSpeed[MRUN_segment];
+  diff = (speed*MRUN_HALF_TRACK_STEPS)/MRUN_ARC_STEPS; /* wheel speed difference for the radius */
+  turned = TurnedSteps()-MRUN_arcStartDiff;
+  if (MRUN_turns[MRUN_segment]==TURN_LEFT90) {
+    (void)DRV_SetSpeed(speed-diff, speed+diff);
+  } else {
+    turned = -turned;
+    (void)DRV_SetSpeed(speed+diff, speed-diff);
+  }
+  if (turned>=2*ODO_GetSteps90()) { /* 90 degree: wheels differ by two times the steps of a turn on the spot */
+    StartSegment((uint8_t)(MRUN_segment+1), ODO_GetDrivenSteps()-MRUN_ARC_STEPS); /* arc ends MRUN_ARC_RADIUS_MM after the intersection */
+  }
+}
+
+static void MazeRunTask(void *pvParameters) {
+  uint32_t notificationValue;
+  TickType_t xLastWakeTime;
+
+  (void)pvParameters;
+  xLastWakeTime = FRTOS1_xTaskGetTickCount();
+  for(;;) {
+    (void)xTaskNotifyWait(0UL, MRUN_START_RUN|MRUN_STOP_RUN, &notificationValue, 0); /* check flags */
+    if (notificationValue&MRUN_STOP_RUN) {
+      if (MRUN_state==MRUN_STATE_STRAIGHT || MRUN_state==MRUN_STATE_ARC) {
+        (void)DRV_SetMode(DRV_MODE_STOP);
+      }
+      MRUN_state = MRUN_STATE_IDLE;
+    } else if (notificationValue&MRUN_START_RUN) {
+      MRUN_startTicks = FRTOS1_xTaskGetTickCount();
+      (void)DRV_SetMode(DRV_MODE_SPEED); /* setpoints are only used in speed mode */
+      StartSegment(0, ODO_GetDrivenSteps());
+    }
+    if (MRUN_state==MRUN_STATE_STRAIGHT) {
+      DriveStraight();
+    } else if (MRUN_state==MRUN_STATE_ARC) {
+      DriveArc();
+    }
+    FRTOS1_vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(MRUN_TASK_PERIOD_MS));
+  }
+}
+
+uint8_t MRUN_Start(void) {
+  uint8_t res;
+
+  if (MRUN_IsRunning()) {
+    return ERR_BUSY;
+  }
+  res = Plan();
+  if (res!=ERR_OK) {
+    return res;
+  }
+  (void)xTaskNotify(MRUN_TaskHandle, MRUN_START_RUN, eSetBits);
+  return ERR_OK;
+}
+
+void MRUN_Stop(void) {
+  (void)xTaskNotify(MRUN_TaskHandle, MRUN_STOP_RUN, eSetBits);
+}
+
+bool MRUN_IsRunning(void) {
+  return MRUN_state==MRUN_STATE_STRAIGHT || MRUN_state==MRUN_STATE_ARC;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void MRUN_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"mrun", (unsigned char*)"Group of maze speed run commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows speed run help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  start|stop", (unsigned char*)"Starts or stops the speed run on the solved maze\r\n", io->stdOut);
+}
+
+static void MRUN_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  uint8_t i;
+
+  CLS1_SendStatusStr((unsigned char*)"mrun", (unsigned char*)"\r\n", io->stdOut);
+  switch(MRUN_state) {
+    case MRUN_STATE_IDLE:     UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"IDLE\r\n"); break;
+    case MRUN_STATE_STRAIGHT: UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"STRAIGHT\r\n"); break;
+    case MRUN_STATE_ARC:      UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"ARC\r\n"); break;
+    case MRUN_STATE_DONE:     UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"DONE\r\n"); break;
+    default:                  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"UNKNOWN\r\n"); break;
+  }
+  CLS1_SendStatusStr((unsigned char*)"  state", buf, io->stdOut);
+  UTIL1_Num32uToStr(buf, sizeof(buf), MRUN_lastRunMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  last run", buf, io->stdOut);
+  for(i=0;i<=MRUN_nofTurns && MRUN_state!=MRUN_STATE_IDLE;i++) {
+    UTIL1_Num16uToStr(buf, sizeof(buf), MRUN_lengthsMm[i]);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, exit ");
+    UTIL1_strcatNum32s(buf, sizeof(buf), MRUN_exitSpeed[i]);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps/s");
+    if (i<MRUN_nofTurns) {
+      UTIL1_chcat(buf, sizeof(buf), ' ');
+      UTIL1_strcat(buf, sizeof(buf), TURN_TurnKindStr(MRUN_turns[i]));
+    }
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  segment", buf, io->stdOut);
+  }
+}
+
+uint8_t MRUN_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+
+  if (UTIL1_strcmp((char*)cmd, CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, "mrun help")==0) {
+    MRUN_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, "mrun status")==0) {
+    MRUN_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, "mrun start")==0) {
+    *handled = TRUE;
+    res = MRUN_Start();
+    if (res!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"**** maze not solved or no path to the finish\r\n", io->stdErr);
+    }
+  } else if (UTIL1_strcmp((char*)cmd, "mrun stop")==0) {
+    MRUN_Stop();
+    *handled = TRUE;
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void MRUN_Deinit(void) {
+}
+
+void MRUN_Init(void) {
+  MRUN_state = MRUN_STATE_IDLE;
+  MRUN_nofTurns = 0;
+  MRUN_lastRunMs = 0;
+  if (xTaskCreate(MazeRunTask, "MazeRun", 400/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+2, &MRUN_TaskHandle) != pdPASS) {
+    for(;;){} /* error */
+  }
+}
+
+#endif /* PL_CONFIG_HAS_MAZE_RUN */
@@ -0,0 +1,53 @@
+/**
+ * \file
+ * \brief Interface to the maze speed run.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module drives the solved maze path in one continuous motion: the straights are driven with a speed profile
+ * planned ahead over all segments, and the turns are driven as arcs without stopping.
+ */
+
+#ifndef MAZERUN_H_
+#define MAZERUN_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MAZE_RUN
+
+/*!
+ * \brief Starts the speed run. The robot has to be at the start of the solved maze.
+ * \return ERR_OK if the run has been started, ERR_FAILED if the maze is not solved or no path is found.
+ */
+uint8_t MRUN_Start(void);
+
+/*!
+ * \brief Stops the speed run.
+ */
+void MRUN_Stop(void);
+
+/*!
+ * \brief Returns if a speed run is in progress.
+ * \return TRUE if running.
+ */
+bool MRUN_IsRunning(void);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t MRUN_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void MRUN_Deinit(void);
+
+/*! \brief Initialization of the module */
+void MRUN_Init(void);
+
+#endif /* PL_CONFIG_HAS_MAZE_RUN */
+
+#endif /* MAZERUN_H_ */
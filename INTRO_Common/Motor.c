@@ -16,6 +16,7 @@
 #include "UTIL1.h"
 
 static MOT_MotorDevice motorL, motorR;
+static uint16_t MOT_SupplyComp = MOT_COMP_ONE; /* supply voltage compensation factor, MOT_COMP_ONE is 1.0 */
 
 MOT_MotorDevice *MOT_GetMotorHandle(MOT_MotorSide side) {
   if (side==MOT_MOTOR_LEFT) {
@@ -52,6 +53,60 @@ uint16_t MOT_GetVal(MOT_MotorDevice *motor) {
   return motor->currPWMvalue;
 }
 
+void MOT_SetLinTable(MOT_MotorDevice *motor, const uint16_t table[MOT_LIN_NOF_POINTS]) {
+  int i;
+
+  if (table==NULL) {
+    motor->linEnabled = FALSE;
+    for(i=0;i<MOT_LIN_NOF_POINTS;i++) { /* identity */
+      motor->linTable[i] = (uint16_t)((i*0xffffUL)/(MOT_LIN_NOF_POINTS-1));
+    }
+    return;
+  }
+  for(i=0;i<MOT_LIN_NOF_POINTS;i++) {
+    motor->linTable[i] = table[i];
+  }
+  motor->linEnabled = TRUE;
+}
+
+void MOT_LinEnable(MOT_MotorDevice *motor, bool enable) {
+  motor->linEnabled = enable;
+}
+
+uint16_t MOT_LinDuty(MOT_MotorDevice *motor, uint16_t effort) {
+  if (!motor->linEnabled) {
+    return effort;
+  }
+  return MLIN_Duty(motor->linTable, effort);
+}
+
+void MOT_SetSupplyCompensation(uint16_t factor) {
+  if (factor>MOT_COMP_MAX) {
+    factor = MOT_COMP_MAX;
+  }
+  MOT_SupplyComp = factor;
+}
+
+uint16_t MOT_GetSupplyCompensation(void) {
+  return MOT_SupplyComp;
+}
+
+void MOT_SetEffort(MOT_MotorDevice *motor, uint16_t effort) {
+  uint32_t duty;
+
+  motor->currEffort = effort;
+  duty = MOT_LinDuty(motor, effort);
+  duty = (duty*MOT_SupplyComp)/MOT_COMP_ONE; /* scale with nominal/actual supply voltage */
+  if (duty>0xFFFF) {
+    duty = 0xFFFF;
+  }
+  MOT_SetVal(motor, (uint16_t)(0xFFFF-duty)); /* PWM is low active */
+}
+
+uint16_t MOT_GetEffort(MOT_MotorDevice *motor) {
+  return motor->currEffort;
+}
+
 #if MOTOR_HAS_INVERT
 void MOT_Invert(MOT_MotorDevice *motor, bool inverted) {
   motor->inverted = inverted;
@@ -75,8 +130,8 @@ void MOT_SetSpeedPercent(MOT_MotorDevice *motor, MOT_SpeedPercent percent) {
   } else {
     MOT_SetDirection(motor, MOT_DIR_FORWARD);
   }
-  val = ((100-percent)*0xffff)/100; /* H-Bridge is low active! */
-  MOT_SetVal(motor, (uint16_t)val);
+  val = (percent*0xffff)/100;
+  MOT_SetEffort(motor, (uint16_t)val); /* linearized, H-Bridge is low active! */
 }
 
 void MOT_UpdatePercent(MOT_MotorDevice *motor, MOT_Direction dir) {
@@ -145,6 +200,7 @@ static void MOT_PrintStatus(const CLS1_StdIOType *io) {
   UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"% 0x");
   UTIL1_strcatNum16Hex(buf, sizeof(buf), MOT_GetVal(&motorL));
   UTIL1_strcat(buf, sizeof(buf),(unsigned char*)(MOT_GetDirection(&motorL)==MOT_DIR_FORWARD?", fw":", bw"));
+  UTIL1_strcat(buf, sizeof(buf),(unsigned char*)(motorL.linEnabled?", lin":""));
   CLS1_SendStr(buf, io->stdOut);
   CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
 
@@ -154,6 +210,7 @@ static void MOT_PrintStatus(const CLS1_StdIOType *io) {
   UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"% 0x");
   UTIL1_strcatNum16Hex(buf, sizeof(buf), MOT_GetVal(&motorR));
   UTIL1_strcat(buf, sizeof(buf),(unsigned char*)(MOT_GetDirection(&motorR)==MOT_DIR_FORWARD?", fw":", bw"));
+  UTIL1_strcat(buf, sizeof(buf),(unsigned char*)(motorR.linEnabled?", lin":""));
   CLS1_SendStr(buf, io->stdOut);
   CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
 }
@@ -217,6 +274,8 @@ void MOT_Init(void) {
   motorR.DirPutVal = DirRPutVal;
   motorL.SetRatio16 = PWMLSetRatio16;
   motorR.SetRatio16 = PWMRSetRatio16;
+  MOT_SetLinTable(&motorL, NULL); /* no linearization until table is loaded */
+  MOT_SetLinTable(&motorR, NULL);
   MOT_SetSpeedPercent(&motorL, 0);
   MOT_SetSpeedPercent(&motorR, 0);
   (void)PWML_Enable();
@@ -11,6 +11,7 @@
 
 #include "Platform.h"
 #if PL_CONFIG_HAS_MOTOR
+#include "MotorLin.h"
 
 #define MOTOR_HAS_INVERT 1  /* if we support motor revert at runtime */
 
@@ -21,12 +22,20 @@ typedef enum {
 
 typedef int8_t MOT_SpeedPercent; /*!< -100%...+100%, where negative is backward */
 
+#define MOT_COMP_ONE        4096 /*!< supply compensation factor of 1.0 */
+#define MOT_COMP_MAX        (MOT_COMP_ONE*3/2) /*!< maximum supply compensation factor, 1.5 */
+
+#define MOT_LIN_NOF_POINTS  MLIN_NOF_POINTS /*!< number of points in the linearization table, for effort 0, 1/16, 2/16, ... 16/16 */
+
 typedef struct MOT_MotorDevice_ {
 #if MOTOR_HAS_INVERT
   bool inverted;
 #endif
   MOT_SpeedPercent currSpeedPercent; /*!< our current speed in %, negative percent means backward */
   uint16_t currPWMvalue; /*!< current PWM value used */
+  uint16_t currEffort; /*!< last effort set with MOT_SetEffort() */
+  bool linEnabled; /*!< if effort is linearized with linTable */
+  uint16_t linTable[MOT_LIN_NOF_POINTS]; /*!< PWM duty (0 is off, 0xffff is full) for each effort point, first entry is the end of the deadband */
   uint8_t (*SetRatio16)(uint16_t); /*!< function to set the ratio */
   void (*DirPutVal)(bool); /*!< function to set direction bit */
 } MOT_MotorDevice;
@@ -81,6 +90,54 @@ void MOT_UpdatePercent(MOT_MotorDevice *motor, MOT_Direction dir);
  */
 void MOT_SetVal(MOT_MotorDevice *motor, uint16_t val);
 
+/*!
+ * \brief Sets the linearization table of the motor, used by MOT_SetEffort().
+ * \param[in] motor Motor handle
+ * \param[in] table PWM duty (0 is off, 0xffff is full) for each effort point, or NULL to disable linearization.
+ */
+void MOT_SetLinTable(MOT_MotorDevice *motor, const uint16_t table[MOT_LIN_NOF_POINTS]);
+
+/*!
+ * \brief Enables or disables the linearization, keeping the table.
+ * \param[in] motor Motor handle
+ * \param[in] enable TRUE to use the table, FALSE to pass the effort as PWM duty.
+ */
+void MOT_LinEnable(MOT_MotorDevice *motor, bool enable);
+
+/*!
+ * \brief Maps an effort to the PWM duty with the linearization table: the motor speed is about proportional to the effort.
+ * \param[in] motor Motor handle
+ * \param[in] effort Effort, 0 is off and 0xffff is full speed.
+ * \return PWM duty, 0 is off and 0xffff is full.
+ */
+uint16_t MOT_LinDuty(MOT_MotorDevice *motor, uint16_t effort);
+
+/*!
+ * \brief Sets the PWM value for the motor with a linearized effort, compensating the deadband and nonlinearity of the motor.
+ * \param[in] motor Motor handle
+ * \param[in] effort Effort, 0 is off and 0xffff is full speed.
+ */
+void MOT_SetEffort(MOT_MotorDevice *motor, uint16_t effort);
+
+/*!
+ * \brief Returns the last effort set with MOT_SetEffort(), used to compare the commanded effort with the measured speed.
+ * \param[in] motor Motor handle
+ * \return Effort, 0 is off and 0xffff is full speed.
+ */
+uint16_t MOT_GetEffort(MOT_MotorDevice *motor);
+
+/*!
+ * \brief Sets the factor the PWM duty of MOT_SetEffort() is scaled with, used to compensate the supply (battery) voltage.
+ * \param[in] factor Nominal voltage divided by actual voltage, MOT_COMP_ONE is 1.0, limited to MOT_COMP_MAX.
+ */
+void MOT_SetSupplyCompensation(uint16_t factor);
+
+/*!
+ * \brief Returns the factor used to compensate the supply voltage.
+ * \return Compensation factor, MOT_COMP_ONE is 1.0.
+ */
+uint16_t MOT_GetSupplyCompensation(void);
+
 /*!
  * \brief Return the current PWM value of the motor.
  * \param[in] motor Motor handle
@@ -0,0 +1,206 @@
+/**
+ * \file
+ * \brief Motor Calibration Module.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This is the implementation of the motor calibration module.
+ * The motors do not move below a certain PWM duty (deadband) and the speed is not proportional to the duty above it.
+ * The calibration sweeps the PWM duty, measures the speed with the tacho and builds an inverse table for each motor,
+ * so an effort is mapped to the PWM duty which gives a speed proportional to the effort.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MOTOR_CALIBRATION
+#include "MotorCalib.h"
+#include "Motor.h"
+#include "Tacho.h"
+#include "Drive.h"
+#include "NVM_Config.h"
+#include "WAIT1.h"
+#include "UTIL1.h"
+#include "MotorLin.h"
+#include <stddef.h> /* offsetof() */
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#define MOTCAL_SETTLE_MS        300 /* time for the motor speed to settle after changing the PWM */
+#define MOTCAL_NOF_SAMPLES      8   /* number of speed samples averaged for each sweep point */
+#define MOTCAL_SAMPLE_MS        10  /* time between the speed samples */
+#define MOTCAL_NVM_VERSION      1   /* increment if the content of MOTCAL_Tables changes */
+
+typedef struct {
+  uint16_t version; /* MOTCAL_NVM_VERSION */
+  uint16_t size; /* sizeof(MOTCAL_Tables), detects layout changes */
+  uint16_t left[MOT_LIN_NOF_POINTS];
+  uint16_t right[MOT_LIN_NOF_POINTS];
+  uint16_t checksum; /* Fletcher-16 of all bytes before */
+} MOTCAL_Tables; /* data stored in NVM */
+
+static MOTCAL_Tables MOTCAL_tables; /* tables from NVM or from the last calibration */
+static bool MOTCAL_isValid = FALSE; /* if MOTCAL_tables contains a calibration */
+
+static uint8_t SaveTables(void) {
+  MOTCAL_tables.version = MOTCAL_NVM_VERSION;
+  MOTCAL_tables.size = sizeof(MOTCAL_Tables);
+  MOTCAL_tables.checksum = NVMC_Checksum(&MOTCAL_tables, offsetof(MOTCAL_Tables, checksum));
+  return NVMC_SaveMotorLinData(&MOTCAL_tables, sizeof(MOTCAL_tables));
+}
+
+static uint8_t LoadTables(void) {
+  MOTCAL_Tables *ptr;
+
+  ptr = (MOTCAL_Tables*)NVMC_GetMotorLinData();
+  if (ptr==NULL) {
+    return ERR_FAILED; /* nothing stored */
+  }
+  if (ptr->version!=MOTCAL_NVM_VERSION || ptr->size!=sizeof(MOTCAL_Tables)) {
+    return ERR_FAILED; /* stored with a different firmware */
+  }
+  if (ptr->checksum!=NVMC_Checksum(ptr, offsetof(MOTCAL_Tables, checksum))) {
+    return ERR_CRC;
+  }
+  MOTCAL_tables = *ptr; /* struct copy */
+  return ERR_OK;
+}
+
+static void ApplyTables(void) {
+  if (MOTCAL_isValid) {
+    MOT_SetLinTable(MOT_GetMotorHandle(MOT_MOTOR_LEFT), MOTCAL_tables.left);
+    MOT_SetLinTable(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), MOTCAL_tables.right);
+  } else {
+    MOT_SetLinTable(MOT_GetMotorHandle(MOT_MOTOR_LEFT), NULL);
+    MOT_SetLinTable(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), NULL);
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static uint8_t Sweep(const CLS1_StdIOType *io) {
+  uint16_t duty[MOT_LIN_NOF_POINTS];
+  int32_t speedL[MOT_LIN_NOF_POINTS], speedR[MOT_LIN_NOF_POINTS];
+  int32_t sumL, sumR;
+  MOT_MotorDevice *motorL, *motorR;
+  uint8_t buf[48];
+  uint8_t res;
+  int i, k;
+
+  motorL = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
+  motorR = MOT_GetMotorHandle(MOT_MOTOR_RIGHT);
+  (void)DRV_SetMode(DRV_MODE_NONE); /* drive task only measures the speed, we control the motors */
+  CLS1_SendStr((uint8_t*)"Motor calibration, robot turns on the spot...\r\n", io->stdOut);
+  MOT_SetDirection(motorL, MOT_DIR_FORWARD);
+  MOT_SetDirection(motorR, MOT_DIR_BACKWARD);
+  for(i=0;i<MOT_LIN_NOF_POINTS;i++) {
+    duty[i] = (uint16_t)((i*0xffffUL)/(MOT_LIN_NOF_POINTS-1));
+    MOT_SetVal(motorL, 0xFFFF-duty[i]); /* raw PWM without linearization, PWM is low active */
+    MOT_SetVal(motorR, 0xFFFF-duty[i]);
+    WAIT1_WaitOSms(MOTCAL_SETTLE_MS);
+    sumL = sumR = 0;
+    for(k=0;k<MOTCAL_NOF_SAMPLES;k++) {
+      sumL += TACHO_GetSpeed(TRUE);
+      sumR += TACHO_GetSpeed(FALSE);
+      WAIT1_WaitOSms(MOTCAL_SAMPLE_MS);
+    }
+    speedL[i] = sumL/MOTCAL_NOF_SAMPLES;
+    speedR[i] = sumR/MOTCAL_NOF_SAMPLES;
+    UTIL1_strcpy(buf, sizeof(buf), (uint8_t*)"  duty 0x");
+    UTIL1_strcatNum16Hex(buf, sizeof(buf), duty[i]);
+    UTIL1_strcat(buf, sizeof(buf), (uint8_t*)": L ");
+    UTIL1_strcatNum32s(buf, sizeof(buf), speedL[i]);
+    UTIL1_strcat(buf, sizeof(buf), (uint8_t*)", R ");
+    UTIL1_strcatNum32s(buf, sizeof(buf), speedR[i]);
+    UTIL1_strcat(buf, sizeof(buf), (uint8_t*)" steps/sec\r\n");
+    CLS1_SendStr(buf, io->stdOut);
+  }
+  MOT_SetSpeedPercent(motorL, 0); /* turn off again */
+  MOT_SetSpeedPercent(motorR, 0);
+  if (!MLIN_BuildTable(duty, speedL, MOTCAL_tables.left) || !MLIN_BuildTable(duty, speedR, MOTCAL_tables.right)) {
+    CLS1_SendStr((uint8_t*)"ERROR: motor not moving!\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  MOTCAL_isValid = TRUE;
+  ApplyTables();
+  CLS1_SendStr((uint8_t*)"Calibration finished, use 'motcal save' to store it.\r\n", io->stdOut);
+  return ERR_OK;
+}
+
+static void PrintTable(const unsigned char *name, const uint16_t table[MOT_LIN_NOF_POINTS], const CLS1_StdIOType *io) {
+  uint8_t buf[16];
+  int i;
+
+  CLS1_SendStatusStr(name, (unsigned char*)"", io->stdOut);
+  for(i=0;i<MOT_LIN_NOF_POINTS;i++) {
+    UTIL1_strcpy(buf, sizeof(buf), (uint8_t*)"0x");
+    UTIL1_strcatNum16Hex(buf, sizeof(buf), table[i]);
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    CLS1_SendStr(buf, io->stdOut);
+  }
+  CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+}
+
+static void MOTCAL_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"motcal", (unsigned char*)"Group of motor calibration commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows motor calibration help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  run", (unsigned char*)"Sweeps the PWM and builds the linearization tables (robot turns on the spot)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  save", (unsigned char*)"Saves the linearization tables to FLASH\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  on|off", (unsigned char*)"Enables or disables the linearization\r\n", io->stdOut);
+}
+
+static void MOTCAL_PrintStatus(const CLS1_StdIOType *io) {
+  CLS1_SendStatusStr((unsigned char*)"motcal", (unsigned char*)"\r\n", io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  calibrated", MOTCAL_isValid?(unsigned char*)"yes\r\n":(unsigned char*)"no\r\n", io->stdOut);
+  if (MOTCAL_isValid) {
+    PrintTable((unsigned char*)"  table L", MOTCAL_tables.left, io);
+    PrintTable((unsigned char*)"  table R", MOTCAL_tables.right, io);
+  }
+}
+
+uint8_t MOTCAL_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"motcal help")==0) {
+    MOTCAL_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"motcal status")==0) {
+    MOTCAL_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motcal run")==0) {
+    *handled = TRUE;
+    res = Sweep(io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motcal save")==0) {
+    *handled = TRUE;
+    if (!MOTCAL_isValid) {
+      CLS1_SendStr((unsigned char*)"**** not calibrated, use 'motcal run' first\r\n", io->stdErr);
+      res = ERR_FAILED;
+    } else if (SaveTables()!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"**** failed saving to FLASH\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motcal on")==0) {
+    *handled = TRUE;
+    if (!MOTCAL_isValid) {
+      CLS1_SendStr((unsigned char*)"**** not calibrated, use 'motcal run' first\r\n", io->stdErr);
+      res = ERR_FAILED;
+    } else {
+      MOT_LinEnable(MOT_GetMotorHandle(MOT_MOTOR_LEFT), TRUE);
+      MOT_LinEnable(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), TRUE);
+    }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"motcal off")==0) {
+    *handled = TRUE;
+    MOT_LinEnable(MOT_GetMotorHandle(MOT_MOTOR_LEFT), FALSE);
+    MOT_LinEnable(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), FALSE);
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void MOTCAL_Deinit(void) {
+  /* nothing needed */
+}
+
+void MOTCAL_Init(void) {
+  MOTCAL_isValid = LoadTables()==ERR_OK;
+  ApplyTables();
+}
+
+#endif /* PL_CONFIG_HAS_MOTOR_CALIBRATION */
@@ -0,0 +1,38 @@
+/**
+ * \file
+ * \brief Motor Calibration Module.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This is the interface to the motor calibration module: it characterizes the deadband and
+ * nonlinearity of the motors and builds the linearization tables used by MOT_SetEffort().
+ */
+
+#ifndef MOTORCALIB_H_
+#define MOTORCALIB_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_MOTOR_CALIBRATION
+#include "Motor.h"
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t MOTCAL_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void MOTCAL_Deinit(void);
+
+/*! \brief Initialization of the module, loads the linearization tables from NVM */
+void MOTCAL_Init(void);
+
+#endif /* PL_CONFIG_HAS_MOTOR_CALIBRATION */
+
+#endif /* MOTORCALIB_H_ */
@@ -0,0 +1,88 @@
+/**
+ * \file
+ * \brief Motor linearization tables.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Building and using the inverse linearization tables of the motors. Hardware independent, so it can be
+ * compiled for the host with MLIN_HOST defined (see INTRO_HostTest).
+ */
+
+#ifdef MLIN_HOST
+  #define MLIN_ENABLED  1
+#else
+  #include "Platform.h"
+  #define MLIN_ENABLED  PL_CONFIG_HAS_MOTOR
+#endif
+#if MLIN_ENABLED
+#include "MotorLin.h"
+
+uint8_t MLIN_BuildTable(const uint16_t duty[MLIN_NOF_POINTS], const int32_t speed[MLIN_NOF_POINTS], uint16_t table[MLIN_NOF_POINTS]) {
+  int32_t mono[MLIN_NOF_POINTS];
+  int32_t maxSpeed, target, val;
+  int i, j, dead;
+
+  /* make speed positive and monotonic increasing, so there is a unique inverse */
+  for(i=0;i<MLIN_NOF_POINTS;i++) {
+    val = speed[i];
+    if (val<0) {
+      val = -val;
+    }
+    if (i>0 && val<mono[i-1]) {
+      val = mono[i-1];
+    }
+    mono[i] = val;
+  }
+  maxSpeed = mono[MLIN_NOF_POINTS-1];
+  if (maxSpeed<MLIN_MIN_SPEED) {
+    return 0; /* motor has not moved */
+  }
+  /* end of deadband: last sweep point where the wheel is standing still */
+  dead = 0;
+  for(i=0;i<MLIN_NOF_POINTS;i++) {
+    if (mono[i]<=maxSpeed/MLIN_STANDSTILL_DIV) {
+      dead = i;
+    }
+  }
+  table[0] = duty[dead];
+  j = dead+1;
+  for(i=1;i<MLIN_NOF_POINTS-1;i++) {
+    target = (maxSpeed*i)/(MLIN_NOF_POINTS-1); /* speed proportional to the effort */
+    while (j<MLIN_NOF_POINTS-1 && mono[j]<target) {
+      j++;
+    }
+    /* target is between mono[j-1] and mono[j]: interpolate the duty */
+    if (mono[j]==mono[j-1]) {
+      val = duty[j];
+    } else {
+      val = duty[j-1]+(int32_t)(((uint32_t)(duty[j]-duty[j-1])*(uint32_t)(target-mono[j-1]))/(uint32_t)(mono[j]-mono[j-1]));
+    }
+    if (val<table[i-1]) { /* keep table monotonic */
+      val = table[i-1];
+    } else if (val>0xffff) {
+      val = 0xffff;
+    }
+    table[i] = (uint16_t)val;
+  }
+  table[MLIN_NOF_POINTS-1] = duty[MLIN_NOF_POINTS-1];
+  return 1;
+}
+
+uint16_t MLIN_Duty(const uint16_t table[MLIN_NOF_POINTS], uint16_t effort) {
+  #define MLIN_SEGMENT_BITS  12 /* 0x10000/(MLIN_NOF_POINTS-1): each table segment is 4096 effort units */
+  uint32_t idx, frac;
+  int32_t lo, hi;
+
+  if (effort==0) {
+    return 0; /* off, table starts at the end of the deadband */
+  }
+  if (effort==0xffff) {
+    return table[MLIN_NOF_POINTS-1];
+  }
+  idx = effort>>MLIN_SEGMENT_BITS;
+  frac = effort&((1<<MLIN_SEGMENT_BITS)-1);
+  lo = table[idx];
+  hi = table[idx+1];
+  return (uint16_t)(lo+(((hi-lo)*(int32_t)frac)>>MLIN_SEGMENT_BITS)); /* linear interpolation */
+}
+
+#endif /* MLIN_ENABLED */
@@ -0,0 +1,37 @@
+/**
+ * \file
+ * \brief Interface to the motor linearization tables.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module builds the inverse linearization table of a motor out of a PWM sweep and maps an effort to the
+ * PWM duty with it. It does not use any hardware or RTOS, so it is used by the motor and calibration modules on
+ * the robot and by the motor model check in INTRO_HostTest.
+ */
+
+#ifndef MOTORLIN_H_
+#define MOTORLIN_H_
+
+#include <stdint.h>
+
+#define MLIN_NOF_POINTS      17  /*!< number of points in the linearization table, for effort 0, 1/16, 2/16, ... 16/16 */
+#define MLIN_MIN_SPEED       100 /*!< minimal speed (steps/sec) at full PWM, otherwise the motor has not moved */
+#define MLIN_STANDSTILL_DIV  50  /*!< below 1/50 of the maximum speed the wheel is considered standing still */
+
+/*!
+ * \brief Builds an inverse linearization table out of a PWM sweep.
+ * \param duty PWM duty of each sweep point, increasing, from 0 (off) to 0xffff (full).
+ * \param speed Measured speed for each sweep point, in steps per second.
+ * \param table Where to store the table: PWM duty for the effort points 0, 1/16, ... 16/16 of the maximum speed.
+ * \return 1 if the table has been built, 0 if the motor did not move.
+ */
+uint8_t MLIN_BuildTable(const uint16_t duty[MLIN_NOF_POINTS], const int32_t speed[MLIN_NOF_POINTS], uint16_t table[MLIN_NOF_POINTS]);
+
+/*!
+ * \brief Maps an effort to the PWM duty with a linearization table, interpolating between the table points.
+ * \param table Linearization table.
+ * \param effort Effort, 0 is off, 0xffff is full.
+ * \return PWM duty, 0 is off, 0xffff is full.
+ */
+uint16_t MLIN_Duty(const uint16_t table[MLIN_NOF_POINTS], uint16_t effort);
+
+#endif /* MOTORLIN_H_ */
@@ -51,6 +51,60 @@ void *NVMC_GetPIDData(void) {
   return (void*)NVMC_PID_SETTINGS_DATA_START_ADDR;
 }
 
+uint8_t NVMC_SaveMotorLinData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_MOTOR_LIN_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_MOTOR_LIN_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetMotorLinData(void) {
+  if (isErased((uint8_t*)NVMC_MOTOR_LIN_DATA_START_ADDR, NVMC_MOTOR_LIN_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_MOTOR_LIN_DATA_START_ADDR;
+}
+
+uint8_t NVMC_SaveMazeData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_MAZE_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_MAZE_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetMazeData(void) {
+  if (isErased((uint8_t*)NVMC_MAZE_DATA_START_ADDR, NVMC_MAZE_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_MAZE_DATA_START_ADDR;
+}
+
+uint8_t NVMC_SaveTurnCalData(void *data, uint16_t dataSize) {
+  if (dataSize>NVMC_TURN_CAL_DATA_SIZE) {
+    return ERR_OVERFLOW;
+  }
+  return IFsh1_SetBlockFlash(data, (IFsh1_TAddress)(NVMC_TURN_CAL_DATA_START_ADDR), dataSize);
+}
+
+void *NVMC_GetTurnCalData(void) {
+  if (isErased((uint8_t*)NVMC_TURN_CAL_DATA_START_ADDR, NVMC_TURN_CAL_DATA_SIZE)) {
+    return NULL;
+  }
+  return (void*)NVMC_TURN_CAL_DATA_START_ADDR;
+}
+
+uint16_t NVMC_Checksum(const void *data, size_t nofBytes) {
+  const uint8_t *p = (const uint8_t*)data;
+  uint16_t sum1 = 0, sum2 = 0; /* Fletcher-16 */
+
+  while(nofBytes>0) {
+    sum1 = (uint16_t)((sum1+*p)%255);
+    sum2 = (uint16_t)((sum2+sum1)%255);
+    p++;
+    nofBytes--;
+  }
+  return (uint16_t)((sum2<<8)|sum1);
+}
 
 void NVMC_Init(void) {
   /* nothing needed */
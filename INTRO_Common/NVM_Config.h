@@ -12,6 +12,7 @@
 
 #include "Platform.h"
 #if PL_CONFIG_HAS_CONFIG_NVM
+#include <stddef.h> /* size_t */
 
 #if PL_CONFIG_BOARD_IS_FRDM
   /*!< NVRM_Config, start address of configuration data in flash */
@@ -42,6 +43,24 @@
 #define NVMC_PID_SETTINGS_DATA_SIZE        (5*7*4) /* 5 PID configs with 7 32bit values each */
 #define NVMC_PID_SETTINGS_END_ADDR         (NVMC_REFLECTANCE_END_ADDR+NVMC_PID_SETTINGS_DATA_SIZE)
 
+#define NVMC_MOTOR_LIN_DATA_START_ADDR     (NVMC_PID_SETTINGS_END_ADDR)
+#define NVMC_MOTOR_LIN_DATA_SIZE           (2*2+2*17*2+2) /* version and size, 2 motors with linearization table of 17 16bit values, checksum */
+#define NVMC_MOTOR_LIN_END_ADDR            (NVMC_MOTOR_LIN_DATA_START_ADDR+NVMC_MOTOR_LIN_DATA_SIZE)
+
+#define NVMC_MAZE_DATA_START_ADDR          (NVMC_MOTOR_LIN_END_ADDR)
+#define NVMC_MAZE_DATA_SIZE                (0x2E0) /* solved path and maze map, with version and checksum */
+#define NVMC_MAZE_END_ADDR                 (NVMC_MAZE_DATA_START_ADDR+NVMC_MAZE_DATA_SIZE)
+
+#define NVMC_TURN_CAL_DATA_START_ADDR      (NVMC_MAZE_END_ADDR)
+#define NVMC_TURN_CAL_DATA_SIZE            (2*2+3*4+4) /* version and size, steps for 90 degree, nm per step and wheel base 32bit each, checksum with padding */
+#define NVMC_TURN_CAL_END_ADDR             (NVMC_TURN_CAL_DATA_START_ADDR+NVMC_TURN_CAL_DATA_SIZE)
+
+#define NVMC_END_ADDR                      (NVMC_TURN_CAL_END_ADDR) /* end of the last block, update if adding a block */
+
+#if defined(NVMC_FLASH_BLOCK_SIZE) && (NVMC_END_ADDR-NVMC_FLASH_START_ADDR)>NVMC_FLASH_BLOCK_SIZE
+  #error "configuration data does not fit into the flash erase block"
+#endif
+
 /*!
  * \brief Saves the reflectance calibration data
  * \param data Pointer to the data
@@ -70,6 +89,56 @@ uint8_t NVMC_SavePIDData(void *data, uint16_t dataSize);
  */
 void *NVMC_GetPIDData(void);
 
+/*!
+ * \brief Saves the motor linearization tables
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveMotorLinData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the motor linearization tables
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetMotorLinData(void);
+
+/*!
+ * \brief Saves the solved maze
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveMazeData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the solved maze
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetMazeData(void);
+
+/*!
+ * \brief Saves the turn and wheel geometry calibration
+ * \param data Pointer to the data
+ * \param dataSize Size of data in bytes
+ * \return Error code, ERR_OK if everything is fine
+ */
+uint8_t NVMC_SaveTurnCalData(void *data, uint16_t dataSize);
+
+/*!
+ * \brief Returns the turn and wheel geometry calibration
+ * \return Pointer to data, or NULL for failure
+ */
+void *NVMC_GetTurnCalData(void);
+
+/*!
+ * \brief Calculates the Fletcher-16 checksum used to validate the data blocks
+ * \param data Pointer to the data
+ * \param nofBytes Number of bytes, usually the offset of the checksum in the block
+ * \return Checksum
+ */
+uint16_t NVMC_Checksum(const void *data, size_t nofBytes);
+
 /*! \brief Driver initialization  */
 void NVMC_Init(void);
 
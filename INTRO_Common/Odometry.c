@@ -0,0 +1,308 @@
+/**
+ * \file
+ * \brief Odometry.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module integrates the quadrature encoder steps into the robot pose on every RTOS tick.
+ * Position is kept in micrometer and the heading as binary angle (2^32 is a full turn), so no
+ * resolution is lost by integrating the small steps of each tick. The covariance is propagated
+ * with the linearized motion model, assuming a wheel slip variance proportional to the driven steps.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_ODOMETRY
+#include "Odometry.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#include "IntMath.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#define ODO_SLIP_VAR_DIV          16 /* wheel slip variance in steps^2 is number of steps divided by this */
+#define ODO_MAX_COV               1000000000000LL /* limit of the covariance entries (1 m^2, 1 rad^2), avoids overflows */
+#define ODO_MILLION               1000000LL
+
+typedef struct {
+  int32_t xUm, yUm; /* position in micrometer */
+  int32_t remNm; /* not yet integrated distance below one micrometer */
+  uint32_t heading; /* binary angle, 2^32 is a full turn, counter clockwise */
+  int64_t pxx, pxy, pyy; /* position covariance, um^2 */
+  int64_t pxh, pyh; /* covariance position/heading, um*urad */
+  int64_t phh; /* heading variance, urad^2 */
+} ODO_State;
+
+static ODO_State ODO_state; /* updated from the tick hook */
+static Q4CLeft_QuadCntrType ODO_lastLeft; /* encoder positions of last sample */
+static Q4CRight_QuadCntrType ODO_lastRight;
+static bool ODO_isInitialized = FALSE;
+/* wheel geometry, see ODO_SetGeometry() */
+static int32_t ODO_nmPerStep = ODO_UM_PER_STEP*1000; /* driven distance in nanometer for one step */
+static int32_t ODO_steps90 = ODO_STEPS_90; /* steps of each wheel for a 90 degree turn on the spot */
+static int32_t ODO_anglePerDiffStep = (1L<<29)/ODO_STEPS_90; /* binary angle for one step difference between right and left wheel: 90 degree (2^30) is 2*ODO_steps90 */
+static int32_t ODO_uradPerDiffStep = 1570796/(2*ODO_STEPS_90); /* same in micro radian */
+
+/* sin(i*90/64 degree) as Q15, for i=0..64 */
+static const int16_t ODO_SinTable[65] = {
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+  6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+  27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+  32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767,
+};
+
+/*!
+ * \brief Calculates the sine of a binary angle.
+ * \return sin(angle) as Q15
+ */
+static int32_t SinQ15(uint32_t angle) {
+  uint32_t quadrant, idx, frac;
+  int32_t lo, hi, val;
+
+  quadrant = angle>>30;
+  if (quadrant&1) { /* second and fourth quadrant are mirrored */
+    angle = (1UL<<30)-(angle&((1UL<<30)-1));
+  } else {
+    angle &= (1UL<<30)-1;
+  }
+  idx = angle>>24; /* 64 table entries per quadrant */
+  frac = (angle>>8)&0xffff;
+  if (idx>=64) { /* exactly 90 degree */
+    val = ODO_SinTable[64];
+  } else {
+    lo = ODO_SinTable[idx];
+    hi = ODO_SinTable[idx+1];
+    val = lo+(int32_t)(((hi-lo)*(int32_t)frac)>>16);
+  }
+  if (quadrant&2) { /* third and fourth quadrant are negative */
+    val = -val;
+  }
+  return val;
+}
+
+static int32_t CosQ15(uint32_t angle) {
+  return SinQ15(angle+(1UL<<30)); /* cos(a)=sin(a+90) */
+}
+
+static int64_t LimitCov(int64_t val) {
+  if (val>ODO_MAX_COV) {
+    return ODO_MAX_COV;
+  } else if (val<-ODO_MAX_COV) {
+    return -ODO_MAX_COV;
+  }
+  return val;
+}
+
+static void Integrate(ODO_State *s, int32_t deltaLeft, int32_t deltaRight) {
+  uint32_t mid;
+  int32_t distNm, distUm, umPerStep, sinQ, cosQ, a, b;
+  int64_t varDist, varHeading, covDistHeading, slip;
+  int64_t pxx, pxy, pyy, pxh, pyh, phh;
+
+  distNm = ((deltaLeft+deltaRight)*ODO_nmPerStep)/2+s->remNm;
+  distUm = distNm/1000;
+  s->remNm = distNm-distUm*1000; /* keep the rest for the next sample, so nothing is lost */
+  umPerStep = ODO_nmPerStep/1000;
+  mid = s->heading+(uint32_t)(((deltaRight-deltaLeft)*ODO_anglePerDiffStep)/2); /* heading in the middle of the movement */
+  sinQ = SinQ15(mid);
+  cosQ = CosQ15(mid);
+  /* pose */
+  s->xUm += (distUm*cosQ+(1<<14))>>15;
+  s->yUm += (distUm*sinQ+(1<<14))>>15;
+  s->heading += (uint32_t)((deltaRight-deltaLeft)*ODO_anglePerDiffStep);
+  /* covariance: P = F*P*F' with the motion Jacobian F, using the old values on the right side */
+  a = -((distUm*sinQ)>>15); /* d(x)/d(heading), in um per rad */
+  b = (distUm*cosQ)>>15; /* d(y)/d(heading) */
+  pxx = s->pxx; pxy = s->pxy; pyy = s->pyy;
+  pxh = s->pxh; pyh = s->pyh; phh = s->phh;
+  s->pxx = pxx + (2*a*pxh)/ODO_MILLION + (((a*phh)/ODO_MILLION)*a)/ODO_MILLION;
+  s->pxy = pxy + (a*pyh+b*pxh)/ODO_MILLION + (((a*phh)/ODO_MILLION)*b)/ODO_MILLION;
+  s->pyy = pyy + (2*b*pyh)/ODO_MILLION + (((b*phh)/ODO_MILLION)*b)/ODO_MILLION;
+  s->pxh = pxh + (a*phh)/ODO_MILLION;
+  s->pyh = pyh + (b*phh)/ODO_MILLION;
+  /* add wheel slip noise, variance for each wheel is number of steps/ODO_SLIP_VAR_DIV */
+  slip = IMATH_Abs32(deltaLeft)+IMATH_Abs32(deltaRight);
+  varDist = (slip*umPerStep*umPerStep)/(4*ODO_SLIP_VAR_DIV);
+  varHeading = (slip*ODO_uradPerDiffStep*ODO_uradPerDiffStep)/ODO_SLIP_VAR_DIV;
+  covDistHeading = ((int64_t)(IMATH_Abs32(deltaRight)-IMATH_Abs32(deltaLeft))*umPerStep*ODO_uradPerDiffStep)/(2*ODO_SLIP_VAR_DIV);
+  s->pxx = LimitCov(s->pxx + ((varDist*cosQ>>15)*cosQ>>15));
+  s->pxy = LimitCov(s->pxy + ((varDist*cosQ>>15)*sinQ>>15));
+  s->pyy = LimitCov(s->pyy + ((varDist*sinQ>>15)*sinQ>>15));
+  s->pxh = LimitCov(s->pxh + (covDistHeading*cosQ>>15));
+  s->pyh = LimitCov(s->pyh + (covDistHeading*sinQ>>15));
+  s->phh = LimitCov(phh + varHeading);
+}
+
+void ODO_Sample(void) {
+  Q4CLeft_QuadCntrType left;
+  Q4CRight_QuadCntrType right;
+  int32_t deltaLeft, deltaRight;
+
+  if (!ODO_isInitialized) {
+    return;
+  }
+  left = Q4CLeft_GetPos();
+  right = Q4CRight_GetPos();
+  deltaLeft = (int32_t)(left-ODO_lastLeft);
+  deltaRight = (int32_t)(right-ODO_lastRight);
+  if (deltaLeft==0 && deltaRight==0) {
+    return; /* not moved */
+  }
+  ODO_lastLeft = left;
+  ODO_lastRight = right;
+  Integrate(&ODO_state, deltaLeft, deltaRight);
+}
+
+void ODO_GetPose(ODO_Pose *pose, ODO_Covariance *cov) {
+  ODO_State state;
+
+  FRTOS1_taskENTER_CRITICAL();
+  state = ODO_state;
+  FRTOS1_taskEXIT_CRITICAL();
+  pose->x = state.xUm/1000;
+  pose->y = state.yUm/1000;
+  pose->heading = (int16_t)(((int64_t)(int32_t)state.heading*3600)>>32); /* binary angle to 0.1 degree */
+  if (cov!=NULL) {
+    cov->xx = (int32_t)(state.pxx/ODO_MILLION);
+    cov->xy = (int32_t)(state.pxy/ODO_MILLION);
+    cov->yy = (int32_t)(state.pyy/ODO_MILLION);
+    cov->xh = (int32_t)(state.pxh/ODO_MILLION);
+    cov->yh = (int32_t)(state.pyh/ODO_MILLION);
+    cov->hh = (int32_t)(state.phh/ODO_MILLION);
+  }
+}
+
+void ODO_SetPose(const ODO_Pose *pose) {
+  ODO_State state;
+
+  state.xUm = pose->x*1000;
+  state.yUm = pose->y*1000;
+  state.remNm = 0;
+  state.heading = (uint32_t)(((int64_t)pose->heading*4294967296LL)/3600); /* 0.1 degree to binary angle */
+  state.pxx = state.pxy = state.pyy = 0;
+  state.pxh = state.pyh = state.phh = 0;
+  FRTOS1_taskENTER_CRITICAL();
+  ODO_state = state;
+  FRTOS1_taskEXIT_CRITICAL();
+}
+
+void ODO_Reset(void) {
+  ODO_Pose pose;
+
+  pose.x = 0;
+  pose.y = 0;
+  pose.heading = 0;
+  ODO_SetPose(&pose);
+}
+
+void ODO_SetGeometry(int32_t nmPerStep, int32_t steps90) {
+  if (nmPerStep<=0 || steps90<=0) {
+    return; /* invalid */
+  }
+  FRTOS1_taskENTER_CRITICAL(); /* used from the tick hook */
+  ODO_nmPerStep = nmPerStep;
+  ODO_steps90 = steps90;
+  ODO_anglePerDiffStep = (1L<<29)/steps90;
+  ODO_uradPerDiffStep = 1570796/(2*steps90);
+  FRTOS1_taskEXIT_CRITICAL();
+}
+
+int32_t ODO_GetSteps90(void) {
+  return ODO_steps90;
+}
+
+int32_t ODO_StepsToMm(int32_t steps) {
+  return (int32_t)(((int64_t)steps*ODO_nmPerStep)/1000000);
+}
+
+int32_t ODO_MmToSteps(int32_t mm) {
+  return (int32_t)(((int64_t)mm*1000000)/ODO_nmPerStep);
+}
+
+int32_t ODO_GetDrivenSteps(void) {
+  return ((int32_t)Q4CLeft_GetPos()+(int32_t)Q4CRight_GetPos())/2;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void ODO_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"odo", (unsigned char*)"Group of odometry commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows odometry help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Sets the pose to the origin\r\n", io->stdOut);
+}
+
+static void ODO_PrintStatus(const CLS1_StdIOType *io) {
+  ODO_Pose pose;
+  ODO_Covariance cov;
+  uint8_t buf[48];
+
+  ODO_GetPose(&pose, &cov);
+  CLS1_SendStatusStr((unsigned char*)"odo", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"x: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), pose.x);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, y: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), pose.y);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  position", buf, io->stdOut);
+  buf[0] = '\0';
+  if (pose.heading<0) {
+    UTIL1_chcat(buf, sizeof(buf), '-');
+    pose.heading = -pose.heading;
+  }
+  UTIL1_strcatNum16s(buf, sizeof(buf), pose.heading/10);
+  UTIL1_chcat(buf, sizeof(buf), '.');
+  UTIL1_strcatNum16s(buf, sizeof(buf), pose.heading%10);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" deg\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  heading", buf, io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"x: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), IMATH_Sqrt32(cov.xx));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, y: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), IMATH_Sqrt32(cov.yy));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, h: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), IMATH_Sqrt32(cov.hh));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mrad\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  std dev", buf, io->stdOut);
+  UTIL1_Num32sToStr(buf, sizeof(buf), ODO_nmPerStep);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" nm/step, 90 deg: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), ODO_steps90);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  geometry", buf, io->stdOut);
+}
+
+uint8_t ODO_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"odo help")==0) {
+    ODO_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"odo status")==0) {
+    ODO_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"odo reset")==0) {
+    ODO_Reset();
+    *handled = TRUE;
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void ODO_Deinit(void) {
+  ODO_isInitialized = FALSE;
+}
+
+void ODO_Init(void) {
+  ODO_lastLeft = Q4CLeft_GetPos();
+  ODO_lastRight = Q4CRight_GetPos();
+  ODO_Reset();
+  ODO_isInitialized = TRUE;
+}
+
+#endif /* PL_CONFIG_HAS_ODOMETRY */
@@ -0,0 +1,114 @@
+/**
+ * \file
+ * \brief Interface to the odometry.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module integrates the quadrature encoder steps into the robot pose (position and heading),
+ * together with the covariance of the pose. It is the common position source for turning, maze and sumo.
+ */
+
+#ifndef ODOMETRY_H_
+#define ODOMETRY_H_
+
+#include "Platform.h"
+
+/*! \todo adopt the values for your robot */
+#define ODO_STEPS_90            700 /*!< default number of steps for a 90 degree turn on the spot, same as TURN_STEPS_90 */
+#define ODO_UM_PER_STEP         100 /*!< default driven distance in micrometer for one quadrature step */
+
+#if PL_CONFIG_HAS_ODOMETRY
+
+/*!
+ * \brief Robot pose. At reset, the robot is at the origin, looking along the x axis.
+ */
+typedef struct {
+  int32_t x; /*!< x position in mm */
+  int32_t y; /*!< y position in mm, positive to the left of the start heading */
+  int16_t heading; /*!< heading in 0.1 degree (-1800..1799), counter clockwise is positive */
+} ODO_Pose;
+
+/*!
+ * \brief Covariance of the pose.
+ */
+typedef struct {
+  int32_t xx, xy, yy; /*!< position covariance, in mm^2 */
+  int32_t xh, yh; /*!< covariance of position and heading, in mm*mrad */
+  int32_t hh; /*!< heading variance, in mrad^2 */
+} ODO_Covariance;
+
+/*!
+ * \brief Returns the current pose.
+ * \param pose Where to store the pose.
+ * \param cov Where to store the covariance of the pose, can be NULL.
+ */
+void ODO_GetPose(ODO_Pose *pose, ODO_Covariance *cov);
+
+/*!
+ * \brief Sets the pose, e.g. at a known position. The covariance is cleared.
+ * \param pose New pose.
+ */
+void ODO_SetPose(const ODO_Pose *pose);
+
+/*!
+ * \brief Resets the pose to the origin and clears the covariance.
+ */
+void ODO_Reset(void);
+
+/*!
+ * \brief Integrates the encoder steps since the last call. Called from the RTOS tick hook.
+ */
+void ODO_Sample(void);
+
+/*!
+ * \brief Sets the wheel geometry, e.g. from a calibration. Default is ODO_UM_PER_STEP and ODO_STEPS_90.
+ * \param nmPerStep Driven distance in nanometer for one quadrature step.
+ * \param steps90 Number of steps of each wheel for a 90 degree turn on the spot.
+ */
+void ODO_SetGeometry(int32_t nmPerStep, int32_t steps90);
+
+/*!
+ * \brief Returns the number of steps of each wheel for a 90 degree turn on the spot.
+ */
+int32_t ODO_GetSteps90(void);
+
+/*!
+ * \brief Converts encoder steps into a distance.
+ * \param steps Number of steps.
+ * \return Distance in mm.
+ */
+int32_t ODO_StepsToMm(int32_t steps);
+
+/*!
+ * \brief Converts a distance into encoder steps.
+ * \param mm Distance in mm.
+ * \return Number of steps.
+ */
+int32_t ODO_MmToSteps(int32_t mm);
+
+/*!
+ * \brief Returns the distance driven by the center of the robot, the average of both encoder positions.
+ * \return Number of steps since the encoders have been reset.
+ */
+int32_t ODO_GetDrivenSteps(void);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t ODO_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void ODO_Deinit(void);
+
+/*! \brief Initialization of the module */
+void ODO_Init(void);
+
+#endif /* PL_CONFIG_HAS_ODOMETRY */
+
+#endif /* ODOMETRY_H_ */
@@ -0,0 +1,168 @@
+/**
+ * \file
+ * \brief Opponent position estimation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The ToF sensors only see the opponent while it is in one of the narrow sensor cones,
+ * so between measurements the position is propagated with the robot motion.
+ * Hardware independent, so it can be compiled for the host with OPPT_HOST defined (see INTRO_HostTest).
+ */
+
+#ifdef OPPT_HOST
+  #define OPPT_ENABLED  1
+#else
+  #include "Platform.h"
+  #define OPPT_ENABLED  PL_CONFIG_HAS_OPPONENT
+#endif
+#if OPPT_ENABLED
+#include "OppTrack.h"
+#include "IntMath.h"
+
+/*! \todo adopt the values for your robot */
+#define OPPT_SENSOR_OFFSET_MM      40  /*!< distance of the ToF sensors from the robot center */
+
+#define OPPT_MAX_RANGE_MM          500 /*!< ToF measurements above this range are ignored */
+#define OPPT_GATE_MM               150 /*!< measurements closer than this to the track are fused, otherwise they start a new track */
+#define OPPT_GAIN_256              160 /*!< measurement gain (0..256) when fusing into the track */
+#define OPPT_MEAS_UNCERTAINTY_MM   30  /*!< uncertainty of a measurement */
+#define OPPT_DRIFT_MM_PER_S        300 /*!< assumed maximum opponent speed, increases uncertainty over time */
+#define OPPT_MAX_UNCERTAINTY_MM    250 /*!< track gets dropped above this uncertainty */
+#define OPPT_MAX_ROTATION_MRAD     100 /*!< rotations are applied in steps of this size, for the small angle approximation */
+
+/*!
+ * \brief Calculates atan(z) for z in the range 0..1024 (0..1.0)
+ * \return Angle in degrees (0..45), error is below 0.5 degree.
+ */
+static int32_t Atan1Deg(int32_t z1024) {
+  /* atan(z) ~ pi/4*z + 0.273*z*(1-z) [rad] = 45*z + 15.64*z*(1-z) [deg] */
+  return (45*z1024 + ((z1024*(1024-z1024))/1024)*1564/100 + 512)/1024;
+}
+
+static int16_t Atan2Deg(int32_t y, int32_t x) {
+  int32_t ax, ay, deg;
+
+  ax = IMATH_Abs32(x);
+  ay = IMATH_Abs32(y);
+  if (ax==0 && ay==0) {
+    return 0;
+  }
+  if (ax>=ay) {
+    deg = Atan1Deg((ay*1024)/ax);
+  } else {
+    deg = 90-Atan1Deg((ax*1024)/ay);
+  }
+  if (x<0) {
+    deg = 180-deg;
+  }
+  if (y<0) {
+    deg = -deg;
+  }
+  return (int16_t)deg;
+}
+
+void OPPT_Init(OPPT_Tracker *tracker) {
+  tracker->valid = 0;
+  tracker->x = 0;
+  tracker->y = 0;
+  tracker->uncertainty = OPPT_MAX_UNCERTAINTY_MM;
+  tracker->ageMs = 0;
+  tracker->nofUpdates = 0;
+}
+
+static void Rotate(OPPT_Tracker *tracker, int32_t mrad) {
+  int32_t s, c, x, y;
+
+  /* robot turns by mrad (counter clockwise), so the opponent turns by -mrad in the robot frame.
+   * Small angle approximation: sin(a)=a, cos(a)=1-a*a/2 */
+  s = mrad; /* sin*1000 */
+  c = 1000-(mrad*mrad)/2000; /* cos*1000 */
+  x = tracker->x;
+  y = tracker->y;
+  tracker->x = (c*x+s*y)/1000;
+  tracker->y = (c*y-s*x)/1000;
+}
+
+void OPPT_Predict(OPPT_Tracker *tracker, int32_t distMm, int32_t rotMrad, uint32_t deltaMs) {
+  int32_t absRotMrad, step, range;
+
+  tracker->ageMs += deltaMs;
+  if (!tracker->valid) {
+    return;
+  }
+  absRotMrad = IMATH_Abs32(rotMrad);
+  /* robot moves forward: opponent comes closer */
+  tracker->x -= distMm;
+  while (rotMrad!=0) {
+    step = rotMrad;
+    if (step>OPPT_MAX_ROTATION_MRAD) {
+      step = OPPT_MAX_ROTATION_MRAD;
+    } else if (step<-OPPT_MAX_ROTATION_MRAD) {
+      step = -OPPT_MAX_ROTATION_MRAD;
+    }
+    Rotate(tracker, step);
+    rotMrad -= step;
+  }
+  /* the longer we do not see it, and the more we move, the less we know where it is */
+  range = IMATH_Abs32(tracker->x)+IMATH_Abs32(tracker->y);
+  tracker->uncertainty += (OPPT_DRIFT_MM_PER_S*(int32_t)deltaMs)/1000
+                        + IMATH_Abs32(distMm)/10
+                        + (absRotMrad*range)/10000;
+  if (tracker->uncertainty>OPPT_MAX_UNCERTAINTY_MM) {
+    tracker->valid = 0; /* lost it */
+  }
+}
+
+void OPPT_Update(OPPT_Tracker *tracker, const int16_t range[OPPT_NOF_SENSORS]) {
+  int32_t x, y, zx, zy, dist, bestDist = -1;
+  int i;
+
+  zx = zy = 0;
+  for(i=0;i<OPPT_NOF_SENSORS;i++) {
+    if (range[i]<0 || range[i]>OPPT_MAX_RANGE_MM) {
+      continue; /* no object or sensor failure */
+    }
+    x = y = 0;
+    switch(i) {
+      case OPPT_SENSOR_FRONT: x = range[i]+OPPT_SENSOR_OFFSET_MM; break;
+      case OPPT_SENSOR_REAR:  x = -(range[i]+OPPT_SENSOR_OFFSET_MM); break;
+      case OPPT_SENSOR_LEFT:  y = range[i]+OPPT_SENSOR_OFFSET_MM; break;
+      case OPPT_SENSOR_RIGHT: y = -(range[i]+OPPT_SENSOR_OFFSET_MM); break;
+      default: break;
+    }
+    if (tracker->valid) { /* use measurement closest to the track */
+      dist = IMATH_Abs32(x-tracker->x)+IMATH_Abs32(y-tracker->y);
+    } else { /* use the closest object */
+      dist = IMATH_Abs32(x)+IMATH_Abs32(y);
+    }
+    if (bestDist<0 || dist<bestDist) {
+      bestDist = dist;
+      zx = x;
+      zy = y;
+    }
+  }
+  if (bestDist<0) {
+    return; /* nothing measured */
+  }
+  if (tracker->valid && (bestDist<=OPPT_GATE_MM || bestDist<=tracker->uncertainty)) {
+    tracker->x += ((zx-tracker->x)*OPPT_GAIN_256)/256;
+    tracker->y += ((zy-tracker->y)*OPPT_GAIN_256)/256;
+  } else { /* start new track */
+    tracker->x = zx;
+    tracker->y = zy;
+    tracker->valid = 1;
+  }
+  tracker->uncertainty = OPPT_MEAS_UNCERTAINTY_MM;
+  tracker->ageMs = 0;
+  tracker->nofUpdates++;
+}
+
+uint8_t OPPT_GetTarget(const OPPT_Tracker *tracker, int16_t *bearingDeg, int16_t *rangeMm) {
+  if (!tracker->valid) {
+    return 0;
+  }
+  *bearingDeg = Atan2Deg(tracker->y, tracker->x);
+  *rangeMm = (int16_t)IMATH_Sqrt32(tracker->x*tracker->x+tracker->y*tracker->y);
+  return 1;
+}
+
+#endif /* OPPT_ENABLED */
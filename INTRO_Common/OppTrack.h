@@ -0,0 +1,68 @@
+/**
+ * \file
+ * \brief Interface to the opponent position estimation.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module keeps an estimate of the opponent position in the robot frame. The estimate is updated with the
+ * ToF sensor ranges and propagated with the robot motion. It only uses integer math and no hardware or RTOS, so it
+ * is used by the opponent module on the robot and by the scripted opponent simulation in INTRO_HostTest.
+ */
+
+#ifndef OPPTRACK_H_
+#define OPPTRACK_H_
+
+#include <stdint.h>
+
+#define OPPT_NOF_SENSORS   4 /*!< number of distance sensors: front, rear, left and right */
+
+typedef enum {
+  OPPT_SENSOR_FRONT = 0,
+  OPPT_SENSOR_REAR  = 1,
+  OPPT_SENSOR_LEFT  = 2,
+  OPPT_SENSOR_RIGHT = 3
+} OPPT_SensorPos;
+
+/*!
+ * \brief Tracker state. x is pointing forward and y to the left side of the robot, origin is the center of the robot.
+ */
+typedef struct {
+  uint8_t valid; /*!< if we are tracking an opponent */
+  int32_t x; /*!< opponent position in robot frame, in mm */
+  int32_t y; /*!< opponent position in robot frame, in mm */
+  int32_t uncertainty; /*!< position uncertainty in mm, grows without measurements */
+  uint32_t ageMs; /*!< time since last measurement in ms */
+  uint32_t nofUpdates; /*!< number of measurements fused into the track */
+} OPPT_Tracker;
+
+/*!
+ * \brief Initializes a tracker, no opponent is tracked afterwards.
+ * \param tracker Tracker to initialize.
+ */
+void OPPT_Init(OPPT_Tracker *tracker);
+
+/*!
+ * \brief Propagates the opponent position with the robot motion. Assumes that the opponent stands still.
+ * \param tracker Tracker to update.
+ * \param distMm Distance driven forward since last call, in mm.
+ * \param rotMrad Rotation (counter clockwise) since last call, in milli-radians.
+ * \param deltaMs Time since last call in ms.
+ */
+void OPPT_Predict(OPPT_Tracker *tracker, int32_t distMm, int32_t rotMrad, uint32_t deltaMs);
+
+/*!
+ * \brief Fuses the distance sensor measurements into the track.
+ * \param tracker Tracker to update.
+ * \param range Range for each sensor in mm (index is OPPT_SensorPos), negative values for no object or sensor errors.
+ */
+void OPPT_Update(OPPT_Tracker *tracker, const int16_t range[OPPT_NOF_SENSORS]);
+
+/*!
+ * \brief Returns the tracked opponent as pursuit target.
+ * \param tracker Tracker.
+ * \param bearingDeg Where to store the bearing in degrees, 0 is straight ahead, positive values are to the left, negative ones to the right.
+ * \param rangeMm Where to store the distance to the opponent in mm.
+ * \return 1 if an opponent is tracked, 0 otherwise.
+ */
+uint8_t OPPT_GetTarget(const OPPT_Tracker *tracker, int16_t *bearingDeg, int16_t *rangeMm);
+
+#endif /* OPPTRACK_H_ */
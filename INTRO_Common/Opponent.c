@@ -0,0 +1,157 @@
+/**
+ * \file
+ * \brief Opponent tracker.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module runs the opponent tracker of OppTrack.c for the sumo strategy: it feeds it with the
+ * ToF ranges and with the robot motion, measured by the wheel encoders and converted with the
+ * (calibrated) wheel geometry of the odometry module.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_OPPONENT
+#include "Opponent.h"
+#include "OppTrack.h"
+#include "Distance.h"
+#include "Odometry.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
+#include "FRTOS1.h"
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#define OPP_TASK_PERIOD_MS        10  /*!< tracker update period */
+
+static OPPT_Tracker OPP_Track; /* tracker used by the task */
+static OPPT_Tracker OPP_PublishedTrack; /* copy of the tracker for OPP_GetTarget() */
+static volatile bool OPP_ResetRequest = FALSE; /* set to reset the track from the task */
+
+bool OPP_GetTarget(int16_t *bearingDeg, int16_t *rangeMm) {
+  OPPT_Tracker tracker;
+
+  FRTOS1_taskENTER_CRITICAL();
+  tracker = OPP_PublishedTrack;
+  FRTOS1_taskEXIT_CRITICAL();
+  return OPPT_GetTarget(&tracker, bearingDeg, rangeMm)!=0;
+}
+
+void OPP_Reset(void) {
+  OPP_ResetRequest = TRUE; /* will be done by the task */
+}
+
+/* driven distance (mm) and rotation (mrad) out of the wheel positions, with the odometry geometry */
+static void WheelMotion(int32_t left, int32_t right, int32_t *distMm, int32_t *rotMrad) {
+  *distMm = ODO_StepsToMm((left+right)/2);
+  /* a 90 degree (1571 mrad) turn on the spot moves the wheels ODO_GetSteps90() in opposite directions */
+  *rotMrad = (int32_t)(((int64_t)(right-left)*1571)/(2*ODO_GetSteps90()));
+}
+
+static void OppTask(void *pvParameters) {
+  TickType_t xLastWakeTime;
+  int32_t currDist, currRot, lastDist, lastRot;
+  int16_t range[OPPT_NOF_SENSORS];
+
+  (void)pvParameters;
+  /* convert the absolute wheel positions and use the difference, so the rounding does not add up */
+  WheelMotion((int32_t)Q4CLeft_GetPos(), (int32_t)Q4CRight_GetPos(), &lastDist, &lastRot);
+  xLastWakeTime = FRTOS1_xTaskGetTickCount();
+  for(;;) {
+    if (OPP_ResetRequest) {
+      OPP_ResetRequest = FALSE;
+      OPPT_Init(&OPP_Track);
+    }
+    WheelMotion((int32_t)Q4CLeft_GetPos(), (int32_t)Q4CRight_GetPos(), &currDist, &currRot);
+    OPPT_Predict(&OPP_Track, currDist-lastDist, currRot-lastRot, OPP_TASK_PERIOD_MS);
+    lastDist = currDist;
+    lastRot = currRot;
+    range[OPPT_SENSOR_FRONT] = DIST_GetDistance(DIST_SENSOR_FRONT);
+    range[OPPT_SENSOR_REAR] = DIST_GetDistance(DIST_SENSOR_REAR);
+    range[OPPT_SENSOR_LEFT] = DIST_GetDistance(DIST_SENSOR_LEFT);
+    range[OPPT_SENSOR_RIGHT] = DIST_GetDistance(DIST_SENSOR_RIGHT);
+    OPPT_Update(&OPP_Track, range);
+    FRTOS1_taskENTER_CRITICAL();
+    OPP_PublishedTrack = OPP_Track;
+    FRTOS1_taskEXIT_CRITICAL();
+    FRTOS1_vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(OPP_TASK_PERIOD_MS));
+  }
+}
+
+#if PL_CONFIG_HAS_SHELL
+static void OPP_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"opp", (unsigned char*)"Group of opponent tracker commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows opponent help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Forget the current opponent track\r\n", io->stdOut);
+}
+
+static void OPP_PrintStatus(const CLS1_StdIOType *io) {
+  OPPT_Tracker tracker;
+  int16_t bearing, range;
+  uint8_t buf[48];
+
+  FRTOS1_taskENTER_CRITICAL();
+  tracker = OPP_PublishedTrack;
+  FRTOS1_taskEXIT_CRITICAL();
+  CLS1_SendStatusStr((unsigned char*)"opp", (unsigned char*)"\r\n", io->stdOut);
+  if (OPPT_GetTarget(&tracker, &bearing, &range)) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"yes\r\n");
+  } else {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"no\r\n");
+    bearing = range = 0;
+  }
+  CLS1_SendStatusStr((unsigned char*)"  tracking", buf, io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"x: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), tracker.x);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm, y: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), tracker.y);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  position", buf, io->stdOut);
+  UTIL1_Num16sToStr(buf, sizeof(buf), bearing);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" deg, ");
+  UTIL1_strcatNum16s(buf, sizeof(buf), range);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  target", buf, io->stdOut);
+  UTIL1_Num32sToStr(buf, sizeof(buf), tracker.uncertainty);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" mm\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  uncertainty", buf, io->stdOut);
+  UTIL1_Num32sToStr(buf, sizeof(buf), (int32_t)tracker.ageMs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms, updates: ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), tracker.nofUpdates);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  age", buf, io->stdOut);
+}
+
+uint8_t OPP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"opp help")==0) {
+    OPP_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"opp status")==0) {
+    OPP_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"opp reset")==0) {
+    OPP_Reset();
+    *handled = TRUE;
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void OPP_Deinit(void) {
+  /* nothing needed */
+}
+
+void OPP_Init(void) {
+  OPPT_Init(&OPP_Track);
+  OPP_PublishedTrack = OPP_Track;
+  if (xTaskCreate(OppTask, "Opponent", 400/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+2, NULL) != pdPASS) {
+    for(;;){} /* error */
+  }
+}
+
+#endif /* PL_CONFIG_HAS_OPPONENT */
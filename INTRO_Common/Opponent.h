@@ -0,0 +1,49 @@
+/**
+ * \file
+ * \brief Interface to the opponent tracker.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module keeps an estimate of the opponent position in the robot frame (see OppTrack.h).
+ * The estimate is updated with the ToF sensors and propagated with the wheel odometry.
+ */
+
+#ifndef OPPONENT_H_
+#define OPPONENT_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_OPPONENT
+
+/*!
+ * \brief Returns the opponent as pursuit target.
+ * \param bearingDeg Where to store the bearing in degrees, 0 is straight ahead, positive values are to the left, negative ones to the right.
+ * \param rangeMm Where to store the distance to the opponent in mm.
+ * \return TRUE if an opponent is tracked, FALSE otherwise.
+ */
+bool OPP_GetTarget(int16_t *bearingDeg, int16_t *rangeMm);
+
+/*!
+ * \brief Forgets the current opponent track.
+ */
+void OPP_Reset(void);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t OPP_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void OPP_Deinit(void);
+
+/*! \brief Initialization of the module */
+void OPP_Init(void);
+
+#endif /* PL_CONFIG_HAS_OPPONENT */
+
+#endif /* OPPONENT_H_ */
@@ -16,6 +16,17 @@
   #include "NVM_Config.h"
 #endif
 #include "Reflectance.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
+#include "FRTOS1.h"
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+  #include "PidTune.h"
+  #include "Drive.h"
+  #include "WAIT1.h"
+#endif
 
 /*! \todo Add your own additional configurations as needed */
 typedef struct {
@@ -25,6 +36,13 @@ typedef struct {
 } PIDConfig_t;
 
 static PIDConfig_t config;
+static int8_t PID_speedSaturation[2]; /* limitation of the last speed loop output, left and right, see PID() */
+static int32_t PID_slewLimit = 0; /* maximum change of the motor effort per control cycle, 0 for no limit */
+static int32_t PID_lastEffort[2]; /* last signed motor effort, left and right, used for the slew limit and as auto-tune bias */
+
+void PID_SetSlewLimit(int32_t maxChange) {
+  PID_slewLimit = maxChange;
+}
 
 uint8_t PID_GetPIDConfig(PID_ConfigType type, PID_Config **confP) {
   switch(type) {
@@ -49,14 +67,25 @@ uint8_t PID_GetPIDConfig(PID_ConfigType type, PID_Config **confP) {
   return ERR_OK;
 }
 
-static int32_t PID(int32_t currVal, int32_t setVal, PID_Config *config) {
+/*!
+ * \brief PID calculation with conditional integration.
+ * \param currVal Current value.
+ * \param setVal Set value.
+ * \param config PID configuration.
+ * \param saturation Limitation of the previous output: >0 if it was limited at the upper end, <0 at the lower end, 0 if not.
+ * The error is not integrated if it would drive the output further into the limitation, which avoids windup.
+ * \return PID output.
+ */
+static int32_t PID(int32_t currVal, int32_t setVal, PID_Config *config, int8_t saturation) {
   int32_t error;
   int32_t pid;
   
   /* perform PID closed control loop calculation */
   error = setVal-currVal; /* calculate error */
   pid = (error*config->pFactor100)/100; /* P part */
-  config->integral += error; /* integrate error */
+  if (!(saturation>0 && error>0) && !(saturation<0 && error<0)) {
+    config->integral += error; /* integrate error */
+  }
   if (config->integral > config->iAntiWindup) {
     config->integral = config->iAntiWindup;
   } else if (config->integral < -config->iAntiWindup) {
@@ -68,12 +97,148 @@ static int32_t PID(int32_t currVal, int32_t setVal, PID_Config *config) {
   return pid;
 }
 
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+/* relay feedback experiment (Astroem-Haegglund), see PidTune.c */
+typedef struct {
+  PID_TuneState state;
+  PID_Config *config; /* loop under test */
+  int32_t scale; /* the loop multiplies the PID value with this factor to get the motor effort */
+  bool withIntegral; /* if the tuned controller uses an integral part */
+  PIDT_Relay relay; /* relay experiment */
+} PID_AutoTuneDesc;
+
+static PID_AutoTuneDesc PID_tune;
+
+uint8_t PID_AutoTuneCalcGains(int32_t relayAmplitude, int32_t oscAmplitude, int32_t periodSamples, int32_t scale, bool withIntegral, PID_Config *config) {
+  PIDT_Gains gains;
+
+  if (!PIDT_CalcGains(relayAmplitude, oscAmplitude, periodSamples, scale, withIntegral, &gains)) {
+    return ERR_FAILED;
+  }
+  config->pFactor100 = gains.pFactor100;
+  config->iFactor100 = gains.iFactor100;
+  config->dFactor100 = gains.dFactor100;
+  config->lastError = 0;
+  config->integral = 0;
+  return ERR_OK;
+}
+
+/*!
+ * \brief Runs one control sample of the relay experiment instead of the PID.
+ * \param config Configuration of the calling loop.
+ * \param error Control error (set value minus current value).
+ * \param outP Where to store the relay output, in PID units of the loop.
+ * \return TRUE if the loop is under test and the relay output shall be used.
+ */
+static bool AutoTuneStep(PID_Config *config, int32_t error, int32_t *outP) {
+  int32_t out;
+
+  if (PID_tune.state!=PID_TUNE_RUNNING || PID_tune.config!=config) {
+    return FALSE;
+  }
+  switch(PIDT_RelayStep(&PID_tune.relay, error, &out)) {
+    case PIDT_RELAY_RUNNING:
+      *outP = out/PID_tune.scale;
+      return TRUE;
+    case PIDT_RELAY_DONE:
+      if (PID_AutoTuneCalcGains(PID_tune.relay.amplitude, PID_tune.relay.oscAmplitude, PID_tune.relay.oscPeriod, PID_tune.scale, PID_tune.withIntegral, config)==ERR_OK) {
+        PID_tune.state = PID_TUNE_DONE;
+      } else {
+        PID_tune.state = PID_TUNE_FAILED;
+      }
+      return FALSE; /* continue with the new gains */
+    default:
+      PID_tune.state = PID_TUNE_FAILED;
+      return FALSE;
+  }
+}
+
+uint8_t PID_AutoTuneStart(PID_ConfigType type, int32_t relayAmplitude, int32_t hysteresis) {
+  PID_Config *config;
+  int32_t bias;
+
+  if (PID_GetPIDConfig(type, &config)!=ERR_OK) {
+    return ERR_FAILED;
+  }
+  FRTOS1_taskENTER_CRITICAL();
+  PID_tune.config = config;
+  PID_tune.scale = (type==PID_CONFIG_POS_LEFT || type==PID_CONFIG_POS_RIGHT)?1000:1;
+  PID_tune.withIntegral = !(type==PID_CONFIG_POS_LEFT || type==PID_CONFIG_POS_RIGHT); /* position loops are PD, as the integrator of the robot is enough */
+  switch(type) { /* start with the effort of the settled loop */
+    case PID_CONFIG_SPEED_LEFT:
+    case PID_CONFIG_POS_LEFT:
+      bias = PID_lastEffort[0]; break;
+    case PID_CONFIG_SPEED_RIGHT:
+    case PID_CONFIG_POS_RIGHT:
+      bias = PID_lastEffort[1]; break;
+    default:
+      bias = 0; break;
+  }
+  PIDT_RelayStart(&PID_tune.relay, relayAmplitude, hysteresis, bias);
+  PID_tune.state = PID_TUNE_RUNNING;
+  FRTOS1_taskEXIT_CRITICAL();
+  return ERR_OK;
+}
+
+void PID_AutoTuneStop(void) {
+  FRTOS1_taskENTER_CRITICAL();
+  if (PID_tune.state==PID_TUNE_RUNNING) {
+    PID_tune.state = PID_TUNE_FAILED;
+  }
+  FRTOS1_taskEXIT_CRITICAL();
+}
+
+PID_TuneState PID_AutoTuneGetState(void) {
+  return PID_tune.state;
+}
+#endif /* PL_CONFIG_HAS_PID_AUTOTUNE */
+
+/*!
+ * \brief Limits the change of the motor effort to the slew limit.
+ * \param speedP Pointer to the effort (always positive), updated with the limited effort.
+ * \param directionP Pointer to the direction, updated with the direction of the limited effort.
+ * \param isLeft TRUE for the left motor, FALSE for the right motor.
+ * \return TRUE if the effort has been limited.
+ */
+static bool SlewLimit(int32_t *speedP, MOT_Direction *directionP, bool isLeft) {
+  int32_t effort, last;
+  bool limited = FALSE;
+
+  effort = (*directionP==MOT_DIR_BACKWARD)?-(*speedP):*speedP; /* signed effort */
+  last = PID_lastEffort[isLeft?0:1];
+  if (PID_slewLimit>0) {
+    if (effort>last+PID_slewLimit) {
+      effort = last+PID_slewLimit;
+      limited = TRUE;
+    } else if (effort<last-PID_slewLimit) {
+      effort = last-PID_slewLimit;
+      limited = TRUE;
+    }
+  }
+  PID_lastEffort[isLeft?0:1] = effort;
+  if (effort<0) {
+    *speedP = -effort;
+    *directionP = MOT_DIR_BACKWARD;
+  } else {
+    *speedP = effort;
+    *directionP = MOT_DIR_FORWARD;
+  }
+  return limited;
+}
+
 static void PID_SpeedCfg(int32_t currSpeed, int32_t setSpeed, bool isLeft, PID_Config *config) {
-  int32_t speed;
+  int32_t speed, unlimited, effort;
   MOT_Direction direction=MOT_DIR_FORWARD;
   MOT_MotorDevice *motHandle;
   
-  speed = PID(currSpeed, setSpeed, config);
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+  if (!AutoTuneStep(config, setSpeed-currSpeed, &speed)) {
+    speed = PID(currSpeed, setSpeed, config, PID_speedSaturation[isLeft?0:1]);
+  }
+#else
+  speed = PID(currSpeed, setSpeed, config, PID_speedSaturation[isLeft?0:1]);
+#endif
+  unlimited = speed;
   if (speed>=0) {
     direction = MOT_DIR_FORWARD;
   } else { /* negative, make it positive */
@@ -84,13 +249,22 @@ static void PID_SpeedCfg(int32_t currSpeed, int32_t setSpeed, bool isLeft, PID_C
   if (speed>0xFFFF) {
     speed = 0xFFFF;
   }
+  (void)SlewLimit(&speed, &direction, isLeft);
+  effort = (direction==MOT_DIR_BACKWARD)?-speed:speed;
+  if (effort<unlimited) { /* limited by the PWM range or the slew limit: next cycle does not integrate further into it */
+    PID_speedSaturation[isLeft?0:1] = 1;
+  } else if (effort>unlimited) {
+    PID_speedSaturation[isLeft?0:1] = -1;
+  } else {
+    PID_speedSaturation[isLeft?0:1] = 0;
+  }
   /* send new speed values to motor */
   if (isLeft) {
     motHandle = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
   } else {
     motHandle = MOT_GetMotorHandle(MOT_MOTOR_RIGHT);
   }
-  MOT_SetVal(motHandle, 0xFFFF-speed); /* PWM is low active */
+  MOT_SetEffort(motHandle, speed); /* linearized, PWM is low active */
   MOT_SetDirection(motHandle, direction);
   MOT_UpdatePercent(motHandle, direction);
 }
@@ -120,17 +294,159 @@ static uint8_t errorWithinPercent(int32_t error) {
   return error/(REF_MAX_LINE_VALUE/2/100);
 }
 
+/* look-ahead speed planning for line following */
+#define PID_LA_NOF_SAMPLES        16   /* length of the line history */
+#define PID_LA_SAMPLE_STEPS       40   /* driven steps between two history entries */
+#define PID_LA_HEADING_FULL       400  /* wheel step difference over the history for the sharpest bend */
+#define PID_LA_LINE_FULL          1500 /* change of the line position over the history for the sharpest bend */
+#define PID_LA_MIN_SPEED_PERCENT  40   /* speed in the sharpest bend, percent of the maximum speed */
+#define PID_LA_ACCEL_PERCENT      150  /* acceleration, percent of the maximum speed per second */
+#define PID_LA_DECEL_PERCENT      600  /* deceleration, percent of the maximum speed per second */
+
+typedef struct {
+  bool isOn; /* look-ahead mode enabled */
+  bool isStarted; /* history initialized */
+  int32_t lastLeft, lastRight; /* encoder positions of the last call */
+  int32_t dist2; /* two times the driven steps since the last history entry */
+  int32_t diff; /* wheel step difference (right-left) since the last history entry */
+  int32_t lineHist[PID_LA_NOF_SAMPLES]; /* line error at each history entry */
+  int32_t diffHist[PID_LA_NOF_SAMPLES]; /* wheel step difference between the history entries */
+  uint8_t idx, nof; /* next entry and number of entries in the history */
+  int32_t speed; /* planned speed in 0.01% of the maximum speed */
+  uint8_t bendPercent; /* last bend estimate, 100% is the sharpest bend */
+  TickType_t lastTick; /* time of the last call */
+} PID_LookAhead;
+
+static PID_LookAhead PID_la;
+static uint8_t PID_lineSpeedLimit = 100; /* line following speed in percent of the configured maximum speed */
+
+void PID_SetLineSpeedLimit(uint8_t percent) {
+  if (percent>100) {
+    percent = 100;
+  }
+  PID_lineSpeedLimit = percent;
+}
+
+void PID_SetLineLookAhead(bool on) {
+  PID_la.isOn = on;
+  PID_la.isStarted = FALSE;
+}
+
+bool PID_GetLineLookAhead(void) {
+  return PID_la.isOn;
+}
+
+/*!
+ * \brief Plans the line following speed. The curvature is estimated from the history of the line position
+ * (sensor is in front of the wheels, so it sees the bend first) and the heading change over the driven distance.
+ * The speed is reduced ahead of bends and increased on straights, within the acceleration and deceleration limits.
+ * \param error Line error (current minus desired line position).
+ * \param errorPercent Current line error in percent.
+ * \return Planned speed in 0.01% of the maximum speed.
+ */
+static int32_t LookAheadSpeed(int32_t error, uint8_t errorPercent) {
+  int32_t left, right, dl, dr, heading, lineChange, bend, target, dtMs;
+  TickType_t now;
+  int i;
+
+  left = (int32_t)Q4CLeft_GetPos();
+  right = (int32_t)Q4CRight_GetPos();
+  now = FRTOS1_xTaskGetTickCount();
+  if (!PID_la.isStarted) {
+    PID_la.lastLeft = left;
+    PID_la.lastRight = right;
+    PID_la.dist2 = 0;
+    PID_la.diff = 0;
+    PID_la.idx = 0;
+    PID_la.nof = 0;
+    PID_la.speed = PID_LA_MIN_SPEED_PERCENT*100; /* start slow */
+    PID_la.bendPercent = 0;
+    PID_la.lastTick = now;
+    PID_la.isStarted = TRUE;
+    return PID_la.speed;
+  }
+  dl = left-PID_la.lastLeft;
+  dr = right-PID_la.lastRight;
+  PID_la.lastLeft = left;
+  PID_la.lastRight = right;
+  PID_la.dist2 += dl+dr;
+  PID_la.diff += dr-dl;
+  if (PID_la.dist2>=2*PID_LA_SAMPLE_STEPS) { /* new history entry every PID_LA_SAMPLE_STEPS */
+    PID_la.lineHist[PID_la.idx] = error;
+    PID_la.diffHist[PID_la.idx] = PID_la.diff;
+    PID_la.idx = (uint8_t)((PID_la.idx+1)%PID_LA_NOF_SAMPLES);
+    if (PID_la.nof<PID_LA_NOF_SAMPLES) {
+      PID_la.nof++;
+    }
+    PID_la.dist2 = 0;
+    PID_la.diff = 0;
+  }
+  /* bend estimate: heading change and drift of the line over the history, plus the current error */
+  heading = 0;
+  for(i=0;i<PID_la.nof;i++) {
+    heading += PID_la.diffHist[i];
+  }
+  lineChange = 0;
+  if (PID_la.nof>=2) { /* newest minus oldest entry */
+    lineChange = PID_la.lineHist[(PID_la.idx+PID_LA_NOF_SAMPLES-1)%PID_LA_NOF_SAMPLES]
+                -PID_la.lineHist[(PID_la.idx+PID_LA_NOF_SAMPLES-PID_la.nof)%PID_LA_NOF_SAMPLES];
+  }
+  if (heading<0) {
+    heading = -heading;
+  }
+  if (lineChange<0) {
+    lineChange = -lineChange;
+  }
+  bend = (heading*100)/PID_LA_HEADING_FULL+(lineChange*100)/PID_LA_LINE_FULL+errorPercent;
+  if (bend>100) {
+    bend = 100;
+  }
+  PID_la.bendPercent = (uint8_t)bend;
+  target = 10000-((10000-PID_LA_MIN_SPEED_PERCENT*100)*bend)/100;
+  /* limit acceleration and deceleration */
+  dtMs = (int32_t)(now-PID_la.lastTick)*portTICK_PERIOD_MS;
+  PID_la.lastTick = now;
+  if (target>PID_la.speed) {
+    PID_la.speed += (PID_LA_ACCEL_PERCENT*100*dtMs)/1000;
+    if (PID_la.speed>target) {
+      PID_la.speed = target;
+    }
+  } else {
+    PID_la.speed -= (PID_LA_DECEL_PERCENT*100*dtMs)/1000;
+    if (PID_la.speed<target) {
+      PID_la.speed = target;
+    }
+  }
+  return PID_la.speed;
+}
+
 static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config) {
-  int32_t pid, speed, speedL, speedR;
+  int32_t pid, speed, speedL, speedR, maxSpeed, laSpeed = 0;
   uint8_t errorPercent;
   MOT_Direction directionL=MOT_DIR_FORWARD, directionR=MOT_DIR_FORWARD;
 
-  pid = PID(currLine, setLine, config);
+  maxSpeed = (((int32_t)config->maxSpeedPercent)*(0xffff/100)*PID_lineSpeedLimit)/100;
+
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+  if (!AutoTuneStep(config, setLine-currLine, &pid)) {
+    pid = PID(currLine, setLine, config, 0);
+  }
+#else
+  pid = PID(currLine, setLine, config, 0);
+#endif
   errorPercent = errorWithinPercent(currLine-setLine);
+  if (PID_la.isOn) {
+    laSpeed = LookAheadSpeed(currLine-setLine, errorPercent); /* keep the history up to date, even if not used below */
+  }
 
   /* transform into different speed for motors. The PID is used as difference value to the motor PWM */
-  if (errorPercent <= 20) { /* pretty on center: move forward both motors with base speed */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100); /* 100% */
+  if (PID_la.isOn && errorPercent <= 70) { /* planned speed, steer with the PID around it */
+    speed = (maxSpeed*laSpeed)/10000;
+    pid = Limit(pid, -speed, speed);
+    speedR = speed+pid;
+    speedL = speed-pid;
+  } else if (errorPercent <= 20) { /* pretty on center: move forward both motors with base speed */
+    speed = maxSpeed; /* 100% */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = speed;
@@ -141,7 +457,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
     }
   } else if (errorPercent <= 40) {
     /* outside left/right halve position from center, slow down one motor and speed up the other */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*8/10; /* 80% */
+    speed = maxSpeed*8/10; /* 80% */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = speed+pid; /* decrease speed */
@@ -151,7 +467,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
       speedL = speed-pid; /* decrease speed */
     }
   } else if (errorPercent <= 70) {
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*6/10; /* %60 */
+    speed = maxSpeed*6/10; /* %60 */
     pid = Limit(pid, -speed, speed);
     if (pid<0) { /* turn right */
       speedR = 0 /*maxSpeed+pid*/; /* decrease speed */
@@ -162,7 +478,7 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
     }
   } else  {
     /* line is far to the left or right: use backward motor motion */
-    speed = ((int32_t)config->maxSpeedPercent)*(0xffff/100)*10/10; /* %80 */
+    speed = maxSpeed*10/10; /* %80 */
     if (pid<0) { /* turn right */
       speedR = -speed+pid; /* decrease speed */
       speedL = speed-pid; /* increase speed */
@@ -187,9 +503,9 @@ static void PID_LineCfg(uint16_t currLine, uint16_t setLine, PID_Config *config)
     speedR = 0;
   }
   /* send new speed values to motor */
-  MOT_SetVal(MOT_GetMotorHandle(MOT_MOTOR_LEFT), 0xFFFF-speedL); /* PWM is low active */
+  MOT_SetEffort(MOT_GetMotorHandle(MOT_MOTOR_LEFT), speedL); /* linearized, PWM is low active */
   MOT_SetDirection(MOT_GetMotorHandle(MOT_MOTOR_LEFT), directionL);
-  MOT_SetVal(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), 0xFFFF-speedR); /* PWM is low active */
+  MOT_SetEffort(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), speedR); /* linearized, PWM is low active */
   MOT_SetDirection(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), directionR);
 }
 
@@ -216,7 +532,13 @@ static void PID_PosCfg(int32_t currPos, int32_t setPos, bool isLeft, PID_Config
   if (error>-POS_FILTER && error<POS_FILTER) { /* avoid jitter around zero */
     setPos = currPos;
   }
-  speed = PID(currPos, setPos, config);
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+  if (!AutoTuneStep(config, setPos-currPos, &speed)) {
+    speed = PID(currPos, setPos, config, 0);
+  }
+#else
+  speed = PID(currPos, setPos, config, 0);
+#endif
   /* transform into motor speed */
   speed *= 1000; /* scale PID, otherwise we need high PID constants */
   if (speed>=0) {
@@ -237,13 +559,14 @@ static void PID_PosCfg(int32_t currPos, int32_t setPos, bool isLeft, PID_Config
   /* limit speed to maximum value */
   speed = (speed*config->maxSpeedPercent)/100;
 #endif
+  (void)SlewLimit(&speed, &direction, isLeft);
   /* send new speed values to motor */
   if (isLeft) {
     motHandle = MOT_GetMotorHandle(MOT_MOTOR_LEFT);
   } else {
     motHandle = MOT_GetMotorHandle(MOT_MOTOR_RIGHT);
   }
-  MOT_SetVal(motHandle, 0xFFFF-speed); /* PWM is low active */
+  MOT_SetEffort(motHandle, speed); /* linearized, PWM is low active */
   MOT_SetDirection(motHandle, direction);
   MOT_UpdatePercent(motHandle, direction);
 }
@@ -266,6 +589,11 @@ static void PID_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"  pos speed <value>", (unsigned char*)"Maximum speed % value\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  fw (p|i|d|w) <value>", (unsigned char*)"Sets P, I, D or anti-Windup line value\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  fw speed <value>", (unsigned char*)"Maximum speed % value\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  lookahead on|off", (unsigned char*)"Line following speed planned ahead of bends\r\n", io->stdOut);
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+  CLS1_SendHelpStr((unsigned char*)"  tune (speed|pos) (L|R)", (unsigned char*)"Auto-tune speed or position loop with a relay experiment (robot turns on the spot)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  tune fw", (unsigned char*)"Auto-tune line following loop, start line following after it\r\n", io->stdOut);
+#endif
 #if PL_CONFIG_HAS_CONFIG_NVM
   CLS1_SendHelpStr((unsigned char*)"  store", (unsigned char*)"Store PID configuration settings in FLASH\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  load", (unsigned char*)"Load PID configuration settings from FLASH\r\n", io->stdOut);
@@ -320,6 +648,18 @@ static void PrintPIDstatus(PID_Config *config, const unsigned char *kindStr, con
 static void PID_PrintStatus(const CLS1_StdIOType *io) {
   CLS1_SendStatusStr((unsigned char*)"pid", (unsigned char*)"\r\n", io->stdOut);
   PrintPIDstatus(&config.lineFwConfig, (unsigned char*)"fw", io);
+  if (PID_la.isOn) {
+    unsigned char buf[32];
+
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"on, speed ");
+    UTIL1_strcatNum32s(buf, sizeof(buf), PID_la.speed/100);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"%, bend ");
+    UTIL1_strcatNum8u(buf, sizeof(buf), PID_la.bendPercent);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"%\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  lookahead", buf, io->stdOut);
+  } else {
+    CLS1_SendStatusStr((unsigned char*)"  lookahead", (unsigned char*)"off\r\n", io->stdOut);
+  }
   PrintPIDstatus(&config.speedLeftConfig, (unsigned char*)"speed L", io);
   PrintPIDstatus(&config.speedRightConfig, (unsigned char*)"speed R", io);
   PrintPIDstatus(&config.posLeftConfig, (unsigned char*)"pos L", io);
@@ -396,6 +736,102 @@ static uint8_t PID_StoreSettingsToFlash(void) {
   return NVMC_SavePIDData(&config, sizeof(config));
 }
 
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+#define PID_TUNE_SPEED            1000   /* speed set point (steps/sec) for the speed loop experiment */
+#define PID_TUNE_SPEED_AMPLITUDE  0x3000 /* relay amplitude for the speed loops */
+#define PID_TUNE_SPEED_HYSTERESIS 50     /* relay hysteresis for the speed loops, in steps/sec */
+#define PID_TUNE_POS_AMPLITUDE    0x2000 /* relay amplitude for the position loops */
+#define PID_TUNE_POS_HYSTERESIS   2      /* relay hysteresis for the position loops, in steps */
+#define PID_TUNE_LINE_AMPLITUDE   0x2000 /* relay amplitude for the line following loop */
+#define PID_TUNE_LINE_HYSTERESIS  100    /* relay hysteresis for the line following loop */
+#define PID_TUNE_SETTLE_MS        1000   /* time for the loop to settle before the experiment */
+#define PID_TUNE_TIMEOUT_MS       30000  /* maximum time for the experiment */
+
+static uint8_t AutoTune(PID_ConfigType type, const CLS1_StdIOType *io) {
+  uint8_t buf[48];
+  int32_t timeMs;
+  PID_Config *config;
+  uint8_t res;
+  bool cascaded = FALSE;
+#if PL_CONFIG_HAS_TRACTION
+  bool traction;
+
+  traction = DRV_GetTractionControl();
+  DRV_SetTractionControl(FALSE); /* slew limit would distort the experiment */
+#endif
+  (void)PID_GetPIDConfig(type, &config);
+  switch(type) {
+    case PID_CONFIG_SPEED_LEFT:
+    case PID_CONFIG_SPEED_RIGHT:
+      if (type==PID_CONFIG_SPEED_LEFT) {
+        (void)DRV_SetSpeed(PID_TUNE_SPEED, -PID_TUNE_SPEED);
+      } else {
+        (void)DRV_SetSpeed(-PID_TUNE_SPEED, PID_TUNE_SPEED);
+      }
+      (void)DRV_SetMode(DRV_MODE_SPEED);
+      WAIT1_WaitOSms(PID_TUNE_SETTLE_MS); /* relay starts with the settled effort as bias */
+      res = PID_AutoTuneStart(type, PID_TUNE_SPEED_AMPLITUDE, PID_TUNE_SPEED_HYSTERESIS);
+      break;
+    case PID_CONFIG_POS_LEFT:
+    case PID_CONFIG_POS_RIGHT:
+      cascaded = DRV_GetPosCascaded();
+      DRV_SetPosCascaded(FALSE); /* experiment needs the position PID */
+      (void)DRV_SetPos((int32_t)Q4CLeft_GetPos(), (int32_t)Q4CRight_GetPos()); /* oscillate around the current position */
+      (void)DRV_SetMode(DRV_MODE_POS);
+      WAIT1_WaitOSms(PID_TUNE_SETTLE_MS);
+      res = PID_AutoTuneStart(type, PID_TUNE_POS_AMPLITUDE, PID_TUNE_POS_HYSTERESIS);
+      break;
+    default:
+      res = PID_AutoTuneStart(type, PID_TUNE_LINE_AMPLITUDE, PID_TUNE_LINE_HYSTERESIS);
+      CLS1_SendStr((unsigned char*)"Start line following now...\r\n", io->stdOut);
+      break;
+  }
+  if (res==ERR_OK) {
+    CLS1_SendStr((unsigned char*)"Relay experiment running...\r\n", io->stdOut);
+    timeMs = 0;
+    while (PID_AutoTuneGetState()==PID_TUNE_RUNNING && timeMs<PID_TUNE_TIMEOUT_MS) {
+      WAIT1_WaitOSms(50);
+      timeMs += 50;
+    }
+    PID_AutoTuneStop(); /* in case of timeout */
+  }
+  if (type!=PID_CONFIG_LINE_FW) {
+    (void)DRV_SetMode(DRV_MODE_STOP);
+  }
+  if (type==PID_CONFIG_POS_LEFT || type==PID_CONFIG_POS_RIGHT) {
+    DRV_SetPosCascaded(cascaded);
+  }
+#if PL_CONFIG_HAS_TRACTION
+  DRV_SetTractionControl(traction);
+#endif
+  if (res!=ERR_OK || PID_AutoTuneGetState()!=PID_TUNE_DONE) {
+    CLS1_SendStr((unsigned char*)"**** auto-tuning failed, no stable oscillation\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"Oscillation: amplitude ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), PID_tune.relay.oscAmplitude);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", period ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), PID_tune.relay.oscPeriod);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" samples\r\n");
+  CLS1_SendStr(buf, io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"New gains: p: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), config->pFactor100);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" i: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), config->iFactor100);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" d: ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), config->dFactor100);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStr(buf, io->stdOut);
+#if PL_CONFIG_HAS_CONFIG_NVM
+  if (PID_StoreSettingsToFlash()!=ERR_OK) {
+    CLS1_SendStr((unsigned char*)"**** failed saving to FLASH\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+#endif
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_PID_AUTOTUNE */
+
 uint8_t PID_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
   uint8_t res = ERR_OK;
 
@@ -413,9 +849,33 @@ uint8_t PID_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_Std
     res = ParsePidParameter(&config.posLeftConfig, cmd+sizeof("pid pos L ")-1, handled, io);
   } else if (UTIL1_strncmp((char*)cmd, (char*)"pid pos R ", sizeof("pid pos R ")-1)==0) {
     res = ParsePidParameter(&config.posRightConfig, cmd+sizeof("pid pos R ")-1, handled, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"pid lookahead on")==0) {
+    PID_SetLineLookAhead(TRUE);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"pid lookahead off")==0) {
+    PID_SetLineLookAhead(FALSE);
+    *handled = TRUE;
   } else if (UTIL1_strncmp((char*)cmd, (char*)"pid fw ", sizeof("pid fw ")-1)==0) {
     res = ParsePidParameter(&config.lineFwConfig, cmd+sizeof("pid fw ")-1, handled, io);
   }
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+    else if (UTIL1_strcmp((char*)cmd, (char*)"pid tune speed L")==0) {
+    *handled = TRUE;
+    res = AutoTune(PID_CONFIG_SPEED_LEFT, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"pid tune speed R")==0) {
+    *handled = TRUE;
+    res = AutoTune(PID_CONFIG_SPEED_RIGHT, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"pid tune pos L")==0) {
+    *handled = TRUE;
+    res = AutoTune(PID_CONFIG_POS_LEFT, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"pid tune pos R")==0) {
+    *handled = TRUE;
+    res = AutoTune(PID_CONFIG_POS_RIGHT, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"pid tune fw")==0) {
+    *handled = TRUE;
+    res = AutoTune(PID_CONFIG_LINE_FW, io);
+  }
+#endif
 #if PL_CONFIG_HAS_CONFIG_NVM
     else if (UTIL1_strcmp((char*)cmd, (char*)"pid store")==0) {
     *handled = TRUE;
@@ -444,10 +904,12 @@ void PID_Start(void) {
   config.speedLeftConfig.integral = 0;
   config.speedRightConfig.lastError = 0;
   config.speedRightConfig.integral = 0;
+  PID_speedSaturation[0] = PID_speedSaturation[1] = 0;
   config.posLeftConfig.lastError = 0;
   config.posLeftConfig.integral = 0;
   config.posRightConfig.lastError = 0;
   config.posRightConfig.integral = 0;
+  PID_la.isStarted = FALSE; /* restart the look-ahead history */
 }
 
 void PID_Deinit(void) {
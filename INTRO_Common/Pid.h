@@ -31,6 +31,48 @@ typedef struct {
 
 uint8_t PID_GetPIDConfig(PID_ConfigType config, PID_Config **confP);
 
+#if PL_CONFIG_HAS_PID_AUTOTUNE
+typedef enum {
+  PID_TUNE_IDLE,    /*!< no auto-tuning started */
+  PID_TUNE_RUNNING, /*!< relay experiment is running */
+  PID_TUNE_DONE,    /*!< experiment finished, new gains are in the configuration */
+  PID_TUNE_FAILED,  /*!< experiment failed or was stopped, configuration is unchanged */
+} PID_TuneState;
+
+/*!
+ * \brief Starts a relay feedback experiment for a loop: the next time the loop runs, it uses a relay instead of the PID,
+ * measures the resulting oscillation and replaces the P, I and D gains with the computed ones.
+ * \param type Loop to be tuned.
+ * \param relayAmplitude Relay amplitude, in motor effort (0xffff is full speed).
+ * \param hysteresis Relay hysteresis, in units of the control error, to ignore noise.
+ * \return ERR_OK if started, ERR_FAILED for an unknown loop.
+ */
+uint8_t PID_AutoTuneStart(PID_ConfigType type, int32_t relayAmplitude, int32_t hysteresis);
+
+/*!
+ * \brief Stops a running experiment, the configuration is not changed.
+ */
+void PID_AutoTuneStop(void);
+
+/*!
+ * \brief Returns the state of the auto-tuning.
+ * \return Auto-tuning state.
+ */
+PID_TuneState PID_AutoTuneGetState(void);
+
+/*!
+ * \brief Computes the gains out of the relay experiment result (Ziegler-Nichols) and stores them in the configuration, see PIDT_CalcGains().
+ * \param relayAmplitude Relay amplitude, in motor effort.
+ * \param oscAmplitude Amplitude of the oscillation of the control error.
+ * \param periodSamples Period of the oscillation, in control samples.
+ * \param scale Factor the loop multiplies the PID value with to get the motor effort.
+ * \param withIntegral TRUE for a PID controller, FALSE for a PD controller.
+ * \param config Configuration where P, I and D are stored.
+ * \return ERR_OK if the gains have been computed, ERR_FAILED if the oscillation is not usable.
+ */
+uint8_t PID_AutoTuneCalcGains(int32_t relayAmplitude, int32_t oscAmplitude, int32_t periodSamples, int32_t scale, bool withIntegral, PID_Config *config);
+#endif /* PL_CONFIG_HAS_PID_AUTOTUNE */
+
 #if PL_CONFIG_HAS_SHELL
 #include "CLS1.h"
 /*!
@@ -65,6 +107,31 @@ void PID_Pos(int32_t currPos, int32_t setPos, bool isLeft);
  */
 void PID_Line(uint16_t currLine, uint16_t setLine);
 
+/*!
+ * \brief Enables or disables the look-ahead speed planning for line following. Without it, the speed
+ * is selected from fixed bands of the current line error.
+ * \param on TRUE to plan the speed from the estimated curvature of the line.
+ */
+void PID_SetLineLookAhead(bool on);
+
+/*!
+ * \brief Returns if the look-ahead speed planning for line following is enabled.
+ * \return TRUE if enabled.
+ */
+bool PID_GetLineLookAhead(void);
+
+/*!
+ * \brief Limits the line following speed, e.g. for a speed profile along a known course.
+ * \param percent Speed in percent (0..100) of the configured maximum line following speed.
+ */
+void PID_SetLineSpeedLimit(uint8_t percent);
+
+/*!
+ * \brief Limits how much the speed and position controllers may change the motor effort in one control cycle.
+ * \param maxChange Maximum change of the effort (0xffff is full speed) per cycle, 0 for no limit.
+ */
+void PID_SetSlewLimit(int32_t maxChange);
+
 /*! \brief Driver re-init and reset */
 void PID_Start(void);
 
@@ -0,0 +1,110 @@
+/**
+ * \file
+ * \brief Relay feedback auto-tuning of the PID loops.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Relay experiment and Ziegler-Nichols gain computation. Hardware independent, so it can be compiled for the
+ * host with PIDT_HOST defined (see INTRO_HostTest).
+ */
+
+#ifdef PIDT_HOST
+  #define PIDT_ENABLED  1
+#else
+  #include "Platform.h"
+  #define PIDT_ENABLED  PL_CONFIG_HAS_PID_AUTOTUNE
+#endif
+#if PIDT_ENABLED
+#include "PidTune.h"
+
+void PIDT_RelayStart(PIDT_Relay *relay, int32_t amplitude, int32_t hysteresis, int32_t bias) {
+  relay->amplitude = amplitude;
+  relay->hysteresis = hysteresis;
+  relay->bias = bias;
+  relay->relayHigh = 0;
+  relay->started = 0;
+  relay->nofSamples = 0;
+  relay->lastSwitch = 0;
+  relay->lastChange = 0;
+  relay->highSamples = 0;
+  relay->errMin = relay->errMax = 0;
+  relay->nofPeriods = 0;
+  relay->sumAmplitude = relay->sumPeriod = 0;
+  relay->oscAmplitude = relay->oscPeriod = 0;
+}
+
+PIDT_RelayState PIDT_RelayStep(PIDT_Relay *relay, int32_t error, int32_t *outP) {
+  int32_t period;
+
+  relay->nofSamples++;
+  if (error<relay->errMin) {
+    relay->errMin = error;
+  }
+  if (error>relay->errMax) {
+    relay->errMax = error;
+  }
+  if (!relay->relayHigh && error>relay->hysteresis) { /* switch to high: a period has been completed */
+    relay->relayHigh = 1;
+    if (relay->started) {
+      period = (int32_t)(relay->nofSamples-relay->lastSwitch);
+      /* more samples in the high half means the output is too low on average */
+      relay->bias += (relay->amplitude*((int32_t)(2*relay->highSamples)-period))/(2*period);
+      if (relay->bias>0xffff) {
+        relay->bias = 0xffff;
+      } else if (relay->bias<-0xffff) {
+        relay->bias = -0xffff;
+      }
+      relay->nofPeriods++;
+      if (relay->nofPeriods>PIDT_SKIP_PERIODS) {
+        relay->sumAmplitude += (relay->errMax-relay->errMin)/2;
+        relay->sumPeriod += period;
+      }
+      if (relay->nofPeriods>=PIDT_SKIP_PERIODS+PIDT_MEASURE_PERIODS) {
+        relay->oscAmplitude = relay->sumAmplitude/PIDT_MEASURE_PERIODS;
+        relay->oscPeriod = relay->sumPeriod/PIDT_MEASURE_PERIODS;
+        return PIDT_RELAY_DONE;
+      }
+    }
+    relay->started = 1;
+    relay->lastSwitch = relay->nofSamples;
+    relay->errMin = relay->errMax = error;
+    relay->lastChange = relay->nofSamples;
+  } else if (relay->relayHigh && error<-relay->hysteresis) { /* switch to low */
+    relay->relayHigh = 0;
+    relay->highSamples = relay->nofSamples-relay->lastSwitch;
+    relay->lastChange = relay->nofSamples;
+  } else if (relay->nofSamples-relay->lastChange>PIDT_STUCK_SAMPLES) {
+    /* relay amplitude does not reach the set value: move the bias in the direction of the relay */
+    relay->bias += relay->relayHigh?relay->amplitude/2:-relay->amplitude/2;
+    relay->lastChange = relay->nofSamples;
+  }
+  if (relay->nofSamples>PIDT_MAX_SAMPLES) {
+    return PIDT_RELAY_FAILED; /* no stable oscillation */
+  }
+  *outP = relay->relayHigh?relay->bias+relay->amplitude:relay->bias-relay->amplitude;
+  return PIDT_RELAY_RUNNING;
+}
+
+uint8_t PIDT_CalcGains(int32_t relayAmplitude, int32_t oscAmplitude, int32_t periodSamples, int32_t scale, uint8_t withIntegral, PIDT_Gains *gains) {
+  int64_t ku100; /* ultimate gain, times 100 */
+  int32_t p100;
+
+  if (relayAmplitude<=0 || oscAmplitude<=0 || periodSamples<4 || scale<=0) {
+    return 0; /* no usable oscillation */
+  }
+  ku100 = ((int64_t)400*relayAmplitude*1000)/((int64_t)3142*oscAmplitude*scale); /* Ku = 4*d/(pi*a) */
+  if (withIntegral) { /* Ziegler-Nichols PID: Kp=0.6*Ku, Ti=Tu/2, Td=Tu/8 */
+    p100 = (int32_t)((ku100*6)/10);
+    gains->iFactor100 = (p100*2)/periodSamples; /* Kp*Ts/Ti */
+  } else { /* Ziegler-Nichols PD: Kp=0.8*Ku, Td=Tu/8 */
+    p100 = (int32_t)((ku100*8)/10);
+    gains->iFactor100 = 0;
+  }
+  if (p100<1) {
+    return 0; /* gain too small for the integer PID */
+  }
+  gains->pFactor100 = p100;
+  gains->dFactor100 = (p100*periodSamples)/8; /* Kp*Td/Ts */
+  return 1;
+}
+
+#endif /* PIDT_ENABLED */
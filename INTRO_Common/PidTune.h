@@ -0,0 +1,77 @@
+/**
+ * \file
+ * \brief Interface to the relay feedback auto-tuning of the PID loops.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module runs the relay experiment (Astroem-Haegglund) one control sample at a time and computes the
+ * Ziegler-Nichols gains out of the measured oscillation. It does not use any hardware or RTOS, so it is used by
+ * the PID module on the robot and by the plant model check in INTRO_HostTest.
+ */
+
+#ifndef PIDTUNE_H_
+#define PIDTUNE_H_
+
+#include <stdint.h>
+
+#define PIDT_SKIP_PERIODS     2    /* number of oscillation periods ignored until the oscillation is stable */
+#define PIDT_MEASURE_PERIODS  4    /* number of oscillation periods averaged */
+#define PIDT_MAX_SAMPLES      4000 /* maximum number of control samples for the experiment */
+#define PIDT_STUCK_SAMPLES    100  /* if the relay does not switch within this number of samples, the bias is moved */
+
+typedef enum {
+  PIDT_RELAY_RUNNING, /*!< experiment is running, use the relay output */
+  PIDT_RELAY_DONE,    /*!< oscillation has been measured */
+  PIDT_RELAY_FAILED   /*!< no stable oscillation */
+} PIDT_RelayState;
+
+typedef struct {
+  int32_t amplitude; /*!< relay amplitude, in motor effort */
+  int32_t hysteresis; /*!< relay hysteresis, in units of the control error */
+  int32_t bias; /*!< relay bias, adapted so that both relay halves have the same duration */
+  uint8_t relayHigh; /*!< relay output is bias+amplitude */
+  uint8_t started; /*!< first switch to high has happened */
+  uint32_t nofSamples; /*!< number of control samples since start */
+  uint32_t lastSwitch; /*!< sample number of the last switch to high */
+  uint32_t lastChange; /*!< sample number of the last switch in any direction */
+  uint32_t highSamples; /*!< number of samples of the last high half period */
+  int32_t errMin, errMax; /*!< extrema of the error in the current period */
+  uint8_t nofPeriods; /*!< number of completed periods */
+  int32_t sumAmplitude, sumPeriod; /*!< sums of the measured periods */
+  int32_t oscAmplitude, oscPeriod; /*!< result: averaged oscillation amplitude and period (in samples) */
+} PIDT_Relay;
+
+typedef struct {
+  int32_t pFactor100, iFactor100, dFactor100; /*!< gains in the format of the PID configuration */
+} PIDT_Gains;
+
+/*!
+ * \brief Starts a relay experiment.
+ * \param relay Experiment data to initialize.
+ * \param amplitude Relay amplitude, in motor effort.
+ * \param hysteresis Relay hysteresis, in units of the control error, to ignore noise.
+ * \param bias Initial bias, e.g. the effort of the settled loop.
+ */
+void PIDT_RelayStart(PIDT_Relay *relay, int32_t amplitude, int32_t hysteresis, int32_t bias);
+
+/*!
+ * \brief Runs one control sample of the relay experiment.
+ * \param relay Experiment data.
+ * \param error Control error (set value minus current value).
+ * \param outP Where to store the relay output in motor effort, only if the experiment is running.
+ * \return PIDT_RELAY_RUNNING as long as the relay output shall be used, then PIDT_RELAY_DONE or PIDT_RELAY_FAILED.
+ */
+PIDT_RelayState PIDT_RelayStep(PIDT_Relay *relay, int32_t error, int32_t *outP);
+
+/*!
+ * \brief Computes the gains out of the relay experiment result (Ziegler-Nichols).
+ * \param relayAmplitude Relay amplitude, in motor effort.
+ * \param oscAmplitude Amplitude of the oscillation of the control error.
+ * \param periodSamples Period of the oscillation, in control samples.
+ * \param scale Factor the loop multiplies the PID value with to get the motor effort.
+ * \param withIntegral Non-zero for a PID controller, zero for a PD controller.
+ * \param gains Where to store the gains.
+ * \return 1 if the gains have been computed, 0 if the oscillation is not usable.
+ */
+uint8_t PIDT_CalcGains(int32_t relayAmplitude, int32_t oscAmplitude, int32_t periodSamples, int32_t scale, uint8_t withIntegral, PIDT_Gains *gains);
+
+#endif /* PIDTUNE_H_ */
@@ -45,6 +45,9 @@
 #if PL_CONFIG_HAS_MOTOR
   #include "Motor.h"
 #endif
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
 #if PL_CONFIG_HAS_MOTOR_TACHO
   #include "Tacho.h"
 #endif
@@ -54,9 +57,15 @@
 #if PL_CONFIG_HAS_DRIVE
   #include "Drive.h"
 #endif
+#if PL_CONFIG_HAS_TRACTION
+  #include "Traction.h"
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   #include "LineFollow.h"
 #endif
+#if PL_CONFIG_HAS_LAP_LEARN
+  #include "LapLearn.h"
+#endif
 #if PL_CONFIG_HAS_RADIO
   #include "RNet_App.h"
 #endif
@@ -69,12 +78,27 @@
 #if PL_CONFIG_HAS_CONFIG_NVM
   #include "NVM_Config.h"
 #endif
+#if PL_CONFIG_HAS_MOTOR_CALIBRATION
+  #include "MotorCalib.h"
+#endif
+#if PL_CONFIG_HAS_TURN_CALIBRATION
+  #include "TurnCalib.h"
+#endif
 #if PL_CONFIG_HAS_LINE_MAZE
   #include "Maze.h"
 #endif
+#if PL_CONFIG_HAS_MAZE_MAP
+  #include "MazeMap.h"
+#endif
+#if PL_CONFIG_HAS_MAZE_RUN
+  #include "MazeRun.h"
+#endif
 #if PL_CONFIG_HAS_LCD
   #include "LCD.h"
 #endif
+#if PL_CONFIG_HAS_ADC_SERVICE
+  #include "AdcService.h"
+#endif
 #if PL_CONFIG_HAS_BATTERY_ADC
   #include "Battery.h"
 #endif
@@ -84,6 +108,12 @@
 #if PL_HAS_DISTANCE_SENSOR
   #include "Distance.h"
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  #include "Odometry.h"
+#endif
+#if PL_CONFIG_HAS_OPPONENT
+  #include "Opponent.h"
+#endif
 #if PL_CONFIG_HAS_SUMO /*! \todo */
   #include "Sumo.h"
 #endif
@@ -128,18 +158,27 @@ void PL_Init(void) {
 #if PL_CONFIG_HAS_MOTOR
   MOT_Init();
 #endif
+#if PL_CONFIG_HAS_QUAD_FTM
+  QFTM_Init();
+#endif
 #if PL_CONFIG_HAS_MOTOR_TACHO
   TACHO_Init();
 #endif
 #if PL_CONFIG_HAS_PID
   PID_Init();
 #endif
+#if PL_CONFIG_HAS_TRACTION
+  TRAC_Init(); /* before drive */
+#endif
 #if PL_CONFIG_HAS_DRIVE
   DRV_Init();
 #endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_Init();
 #endif
+#if PL_CONFIG_HAS_LAP_LEARN
+  LAP_Init();
+#endif
 #if PL_CONFIG_HAS_RADIO
   RNETA_Init();
 #endif
@@ -152,14 +191,29 @@ void PL_Init(void) {
 #if PL_CONFIG_HAS_CONFIG_NVM
   NVMC_Init();
 #endif
+#if PL_CONFIG_HAS_MOTOR_CALIBRATION
+  MOTCAL_Init(); /* after motor and NVM */
+#endif
+#if PL_CONFIG_HAS_TURN_CALIBRATION
+  TCAL_Init(); /* after turn and NVM */
+#endif
+#if PL_CONFIG_HAS_MAZE_MAP
+  MMAP_Init(); /* before maze */
+#endif
 #if PL_CONFIG_HAS_LINE_MAZE
   MAZE_Init();
 #endif
+#if PL_CONFIG_HAS_MAZE_RUN
+  MRUN_Init();
+#endif
 #if PL_CONFIG_HAS_LCD
   LCD_Init();
 #endif
+#if PL_CONFIG_HAS_ADC_SERVICE
+  ADCS_Init();
+#endif
 #if PL_CONFIG_HAS_BATTERY_ADC
-  BATT_Init();
+  BATT_Init(); /* after ADC service */
 #endif
 #if PL_CONFIG_HAS_SNAKE_GAME
   SNAKE_Init();
@@ -167,6 +221,12 @@ void PL_Init(void) {
 #if PL_HAS_DISTANCE_SENSOR
   DIST_Init();
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  ODO_Init();
+#endif
+#if PL_CONFIG_HAS_OPPONENT
+  OPP_Init();
+#endif
 #if PL_CONFIG_HAS_SUMO
   SUMO_Init();
 #endif
@@ -176,6 +236,12 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_SUMO
   SUMO_Deinit();
 #endif
+#if PL_CONFIG_HAS_OPPONENT
+  OPP_Deinit();
+#endif
+#if PL_CONFIG_HAS_ODOMETRY
+  ODO_Deinit();
+#endif
 #if PL_HAS_DISTANCE_SENSOR
   DIST_Deinit();
 #endif
@@ -185,12 +251,27 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_BATTERY_ADC
   BATT_Deinit();
 #endif
+#if PL_CONFIG_HAS_ADC_SERVICE
+  ADCS_Deinit();
+#endif
 #if PL_CONFIG_HAS_LCD
   LCD_Deinit();
 #endif
+#if PL_CONFIG_HAS_MAZE_RUN
+  MRUN_Deinit();
+#endif
 #if PL_CONFIG_HAS_LINE_MAZE
   MAZE_Deinit();
 #endif
+#if PL_CONFIG_HAS_MAZE_MAP
+  MMAP_Deinit();
+#endif
+#if PL_CONFIG_HAS_TURN_CALIBRATION
+  TCAL_Deinit();
+#endif
+#if PL_CONFIG_HAS_MOTOR_CALIBRATION
+  MOTCAL_Deinit();
+#endif
 #if PL_CONFIG_HAS_CONFIG_NVM
   NVMC_Deinit();
 #endif
@@ -203,18 +284,27 @@ void PL_Deinit(void) {
 #if PL_CONFIG_HAS_RADIO
   RNETA_Deinit();
 #endif
+#if PL_CONFIG_HAS_LAP_LEARN
+  LAP_Deinit();
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_Deinit();
 #endif
 #if PL_CONFIG_HAS_DRIVE
   DRV_Deinit();
 #endif
+#if PL_CONFIG_HAS_TRACTION
+  TRAC_Deinit();
+#endif
 #if PL_CONFIG_HAS_PID
   PID_Deinit();
 #endif
 #if PL_CONFIG_HAS_MOTOR_TACHO
   TACHO_Deinit();
 #endif
+#if PL_CONFIG_HAS_QUAD_FTM
+  QFTM_Deinit();
+#endif
 #if PL_CONFIG_HAS_MOTOR
   MOT_Deinit();
 #endif
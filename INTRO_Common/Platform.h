@@ -41,7 +41,7 @@
   #error "One board type has to be defined in Platform_Local.h!"
 #endif
 
-#define PL_CONFIG_HAS_SUMO     (0 && PL_LOCAL_CONFIG_BOARD_IS_ROBO)
+#define PL_CONFIG_HAS_SUMO     (1 && !defined(PL_LOCAL_CONFIG_HAS_SUMO_DISABLED) && PL_LOCAL_CONFIG_BOARD_IS_ROBO && PL_CONFIG_HAS_REFLECTANCE && PL_CONFIG_HAS_DRIVE && PL_HAS_DISTANCE_SENSOR)
 
 /* configuration from local config */
 #define PL_CONFIG_NOF_LEDS      PL_LOCAL_CONFIG_NOF_LEDS /* number of LEDs */
@@ -85,21 +85,32 @@
 #define PL_CONFIG_HAS_BLUETOOTH         (1 && !defined(PL_LOCAL_CONFIG_HAS_BLUETOOTH_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_CONFIG_HAS_MOTOR             (1 && !defined(PL_LOCAL_CONFIG_HAS_MOTOR_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_CONFIG_HAS_QUADRATURE        (1 && !defined(PL_LOCAL_CONFIG_HAS_QUADRATURE_DISABLED) && PL_CONFIG_HAS_MOTOR)
+#define PL_CONFIG_HAS_QUAD_FTM          (1 && !defined(PL_LOCAL_CONFIG_HAS_QUAD_FTM_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
 #define PL_CONFIG_HAS_MOTOR_TACHO       (1 && !defined(PL_LOCAL_CONFIG_HAS_MOTOR_TACHO_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
 #define PL_CONFIG_HAS_MCP4728           (1 && !defined(PL_LOCAL_CONFIG_HAS_MPC4728_DISABLED) && PL_CONFIG_BOARD_IS_ROBO && PL_CONFIG_BOARD_IS_ROBO_V1) /* only for V1 robot */
 #define PL_CONFIG_HAS_QUAD_CALIBRATION  (1 && !defined(PL_LOCAL_CONFIG_HAS_QUAD_CALIBRATION_DISABLED) && PL_CONFIG_HAS_MCP4728)
+#define PL_CONFIG_HAS_MOTOR_CALIBRATION (1 && !defined(PL_LOCAL_CONFIG_HAS_MOTOR_CALIBRATION_DISABLED) && PL_CONFIG_HAS_MOTOR_TACHO && PL_CONFIG_HAS_DRIVE && PL_CONFIG_HAS_CONFIG_NVM)
 #define PL_CONFIG_HAS_PID               (1 && !defined(PL_LOCAL_CONFIG_HAS_PID_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
 #define PL_CONFIG_HAS_DRIVE             (1 && !defined(PL_LOCAL_CONFIG_HAS_DRIVE_DISABLED) && PL_CONFIG_HAS_PID)
+#define PL_CONFIG_HAS_PID_AUTOTUNE      (1 && !defined(PL_LOCAL_CONFIG_HAS_PID_AUTOTUNE_DISABLED) && PL_CONFIG_HAS_DRIVE)
+#define PL_CONFIG_HAS_TRACTION          (1 && !defined(PL_LOCAL_CONFIG_HAS_TRACTION_DISABLED) && PL_CONFIG_HAS_DRIVE && PL_CONFIG_HAS_MOTOR_TACHO)
 #define PL_CONFIG_HAS_REFLECTANCE       (1 && !defined(PL_LOCAL_CONFIG_HAS_REFLECTANCE_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_CONFIG_HAS_LINE_FOLLOW       (1 && !defined(PL_LOCAL_CONFIG_HAS_LINE_FOLLOW_DISABLED)/* && PL_CONFIG_HAS_DRIVE*/)
 #define PL_CONFIG_HAS_TURN              (1 && !defined(PL_LOCAL_CONFIG_HAS_TURN_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
+#define PL_CONFIG_HAS_TURN_CALIBRATION  (1 && !defined(PL_LOCAL_CONFIG_HAS_TURN_CALIBRATION_DISABLED) && PL_CONFIG_HAS_TURN && PL_CONFIG_HAS_REFLECTANCE && PL_CONFIG_HAS_DRIVE && PL_CONFIG_HAS_CONFIG_NVM)
+#define PL_CONFIG_HAS_LAP_LEARN         (1 && !defined(PL_LOCAL_CONFIG_HAS_LAP_LEARN_DISABLED) && PL_CONFIG_HAS_LINE_FOLLOW && PL_CONFIG_HAS_ODOMETRY)
 #define PL_CONFIG_HAS_LINE_MAZE         (1 && !defined(PL_LOCAL_CONFIG_HAS_LINE_MAZE_DISABLED) && PL_CONFIG_HAS_LINE_FOLLOW)
+#define PL_CONFIG_HAS_MAZE_MAP          (1 && !defined(PL_LOCAL_CONFIG_HAS_MAZE_MAP_DISABLED) && PL_CONFIG_HAS_LINE_MAZE && PL_CONFIG_HAS_ODOMETRY)
+#define PL_CONFIG_HAS_MAZE_RUN          (1 && !defined(PL_LOCAL_CONFIG_HAS_MAZE_RUN_DISABLED) && PL_CONFIG_HAS_MAZE_MAP && PL_CONFIG_HAS_DRIVE)
 #define PL_HAS_DISTANCE_SENSOR          (1 && !defined(PL_LOCAL_CONFIG_HAS_DISTANCE_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
 #define PL_HAS_TOF_SENSOR               (1 && !defined(PL_LOCAL_CONFIG_HAS_TOF_SENSOR_DISABLED) && PL_HAS_DISTANCE_SENSOR)
 #define PL_HAS_SIDE_DISTANCE            (0)
 #define PL_HAS_FRONT_DISTANCE           (0)
+#define PL_CONFIG_HAS_ODOMETRY          (1 && !defined(PL_LOCAL_CONFIG_HAS_ODOMETRY_DISABLED) && PL_CONFIG_HAS_QUADRATURE)
+#define PL_CONFIG_HAS_OPPONENT          (1 && !defined(PL_LOCAL_CONFIG_HAS_OPPONENT_DISABLED) && PL_HAS_TOF_SENSOR && PL_CONFIG_HAS_ODOMETRY)
 
 #define PL_CONFIG_HAS_BATTERY_ADC       (1 && !defined(PL_LOCAL_CONFIG_HAS_BATTERY_ADC_DISABLED) && PL_CONFIG_BOARD_IS_ROBO)
+#define PL_CONFIG_HAS_ADC_SERVICE       (1 && !defined(PL_LOCAL_CONFIG_HAS_ADC_SERVICE_DISABLED) && PL_CONFIG_HAS_TIMER && (PL_CONFIG_HAS_BATTERY_ADC || PL_CONFIG_HAS_JOYSTICK))
 
 #define PL_CONFIG_HAS_SNAKE_GAME        (1 && !defined(PL_LOCAL_CONFIG_HAS_SNAKE_GAME_DISABLED) && PL_CONFIG_HAS_LCD)
 
@@ -0,0 +1,208 @@
+/**
+ * \file
+ * \brief FlexTimer hardware quadrature decoder.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * The encoder signals are routed to the FTM quadrature decoder inputs (FTMx_QD_PHA/PHB), and the FTM counts
+ * the steps in hardware. The 16bit counter is extended to 32bit with the signed difference to the previous read:
+ * as long as the counter is read at least once within 32768 steps, no step is lost.
+ */
+
+#include "QuadFtm.h"
+#if QFTM_ENABLED
+#ifdef QFTM_HOST
+  #define FRTOS1_taskENTER_CRITICAL()  /* single threaded on the host */
+  #define FRTOS1_taskEXIT_CRITICAL()
+  #define TRUE   true
+  #define FALSE  false
+#else
+  #include "FRTOS1.h"
+  #include "UTIL1.h"
+  #include "FTM_PDD.h"
+  #include "PORT_PDD.h"
+#endif
+
+/*! \todo adopt to the pins of your encoders. Only PTB0/PTB1 (FTM1) and PTB18/PTB19 (FTM2) are quadrature decoder pins on the K22 */
+#define QFTM_LEFT_FTM           FTM1_BASE_PTR
+#define QFTM_LEFT_PORT          PORTB_BASE_PTR
+#define QFTM_LEFT_PIN_A         0   /* PTB0: FTM1_QD_PHA */
+#define QFTM_LEFT_PIN_B         1   /* PTB1: FTM1_QD_PHB */
+#define QFTM_RIGHT_FTM          FTM2_BASE_PTR
+#define QFTM_RIGHT_PORT         PORTB_BASE_PTR
+#define QFTM_RIGHT_PIN_A        18  /* PTB18: FTM2_QD_PHA */
+#define QFTM_RIGHT_PIN_B        19  /* PTB19: FTM2_QD_PHB */
+#define QFTM_PIN_MUX            PORT_PDD_MUX_CONTROL_ALT6
+#define QFTM_FILTER             4   /* input filter, in multiples of 4 bus clocks */
+
+typedef struct {
+  int32_t pos; /* extended 32bit position */
+  uint16_t lastCnt; /* hardware counter value of the last update */
+  bool swap; /* if the phases are swapped (inverted direction) */
+} QFTM_Desc;
+
+static QFTM_Desc QFTM_desc[QFTM_NOF_CHANNELS];
+
+#ifdef QFTM_HOST
+static uint16_t QFTM_MockCnt[QFTM_NOF_CHANNELS]; /* simulated hardware counters */
+
+void QFTM_MockMove(QFTM_Channel ch, int32_t steps) {
+  QFTM_MockCnt[ch] = (uint16_t)(QFTM_MockCnt[ch]+steps);
+}
+
+static uint16_t ReadCounter(QFTM_Channel ch) {
+  return QFTM_MockCnt[ch];
+}
+#else
+static uint16_t ReadCounter(QFTM_Channel ch) {
+  if (ch==QFTM_LEFT) {
+    return (uint16_t)FTM_PDD_ReadCounterReg(QFTM_LEFT_FTM);
+  }
+  return (uint16_t)FTM_PDD_ReadCounterReg(QFTM_RIGHT_FTM);
+}
+
+static void InitDecoder(FTM_MemMapPtr ftm) {
+  FTM_PDD_WriteFeaturesModeReg(ftm, FTM_MODE_WPDIS_MASK|FTM_MODE_FTMEN_MASK); /* disable write protection, enable all FTM features */
+  FTM_PDD_WriteModuloReg(ftm, 0xFFFF); /* full 16bit range */
+  FTM_PDD_WriteInitialValueReg(ftm, 0);
+  FTM_PDD_InitializeCounter(ftm);
+  FTM_PDD_WriteFilterReg(ftm, FTM_FILTER_CH0FVAL(QFTM_FILTER)|FTM_FILTER_CH1FVAL(QFTM_FILTER));
+  FTM_PDD_WriteQuadratureDecoderReg(ftm, FTM_QDCTRL_QUADEN_MASK|FTM_QDCTRL_PHAFLTREN_MASK|FTM_QDCTRL_PHBFLTREN_MASK); /* phase A/B encoding mode */
+  FTM_PDD_SelectPrescalerSource(ftm, FTM_PDD_SYSTEM); /* counter needs a clock source, even if it is counting the encoder edges */
+}
+#endif
+
+/* extends the hardware counter, has to be called with interrupts disabled */
+static int32_t Update(QFTM_Channel ch) {
+  QFTM_Desc *desc = &QFTM_desc[ch];
+  uint16_t cnt;
+  int16_t delta;
+
+  cnt = ReadCounter(ch);
+  delta = (int16_t)(uint16_t)(cnt-desc->lastCnt); /* signed difference, handles the wrap around of the counter */
+  desc->lastCnt = cnt;
+  if (desc->swap) {
+    desc->pos -= delta;
+  } else {
+    desc->pos += delta;
+  }
+  return desc->pos;
+}
+
+int32_t QFTM_GetPos(QFTM_Channel ch) {
+  int32_t pos;
+
+  if (ch>=QFTM_NOF_CHANNELS) {
+    return 0;
+  }
+  FRTOS1_taskENTER_CRITICAL();
+  pos = Update(ch);
+  FRTOS1_taskEXIT_CRITICAL();
+  return pos;
+}
+
+uint8_t QFTM_SetPos(QFTM_Channel ch, int32_t pos) {
+  if (ch>=QFTM_NOF_CHANNELS) {
+    return ERR_FAILED;
+  }
+  FRTOS1_taskENTER_CRITICAL();
+  QFTM_desc[ch].lastCnt = ReadCounter(ch);
+  QFTM_desc[ch].pos = pos;
+  FRTOS1_taskEXIT_CRITICAL();
+  return ERR_OK;
+}
+
+uint8_t QFTM_SwapPins(QFTM_Channel ch, bool swap) {
+  if (ch>=QFTM_NOF_CHANNELS) {
+    return ERR_FAILED;
+  }
+  FRTOS1_taskENTER_CRITICAL();
+  (void)Update(ch); /* count the steps so far with the old direction */
+  QFTM_desc[ch].swap = swap;
+  FRTOS1_taskEXIT_CRITICAL();
+  return ERR_OK;
+}
+
+uint16_t QFTM_NofErrors(QFTM_Channel ch) {
+  (void)ch;
+  return 0; /* the decoder filters the inputs, but does not report invalid transitions */
+}
+
+void QFTM_OnInterrupt(void) {
+  (void)Update(QFTM_LEFT);
+  (void)Update(QFTM_RIGHT);
+}
+
+#if !defined(QFTM_HOST) && PL_CONFIG_HAS_SHELL
+static void QFTM_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"qftm", (unsigned char*)"Group of FTM quadrature decoder commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows quadrature decoder help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Sets both positions to zero\r\n", io->stdOut);
+}
+
+static void QFTM_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[48];
+  QFTM_Channel ch;
+  uint16_t cnt;
+  bool swap;
+
+  CLS1_SendStatusStr((unsigned char*)"qftm", (unsigned char*)"\r\n", io->stdOut);
+  for(ch=QFTM_LEFT; ch<QFTM_NOF_CHANNELS; ch++) {
+    buf[0] = '\0';
+    UTIL1_strcatNum32s(buf, sizeof(buf), QFTM_GetPos(ch));
+    FRTOS1_taskENTER_CRITICAL();
+    cnt = QFTM_desc[ch].lastCnt;
+    swap = QFTM_desc[ch].swap;
+    FRTOS1_taskEXIT_CRITICAL();
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", cnt 0x");
+    UTIL1_strcatNum16Hex(buf, sizeof(buf), cnt);
+    if (swap) {
+      UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", swapped");
+    }
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+    CLS1_SendStatusStr(ch==QFTM_LEFT?(unsigned char*)"  left":(unsigned char*)"  right", buf, io->stdOut);
+  }
+}
+
+uint8_t QFTM_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, "qftm help")==0) {
+    QFTM_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, "qftm status")==0) {
+    QFTM_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, "qftm reset")==0) {
+    (void)QFTM_SetPos(QFTM_LEFT, 0);
+    (void)QFTM_SetPos(QFTM_RIGHT, 0);
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void QFTM_Deinit(void) {
+#ifndef QFTM_HOST
+  FTM_PDD_SelectPrescalerSource(QFTM_LEFT_FTM, FTM_PDD_DISABLED);
+  FTM_PDD_SelectPrescalerSource(QFTM_RIGHT_FTM, FTM_PDD_DISABLED);
+#endif
+}
+
+void QFTM_Init(void) {
+  QFTM_Channel ch;
+
+#ifndef QFTM_HOST
+  SIM_SCGC6 |= SIM_SCGC6_FTM1_MASK|SIM_SCGC6_FTM2_MASK; /* clock gates */
+  PORT_PDD_SetPinMuxControl(QFTM_LEFT_PORT, QFTM_LEFT_PIN_A, QFTM_PIN_MUX);
+  PORT_PDD_SetPinMuxControl(QFTM_LEFT_PORT, QFTM_LEFT_PIN_B, QFTM_PIN_MUX);
+  PORT_PDD_SetPinMuxControl(QFTM_RIGHT_PORT, QFTM_RIGHT_PIN_A, QFTM_PIN_MUX);
+  PORT_PDD_SetPinMuxControl(QFTM_RIGHT_PORT, QFTM_RIGHT_PIN_B, QFTM_PIN_MUX);
+  InitDecoder(QFTM_LEFT_FTM);
+  InitDecoder(QFTM_RIGHT_FTM);
+#endif
+  for(ch=QFTM_LEFT; ch<QFTM_NOF_CHANNELS; ch++) {
+    QFTM_desc[ch].pos = 0;
+    QFTM_desc[ch].lastCnt = ReadCounter(ch);
+    QFTM_desc[ch].swap = FALSE;
+  }
+}
+
+#endif /* QFTM_ENABLED */
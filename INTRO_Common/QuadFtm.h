@@ -0,0 +1,118 @@
+/**
+ * \file
+ * \brief Interface to the FlexTimer hardware quadrature decoder.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module decodes the wheel encoders with the FTM quadrature decoder mode instead of sampling
+ * the signals in the QuadInt timer interrupt. The 16bit hardware counters are extended to 32bit in software.
+ * The Q4CLeft/Q4CRight position API is mapped to this module, so the users of the encoders
+ * (Tacho, Drive, Turn, ...) do not need to change: include this header after Q4CLeft.h and Q4CRight.h.
+ * With QFTM_HOST defined, the module uses simulated counters instead of the FTM registers and does not need any
+ * hardware or RTOS header, so the counter extension can be checked on the host (see INTRO_HostTest).
+ */
+
+#ifndef QUADFTM_H_
+#define QUADFTM_H_
+
+#ifdef QFTM_HOST
+  #include <stdint.h>
+  #include <stdbool.h>
+  #ifndef ERR_OK
+    #define ERR_OK      0x00U /* same as in PE_Error.h */
+    #define ERR_FAILED  0x1BU
+  #endif
+  #define QFTM_ENABLED  1
+#else
+  #include "Platform.h"
+  #define QFTM_ENABLED  PL_CONFIG_HAS_QUAD_FTM
+#endif
+#if QFTM_ENABLED
+
+typedef enum {
+  QFTM_LEFT,        /*!< left wheel encoder */
+  QFTM_RIGHT,       /*!< right wheel encoder */
+  QFTM_NOF_CHANNELS /*!< must be last! */
+} QFTM_Channel;
+
+#ifndef QFTM_HOST
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+
+/* map the quadrature counter component API to the hardware decoder */
+#define Q4CLeft_GetPos()          ((Q4CLeft_QuadCntrType)QFTM_GetPos(QFTM_LEFT))
+#define Q4CLeft_SetPos(pos)       QFTM_SetPos(QFTM_LEFT, (int32_t)(pos))
+#define Q4CLeft_SwapPins(swap)    QFTM_SwapPins(QFTM_LEFT, (swap))
+#define Q4CLeft_NofErrors()       QFTM_NofErrors(QFTM_LEFT)
+#define Q4CLeft_Sample()          /* nothing to do, counting is done by the hardware */
+#define Q4CRight_GetPos()         ((Q4CRight_QuadCntrType)QFTM_GetPos(QFTM_RIGHT))
+#define Q4CRight_SetPos(pos)      QFTM_SetPos(QFTM_RIGHT, (int32_t)(pos))
+#define Q4CRight_SwapPins(swap)   QFTM_SwapPins(QFTM_RIGHT, (swap))
+#define Q4CRight_NofErrors()      QFTM_NofErrors(QFTM_RIGHT)
+#define Q4CRight_Sample()         /* nothing to do, counting is done by the hardware */
+#endif /* QFTM_HOST */
+
+/*!
+ * \brief Returns the 32bit position of an encoder.
+ * \param ch Encoder channel.
+ * \return Position in encoder steps, 0 for an invalid channel.
+ */
+int32_t QFTM_GetPos(QFTM_Channel ch);
+
+/*!
+ * \brief Sets the 32bit position of an encoder.
+ * \param ch Encoder channel.
+ * \param pos New position in encoder steps.
+ * \return ERR_OK if everything was fine.
+ */
+uint8_t QFTM_SetPos(QFTM_Channel ch, int32_t pos);
+
+/*!
+ * \brief Swaps the A and B phase of an encoder, which inverts the counting direction.
+ * \param ch Encoder channel.
+ * \param swap TRUE to swap the phases, FALSE for the normal direction.
+ * \return ERR_OK if everything was fine.
+ */
+uint8_t QFTM_SwapPins(QFTM_Channel ch, bool swap);
+
+/*!
+ * \brief Returns the number of decoding errors. The hardware does not detect them, so this is always zero.
+ * \param ch Encoder channel.
+ * \return Number of errors.
+ */
+uint16_t QFTM_NofErrors(QFTM_Channel ch);
+
+/*!
+ * \brief Called from the timer interrupt: extends the hardware counters to 32bit, so a counter cannot wrap around twice between two reads.
+ */
+void QFTM_OnInterrupt(void);
+
+#ifdef QFTM_HOST
+/*!
+ * \brief Host only: moves the simulated 16bit hardware counter of an encoder.
+ * \param ch Encoder channel.
+ * \param steps Number of steps to move, positive or negative.
+ */
+void QFTM_MockMove(QFTM_Channel ch, int32_t steps);
+#endif
+
+#if !defined(QFTM_HOST) && PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t QFTM_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void QFTM_Deinit(void);
+
+/*! \brief Initialization of the module */
+void QFTM_Init(void);
+
+#endif /* QFTM_ENABLED */
+
+#endif /* QUADFTM_H_ */
@@ -29,6 +29,9 @@
 #if PL_CONFIG_HAS_LCD
   #include "LCD.h"
 #endif
+#if PL_CONFIG_HAS_SUMO
+  #include "Sumo.h"
+#endif
 
 static RNWK_ShortAddrType APP_dstAddr = RNWK_ADDR_BROADCAST; /* destination node address */
 
@@ -185,6 +188,9 @@ static const RAPP_MsgHandler handlerTable[] =
 #endif
 #if PL_CONFIG_HAS_LCD
   LCD_HandleRemoteRxMessage,
+#endif
+#if PL_CONFIG_HAS_SUMO
+  SUMO_HandleRadioRxMessage,
 #endif
   NULL /* sentinel */
 };
@@ -36,6 +36,9 @@ typedef enum {
   RAPP_MSG_TYPE_DATA_ID_BATTERY_V = 7,      /* Battery voltage */
   RAPP_MSG_TYPE_DATA_ID_PID_FW_SPEED = 8,   /* PID forward speed */
   RAPP_MSG_TYPE_DATA_ID_START_STOP = 9,     /* start/stop robot */
+  RAPP_MSG_TYPE_DATA_ID_LAP_TIME = 10,      /* lap time in ms */
+  RAPP_MSG_TYPE_DATA_ID_SUMO_STRATEGY = 11, /* sumo strategy number */
+  RAPP_MSG_TYPE_DATA_ID_SUMO_PARAM = 12,    /* sumo parameter: number in the upper 16bit, value in the lower 16bit */
   /*! \todo extend as needed */
 } RAPP_MSG_DateIDType;
 
@@ -29,6 +29,9 @@
 #if PL_CONFIG_HAS_CONFIG_NVM
   #include "NVM_Config.h"
 #endif
+#if PL_CONFIG_HAS_MOTOR
+  #include "Motor.h"
+#endif
 
 #define MEASURE_TIMEOUT		  2 /* [ms] */
 
@@ -54,6 +57,9 @@ static volatile RefStateType refState = REF_STATE_INIT; /* state machine state *
 
 static LDD_TDeviceData *timerHandle;
 static uint32_t timerTimeoutTicks;
+static uint32_t timerFreqKHz; /* counter frequency, for the reflex latency */
+static uint32_t timerPeriodUs; /* counter period: the counter wraps around after this time */
+static TickType_t timerResetTicks; /* RTOS time of the last counter reset, to detect a wrap around */
 
 typedef struct SensorFctType_ {
   void (*SetOutput)(void);
@@ -180,6 +186,7 @@ static void REF_MeasureRaw(SensorTimeType raw[REF_NOF_SENSORS]) {
     SensorFctArray[i].SetInput(); /* turn I/O line as input */
   }
   (void)RefCnt_ResetCounter(timerHandle); /* reset timer counter */
+  timerResetTicks = FRTOS1_xTaskGetTickCount();
   do {
     timerVal = RefCnt_GetCounterValue(timerHandle);
     cnt = 0;
@@ -366,12 +373,82 @@ REF_LineKind REF_GetLineKind(void) {
 }
 #endif
 
+#if PL_CONFIG_HAS_MOTOR
+/*
+ * Border escape reflex for sumo: the sensors are inside the ring (black) as long as all of them see black. When one
+ * of them sees the white border after the measurement, the motors are set right here to back up and turn away,
+ * instead of waiting for the strategy task. The strategy gets notified with REF_BorderReflexTriggered() and takes
+ * over on its next cycle.
+ */
+static volatile bool refReflexOn = FALSE; /* if the reflex is enabled */
+static volatile bool refReflexTriggered = FALSE; /* reflex has been triggered, cleared by the strategy */
+static bool refReflexInside = FALSE; /* sensors were inside the ring at the last measurement */
+static uint16_t refReflexCnt = 0; /* number of times the reflex has been triggered */
+static uint16_t refReflexNofSaturated = 0; /* number of latencies which were too long to be measured */
+static uint32_t refReflexLastUs = 0, refReflexMaxUs = 0; /* latency from the start of the measurement to the motor command */
+
+/* latency since the counter reset at the start of the measurement, saturated at the counter period */
+static uint32_t ReflexLatencyUs(void) {
+  uint32_t elapsedMs;
+
+  elapsedMs = (uint32_t)(FRTOS1_xTaskGetTickCount()-timerResetTicks)*portTICK_PERIOD_MS;
+  if (elapsedMs+portTICK_PERIOD_MS>=timerPeriodUs/1000) { /* measurement has been interrupted for too long, counter might have wrapped around */
+    refReflexNofSaturated++;
+    return timerPeriodUs;
+  }
+  return (uint32_t)(((uint64_t)RefCnt_GetCounterValue(timerHandle)*1000)/timerFreqKHz);
+}
+
+static void BorderReflex(void) {
+  bool inside;
+  uint32_t us;
+
+  inside = refLineKind==REF_LINE_FULL;
+  if (refReflexOn && refReflexInside && !inside) {
+    if (SensorCalibrated[0]<REF_BORDER_THRESHOLD) { /* same as the strategy: back up to the right */
+      MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), -100);
+      MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), 20);
+    } else { /* back up to the left */
+      MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), 20);
+      MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), -100);
+    }
+    us = ReflexLatencyUs();
+    refReflexLastUs = us;
+    if (us>refReflexMaxUs) {
+      refReflexMaxUs = us;
+    }
+    refReflexCnt++;
+    refReflexTriggered = TRUE;
+  }
+  refReflexInside = inside;
+}
+
+void REF_SetBorderReflex(bool on) {
+  refReflexInside = FALSE; /* needs to see the inside of the ring first */
+  refReflexTriggered = FALSE;
+  refReflexOn = on;
+}
+
+bool REF_BorderReflexTriggered(void) {
+  bool res;
+
+  taskENTER_CRITICAL();
+  res = refReflexTriggered;
+  refReflexTriggered = FALSE;
+  taskEXIT_CRITICAL();
+  return res;
+}
+#endif /* PL_CONFIG_HAS_MOTOR */
+
 static void REF_Measure(void) {
   ReadCalibrated(SensorCalibrated, SensorRaw);
-  refCenterLineVal = ReadLine(SensorCalibrated, SensorRaw, REF_USE_WHITE_LINE);
 #if 1 || PL_CONFIG_HAS_LINE_FOLLOW
   refLineKind = ReadLineKind(SensorCalibrated);
 #endif
+#if PL_CONFIG_HAS_MOTOR
+  BorderReflex(); /* as early as possible after the measurement */
+#endif
+  refCenterLineVal = ReadLine(SensorCalibrated, SensorRaw, REF_USE_WHITE_LINE);
 }
 
 static uint8_t PrintHelp(const CLS1_StdIOType *io) {
@@ -379,6 +456,10 @@ static uint8_t PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
 #if REF_START_STOP_CALIB
   CLS1_SendHelpStr((unsigned char*)"  calib (start|stop)", (unsigned char*)"Start/Stop calibrating while moving sensor over line\r\n", io->stdOut);
+#endif
+#if PL_CONFIG_HAS_MOTOR
+  CLS1_SendHelpStr((unsigned char*)"  reflex (on|off)", (unsigned char*)"Enables or disables the sumo border escape reflex\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reflex reset", (unsigned char*)"Resets the reflex count and latency\r\n", io->stdOut);
 #endif
   return ERR_OK;
 }
@@ -417,7 +498,7 @@ static unsigned char *REF_LineKindStr(REF_LineKind line) {
 #endif
 
 static uint8_t PrintStatus(const CLS1_StdIOType *io) {
-  unsigned char buf[24];
+  unsigned char buf[40];
   int i;
 
   CLS1_SendStatusStr((unsigned char*)"reflectance", (unsigned char*)"\r\n", io->stdOut);
@@ -486,6 +567,19 @@ static uint8_t PrintStatus(const CLS1_StdIOType *io) {
   CLS1_SendStatusStr((unsigned char*)"  line kind", REF_LineKindStr(refLineKind), io->stdOut);
   CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
 #endif
+#if PL_CONFIG_HAS_MOTOR
+  UTIL1_strcpy(buf, sizeof(buf), refReflexOn?(unsigned char*)"on, ":(unsigned char*)"off, ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), refReflexCnt);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" times\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  reflex", buf, io->stdOut);
+  UTIL1_Num32uToStr(buf, sizeof(buf), refReflexLastUs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us, max ");
+  UTIL1_strcatNum32u(buf, sizeof(buf), refReflexMaxUs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us, saturated ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), refReflexNofSaturated);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" times\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  reflex lat", buf, io->stdOut);
+#endif
 return ERR_OK;
 }
 
@@ -515,6 +609,23 @@ byte REF_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOT
     }
     *handled = TRUE;
     return ERR_OK;
+#endif
+#if PL_CONFIG_HAS_MOTOR
+  } else if (UTIL1_strcmp((char*)cmd, "ref reflex on")==0) {
+    REF_SetBorderReflex(TRUE);
+    *handled = TRUE;
+    return ERR_OK;
+  } else if (UTIL1_strcmp((char*)cmd, "ref reflex off")==0) {
+    REF_SetBorderReflex(FALSE);
+    *handled = TRUE;
+    return ERR_OK;
+  } else if (UTIL1_strcmp((char*)cmd, "ref reflex reset")==0) {
+    refReflexCnt = 0;
+    refReflexNofSaturated = 0;
+    refReflexLastUs = 0;
+    refReflexMaxUs = 0;
+    *handled = TRUE;
+    return ERR_OK;
 #endif
   }
   return ERR_OK;
@@ -626,6 +737,16 @@ void REF_Init(void) {
   refState = REF_STATE_INIT;
   timerHandle = RefCnt_Init(NULL);
   timerTimeoutTicks = (MEASURE_TIMEOUT*RefCnt_GetInputFrequency(timerHandle))/1000;
+  timerFreqKHz = RefCnt_GetInputFrequency(timerHandle)/1000;
+  {
+    RefCnt_TValueType periodTicks;
+
+    if (RefCnt_GetPeriodTicks(timerHandle, &periodTicks)==ERR_OK) {
+      timerPeriodUs = (uint32_t)(((uint64_t)periodTicks*1000)/timerFreqKHz);
+    } else {
+      timerPeriodUs = 0; /* unknown: latencies are reported as saturated */
+    }
+  }
   /*! \todo You might need to adjust priority or other task settings */
   if (xTaskCreate(ReflTask, "Refl", 600/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+5, NULL) != pdPASS) {
     for(;;){} /* error */
@@ -9,12 +9,10 @@
 #ifndef REFLECTANCE_H_
 #define REFLECTANCE_H_
 
-#include "Platform.h"
-#if PL_CONFIG_HAS_REFLECTANCE
-
 #define REF_NOF_SENSORS 6
 #define REF_MIDDLE_LINE_VALUE  ((REF_NOF_SENSORS+1)*1000/2)
 #define REF_MAX_LINE_VALUE     ((REF_NOF_SENSORS-1)*1000) /* maximum value for REF_GetLine() */
+#define REF_BORDER_THRESHOLD   300 /* calibrated sensor values below this see the white sumo ring border */
 
 typedef enum {
   REF_LINE_NONE=0,     /* no line, sensors do not see a line */
@@ -25,10 +23,30 @@ typedef enum {
   REF_NOF_LINES        /* Sentinel */
 } REF_LineKind;
 
+#ifndef STBL_HOST /* the sumo simulator only uses the definitions above */
+#include "Platform.h"
+#if PL_CONFIG_HAS_REFLECTANCE
+
 REF_LineKind REF_GetLineKind(void);
 
 void REF_GetSensorValues(uint16_t *values, int nofValues);
 
+#if PL_CONFIG_HAS_MOTOR
+/*!
+ * \brief Enables or disables the sumo border escape reflex. If enabled, the motors are set to back up and turn away
+ * right after the measurement which detects the ring border, before any strategy task runs.
+ * \param on TRUE to enable the reflex.
+ */
+void REF_SetBorderReflex(bool on);
+
+/*!
+ * \brief Returns if the border reflex has been triggered since the last call, and clears the flag.
+ * The strategy should take over the motors if this returns TRUE.
+ * \return TRUE if the reflex has been triggered.
+ */
+bool REF_BorderReflexTriggered(void);
+#endif
+
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
   
@@ -86,5 +104,6 @@ void REF_Deinit(void);
 void REF_Init(void);
 
 #endif /* PL_CONFIG_HAS_REFLECTANCE */
+#endif /* STBL_HOST */
 
 #endif /* REFLECTANCE_H_ */
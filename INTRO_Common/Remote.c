@@ -30,7 +30,11 @@
   #include "LED.h"
 #endif
 #if PL_CONFIG_HAS_JOYSTICK
-  #include "AD1.h"
+  #if PL_CONFIG_HAS_ADC_SERVICE
+    #include "AdcService.h"
+  #else
+    #include "AD1.h"
+  #endif
 #endif
 #if PL_CONFIG_HAS_SHELL
   #include "Shell.h"
@@ -89,6 +93,17 @@ static uint8_t REMOTE_GetXY(uint16_t *x, uint16_t *y, int8_t *x8, int8_t *y8) {
   uint8_t res;
   uint16_t values[2];
 
+#if PL_CONFIG_HAS_ADC_SERVICE
+  /* latest oversampled values, does not wait for a conversion */
+  res = ADCS_GetValue(ADCS_CH_JOY_X, &values[0]);
+  if (res!=ERR_OK) {
+    return res;
+  }
+  res = ADCS_GetValue(ADCS_CH_JOY_Y, &values[1]);
+  if (res!=ERR_OK) {
+    return res;
+  }
+#else
   res = AD1_Measure(TRUE);
   if (res!=ERR_OK) {
     return res;
@@ -97,6 +112,7 @@ static uint8_t REMOTE_GetXY(uint16_t *x, uint16_t *y, int8_t *x8, int8_t *y8) {
   if (res!=ERR_OK) {
     return res;
   }
+#endif
   if (x!=NULL) {
     *x = values[0];
   }
@@ -116,7 +132,13 @@ static uint8_t REMOTE_GetXY(uint16_t *x, uint16_t *y, int8_t *x8, int8_t *y8) {
 static void RemoteTask (void *pvParameters) {
   (void)pvParameters;
 #if PL_CONFIG_HAS_JOYSTICK
+#if PL_CONFIG_HAS_ADC_SERVICE
+  while (REMOTE_GetXY(&midPointX, &midPointY, NULL, NULL)!=ERR_OK) {
+    FRTOS1_vTaskDelay(10/portTICK_PERIOD_MS); /* wait until the ADC service has enough conversions */
+  }
+#else
   (void)REMOTE_GetXY(&midPointX, &midPointY, NULL, NULL);
+#endif
 #endif
   FRTOS1_vTaskDelay(1000/portTICK_PERIOD_MS);
   for(;;) {
@@ -325,7 +347,7 @@ uint8_t REMOTE_HandleRemoteRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *
   #if PL_CONFIG_HAS_BATTERY_ADC
         uint16_t centiV;
 
-        if (BATT_MeasureBatteryVoltage(&centiV)!=ERR_OK) {
+        if (BATT_GetFilteredVoltage(&centiV)!=ERR_OK) {
           centiV = 0; /* error case */
         }
         RNETA_SendIdValuePairMessage(RAPP_MSG_TYPE_QUERY_VALUE_RESPONSE, id, centiV, srcAddr, RPHY_PACKET_FLAGS_NONE);
@@ -39,12 +39,18 @@
   #include "Q4CLeft.h"
   #include "Q4CRight.h"
 #endif
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
 #if PL_CONFIG_HAS_QUAD_CALIBRATION
   #include "QuadCalib.h"
 #endif
 #if PL_CONFIG_HAS_MOTOR_TACHO
   #include "Tacho.h"
 #endif
+#if PL_CONFIG_HAS_MOTOR_CALIBRATION
+  #include "MotorCalib.h"
+#endif
 #if PL_CONFIG_HAS_ULTRASONIC
   #include "Ultrasonic.h"
 #endif
@@ -54,12 +60,21 @@
 #if PL_CONFIG_HAS_DRIVE
   #include "Drive.h"
 #endif
+#if PL_CONFIG_HAS_TRACTION
+  #include "Traction.h"
+#endif
 #if PL_CONFIG_HAS_TURN
   #include "Turn.h"
 #endif
+#if PL_CONFIG_HAS_TURN_CALIBRATION
+  #include "TurnCalib.h"
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   #include "LineFollow.h"
 #endif
+#if PL_CONFIG_HAS_LAP_LEARN
+  #include "LapLearn.h"
+#endif
 #if PL_CONFIG_HAS_RADIO
   #include "RApp.h"
   #include "RNet_App.h"
@@ -74,15 +89,30 @@
 #if PL_CONFIG_HAS_LINE_MAZE
   #include "Maze.h"
 #endif
+#if PL_CONFIG_HAS_MAZE_MAP
+  #include "MazeMap.h"
+#endif
+#if PL_CONFIG_HAS_MAZE_RUN
+  #include "MazeRun.h"
+#endif
 #if PL_CONFIG_HAS_USB_CDC
   #include "CDC1.h"
 #endif
 #if PL_CONFIG_HAS_BATTERY_ADC
   #include "Battery.h"
 #endif
+#if PL_CONFIG_HAS_ADC_SERVICE
+  #include "AdcService.h"
+#endif
 #if PL_HAS_DISTANCE_SENSOR
   #include "Distance.h"
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  #include "Odometry.h"
+#endif
+#if PL_CONFIG_HAS_OPPONENT
+  #include "Opponent.h"
+#endif
 #include "KIN1.h"
 #include "TmDt1.h"
 #if PL_CONFIG_HAS_SUMO
@@ -245,7 +275,9 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if PL_CONFIG_HAS_MCP4728
    MCP4728_ParseCommand,
 #endif
-#if PL_CONFIG_HAS_QUADRATURE
+#if PL_CONFIG_HAS_QUAD_FTM
+  QFTM_ParseCommand,
+#elif PL_CONFIG_HAS_QUADRATURE
   Q4CLeft_ParseCommand,
   Q4CRight_ParseCommand,
 #endif
@@ -255,6 +287,9 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if PL_CONFIG_HAS_MOTOR_TACHO
   TACHO_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_MOTOR_CALIBRATION
+  MOTCAL_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_ULTRASONIC
   US_ParseCommand,
 #endif
@@ -267,15 +302,27 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if PL_CONFIG_HAS_BATTERY_ADC
   BATT_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_ADC_SERVICE
+  ADCS_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_DRIVE
   DRV_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_TRACTION
+  TRAC_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_TURN
   TURN_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_TURN_CALIBRATION
+  TCAL_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_LINE_FOLLOW
   LF_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_LAP_LEARN
+  LAP_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_RADIO
 #if RNET1_PARSE_COMMAND_ENABLED
   RNET1_ParseCommand,
@@ -288,12 +335,24 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if PL_CONFIG_HAS_LINE_MAZE
   MAZE_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_MAZE_MAP
+  MMAP_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_MAZE_RUN
+  MRUN_ParseCommand,
+#endif
 #if TmDt1_PARSE_COMMAND_ENABLED
   TmDt1_ParseCommand,
 #endif
 #if PL_HAS_DISTANCE_SENSOR
   DIST_ParseCommand,
 #endif
+#if PL_CONFIG_HAS_ODOMETRY
+  ODO_ParseCommand,
+#endif
+#if PL_CONFIG_HAS_OPPONENT
+  OPP_ParseCommand,
+#endif
 #if PL_CONFIG_HAS_SUMO
   SUMO_ParseCommand,
 #endif
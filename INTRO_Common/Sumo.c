@@ -3,22 +3,84 @@
  *
  *  Created on: 16.05.2017
  *      Author: Erich Styger
+ *
+ * Sumo strategy engine: the behavior of the robot is a table of rules (see SumoTable.c). Each rule has a set of
+ * inputs which all have to be present (border, ToF, opponent tracker) and the motor speeds to apply, either until
+ * another rule fires (duration 0) or for a given time. This task fuses the sensors into the inputs and evaluates
+ * the table every control cycle. The built-in strategies are copied into RAM, so rules and parameters can be
+ * changed at runtime from the shell or over the radio.
+ * The input fusion (SUMO_FuseInputs()) is hardware independent and compiled with STBL_HOST defined for the
+ * simulator in INTRO_SumoSim, so the tournament runs the same border and opponent logic as the robot.
  */
-#include "Platform.h"
-
-#if PL_CONFIG_HAS_SUMO
+#ifdef STBL_HOST
+  #define SUMO_ENABLED  1
+#else
+  #include "Platform.h"
+  #define SUMO_ENABLED  PL_CONFIG_HAS_SUMO
+#endif
+#if SUMO_ENABLED
 #include "Sumo.h"
+#include "SumoTable.h"
+#include "Reflectance.h"
+
+#define SUMO_OPP_BEARING_DEG 20 /* opponent is left or right if it is more than this off the center */
+
+uint16_t SUMO_FuseInputs(STBL_Engine *engine, const SUMO_Sensors *sensors, const int16_t params[SUMO_NOF_PARAMS]) {
+  uint16_t in = 0;
+
+  if (sensors->reflex || sensors->lineKind!=REF_LINE_FULL) {
+    in |= STBL_IN_BORDER;
+    if (sensors->ref[0]<REF_BORDER_THRESHOLD) {
+      in |= STBL_IN_BORDER_LEFT;
+    }
+    if (sensors->ref[REF_NOF_SENSORS-1]<REF_BORDER_THRESHOLD) {
+      in |= STBL_IN_BORDER_RIGHT;
+    }
+    if (sensors->reflex) {
+      STBL_Reset(engine); /* motors have been changed: force the rule to be applied again */
+    }
+  }
+  if (sensors->front>=0 && sensors->front<=params[SUMO_PARAM_FRONT]) {
+    in |= STBL_IN_FRONT;
+  }
+  if (sensors->rear>=0 && sensors->rear<=params[SUMO_PARAM_REAR]) {
+    in |= STBL_IN_REAR;
+  }
+  if (sensors->left>=0 && sensors->left<=params[SUMO_PARAM_SIDE]) {
+    in |= STBL_IN_LEFT;
+  }
+  if (sensors->right>=0 && sensors->right<=params[SUMO_PARAM_SIDE]) {
+    in |= STBL_IN_RIGHT;
+  }
+  if (sensors->oppValid) {
+    if (sensors->oppBearing>SUMO_OPP_BEARING_DEG) {
+      in |= STBL_IN_OPP_LEFT;
+    } else if (sensors->oppBearing<-SUMO_OPP_BEARING_DEG) {
+      in |= STBL_IN_OPP_RIGHT;
+    }
+  }
+  return in;
+}
+
+#ifndef STBL_HOST /* the rest of the module runs on the robot only */
 #include "FRTOS1.h"
 #include "Drive.h"
-#include "Reflectance.h"
-#include "Turn.h"
+#include "Motor.h"
+#include "Distance.h"
+#if PL_CONFIG_HAS_OPPONENT
+  #include "Opponent.h"
+#endif
 #include "CLS1.h"
-#include "Buzzer.h"
 #include "UTIL1.h"
+#if PL_CONFIG_HAS_RADIO
+  #include "RNet_App.h"
+  #include "RNet_AppConfig.h"
+#endif
 
 typedef enum {
   SUMO_STATE_IDLE,
   SUMO_STATE_START_DRIVING,
+  SUMO_STATE_WAIT_START,
   SUMO_STATE_DRIVING,
 } SUMO_State_t;
 
@@ -29,8 +91,128 @@ static TaskHandle_t sumoTaskHndl;
 #define SUMO_START_SUMO (1<<0)  /* start sumo mode */
 #define SUMO_STOP_SUMO  (1<<1)  /* stop stop sumo */
 
+static const char *const SUMO_ParamNames[SUMO_NOF_PARAMS] = {"front", "side", "rear", "delay"};
+static int16_t SUMO_params[SUMO_NOF_PARAMS] = {100, 200, 100, 0};
+
+/* active strategy */
+static uint8_t SUMO_strategyIdx = 0;
+static STBL_Engine SUMO_engine;
+static TickType_t SUMO_startTicks;
+static uint16_t SUMO_lastInputs;
+
+/* timing, with the core cycle counter */
+#define SUMO_CYCLES()        DWT_CYCCNT
+#define SUMO_CYCLES_PER_US   (configCPU_CLOCK_HZ/1000000)
+
+typedef struct {
+  uint16_t fired; /* number of times the rule has set the motors */
+  uint16_t lastUs, maxUs; /* from the start of the cycle (sensor fusion) to the motor command */
+} SUMO_RuleStat;
+
+static SUMO_RuleStat SUMO_ruleStats[STBL_MAX_RULES];
+static uint16_t SUMO_inputLastUs, SUMO_inputMaxUs; /* time for the sensor fusion */
+static uint16_t SUMO_evalLastUs, SUMO_evalMaxUs; /* time for the evaluation of the table */
+
+static uint16_t CyclesToUs(uint32_t cycles) {
+  cycles /= SUMO_CYCLES_PER_US;
+  return (uint16_t)(cycles>0xffff?0xffff:cycles);
+}
+
+static void ResetStats(void) {
+  int i;
+
+  for(i=0;i<STBL_MAX_RULES;i++) {
+    SUMO_ruleStats[i].fired = 0;
+    SUMO_ruleStats[i].lastUs = 0;
+    SUMO_ruleStats[i].maxUs = 0;
+  }
+  SUMO_inputLastUs = SUMO_inputMaxUs = 0;
+  SUMO_evalLastUs = SUMO_evalMaxUs = 0;
+}
+
+static uint8_t SUMO_SelectStrategy(uint8_t idx) {
+  if (idx>=STBL_NofStrategies) {
+    return ERR_RANGE;
+  }
+  taskENTER_CRITICAL();
+  SUMO_strategyIdx = idx;
+  STBL_Load(&SUMO_engine, &STBL_Strategies[idx]);
+  taskEXIT_CRITICAL();
+  ResetStats();
+  return ERR_OK;
+}
+
+static uint8_t SUMO_SetParam(uint8_t param, int16_t value) {
+  if (param>=SUMO_NOF_PARAMS || value<0) {
+    return ERR_RANGE;
+  }
+  SUMO_params[param] = value;
+  return ERR_OK;
+}
+
+/* reads the sensors for the input fusion */
+static void ReadSensors(SUMO_Sensors *sensors) {
+#if PL_CONFIG_HAS_OPPONENT
+  int16_t oppRange;
+#endif
+
+  sensors->reflex = REF_BorderReflexTriggered(); /* motors have been set by the reflex, the strategy has to take over */
+  sensors->lineKind = REF_GetLineKind();
+  REF_GetSensorValues(sensors->ref, REF_NOF_SENSORS);
+#if PL_HAS_TOF_SENSOR
+  sensors->front = DIST_GetDistance(DIST_SENSOR_FRONT);
+  sensors->rear = DIST_GetDistance(DIST_SENSOR_REAR);
+  sensors->left = DIST_GetDistance(DIST_SENSOR_LEFT);
+  sensors->right = DIST_GetDistance(DIST_SENSOR_RIGHT);
+#else
+  sensors->front = sensors->rear = sensors->left = sensors->right = -1; /* nothing seen */
+#endif
+#if PL_CONFIG_HAS_OPPONENT
+  sensors->oppValid = OPP_GetTarget(&sensors->oppBearing, &oppRange);
+#else
+  sensors->oppValid = FALSE;
+  sensors->oppBearing = 0;
+#endif
+}
+
+/* one control cycle: fuse the inputs, find the first matching rule and apply it */
+static void SUMO_Evaluate(void) {
+  SUMO_Sensors sensors;
+  uint32_t start, t;
+  uint16_t in, us;
+  uint8_t rule;
+  int8_t left, right;
+
+  start = SUMO_CYCLES();
+  ReadSensors(&sensors);
+  in = SUMO_FuseInputs(&SUMO_engine, &sensors, SUMO_params);
+  SUMO_lastInputs = in;
+  t = SUMO_CYCLES();
+  us = CyclesToUs(t-start);
+  SUMO_inputLastUs = us;
+  if (us>SUMO_inputMaxUs) {
+    SUMO_inputMaxUs = us;
+  }
+  rule = STBL_Step(&SUMO_engine, in, FRTOS1_xTaskGetTickCount()*portTICK_PERIOD_MS, &left, &right);
+  if (rule!=STBL_RULE_NONE) { /* new rule fires */
+    MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_LEFT), left);
+    MOT_SetSpeedPercent(MOT_GetMotorHandle(MOT_MOTOR_RIGHT), right);
+    us = CyclesToUs(SUMO_CYCLES()-start);
+    SUMO_ruleStats[rule].fired++;
+    SUMO_ruleStats[rule].lastUs = us;
+    if (us>SUMO_ruleStats[rule].maxUs) {
+      SUMO_ruleStats[rule].maxUs = us;
+    }
+  }
+  us = CyclesToUs(SUMO_CYCLES()-t);
+  SUMO_evalLastUs = us;
+  if (us>SUMO_evalMaxUs) {
+    SUMO_evalMaxUs = us;
+  }
+}
+
 bool SUMO_IsRunningSumo(void) {
-  return sumoState==SUMO_STATE_DRIVING;
+  return sumoState==SUMO_STATE_DRIVING || sumoState==SUMO_STATE_WAIT_START;
 }
 
 void SUMO_StartSumo(void) {
@@ -51,7 +233,6 @@ void SUMO_StartStopSumo(void) {
 
 static void SumoRun(void) {
   uint32_t notifcationValue;
-  /*! \todo extend as needed */
 
   (void)xTaskNotifyWait(0UL, SUMO_START_SUMO|SUMO_STOP_SUMO, &notifcationValue, 0); /* check flags */
   for(;;) { /* breaks */
@@ -64,17 +245,37 @@ static void SumoRun(void) {
         return;
 
       case SUMO_STATE_START_DRIVING:
-        DRV_SetSpeed(1000, 1000);
-        DRV_SetMode(DRV_MODE_SPEED);
+        if (!REF_IsReady()) {
+          CLS1_SendStr((unsigned char*)"Line sensors not ready\r\n", CLS1_GetStdio()->stdErr);
+          sumoState = SUMO_STATE_IDLE;
+          return;
+        }
+        DRV_SetMode(DRV_MODE_NONE); /* the strategy sets the motors */
+        STBL_Reset(&SUMO_engine);
+        SUMO_startTicks = FRTOS1_xTaskGetTickCount();
+        sumoState = SUMO_STATE_WAIT_START;
+        break; /* handle next state */
+
+      case SUMO_STATE_WAIT_START:
+        if (notifcationValue&SUMO_STOP_SUMO) {
+          sumoState = SUMO_STATE_IDLE;
+          return;
+        }
+        if ((int32_t)(FRTOS1_xTaskGetTickCount()-SUMO_startTicks)<(int32_t)pdMS_TO_TICKS(SUMO_params[SUMO_PARAM_DELAY])) {
+          return;
+        }
+        REF_SetBorderReflex(TRUE);
         sumoState = SUMO_STATE_DRIVING;
         break; /* handle next state */
 
       case SUMO_STATE_DRIVING:
         if (notifcationValue&SUMO_STOP_SUMO) {
+           REF_SetBorderReflex(FALSE);
            DRV_SetMode(DRV_MODE_STOP);
            sumoState = SUMO_STATE_IDLE;
            break; /* handle next state */
         }
+        SUMO_Evaluate();
         return;
 
       default: /* should not happen? */
@@ -91,13 +292,79 @@ static void SumoTask(void* param) {
   }
 }
 
+#if PL_CONFIG_HAS_RADIO
+uint8_t SUMO_HandleRadioRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *data, RNWK_ShortAddrType srcAddr, bool *handled, RPHY_PacketDesc *packet) {
+  uint16_t msgID;
+  uint32_t msgValue;
+
+  (void)size;
+  (void)packet;
+  switch(type) {
+    case RAPP_MSG_TYPE_REQUEST_SET_VALUE:
+      msgID = UTIL1_GetValue16LE(&data[0]); /* ID in little endian format */
+      msgValue = UTIL1_GetValue32LE(&data[2]);
+      if (msgID==RAPP_MSG_TYPE_DATA_ID_START_STOP) {
+        *handled = TRUE;
+        if (msgValue!=0) {
+          SUMO_StartSumo();
+        } else {
+          SUMO_StopSumo();
+        }
+      } else if (msgID==RAPP_MSG_TYPE_DATA_ID_SUMO_STRATEGY) {
+        *handled = TRUE;
+        if (!SUMO_IsRunningSumo()) {
+          (void)SUMO_SelectStrategy((uint8_t)msgValue);
+        }
+      } else if (msgID==RAPP_MSG_TYPE_DATA_ID_SUMO_PARAM) {
+        *handled = TRUE;
+        (void)SUMO_SetParam((uint8_t)(msgValue>>16), (int16_t)(msgValue&0xffff));
+      }
+      break;
+
+    case RAPP_MSG_TYPE_QUERY_VALUE:
+      msgID = UTIL1_GetValue16LE(&data[0]); /* ID in little endian format */
+      if (msgID==RAPP_MSG_TYPE_DATA_ID_START_STOP) {
+        *handled = TRUE;
+        (void)RNETA_SendIdValuePairMessage(RAPP_MSG_TYPE_QUERY_VALUE_RESPONSE, msgID, SUMO_IsRunningSumo()?1:0, srcAddr, RPHY_PACKET_FLAGS_NONE);
+      } else if (msgID==RAPP_MSG_TYPE_DATA_ID_SUMO_STRATEGY) {
+        *handled = TRUE;
+        (void)RNETA_SendIdValuePairMessage(RAPP_MSG_TYPE_QUERY_VALUE_RESPONSE, msgID, SUMO_strategyIdx, srcAddr, RPHY_PACKET_FLAGS_NONE);
+      }
+      break;
+
+    default:
+      break;
+  } /* switch */
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_RADIO */
+
+static void InputsToStr(unsigned char *buf, size_t bufSize, uint16_t inputs) {
+  int i;
+
+  if (inputs==0) {
+    UTIL1_strcat(buf, bufSize, (unsigned char*)"always");
+    return;
+  }
+  for(i=0;i<STBL_NOF_INPUTS;i++) {
+    if (inputs&(1<<i)) {
+      UTIL1_strcat(buf, bufSize, (unsigned char*)STBL_InputNames[i]);
+      if (inputs>>(i+1)) {
+        UTIL1_chcat(buf, bufSize, '+');
+      }
+    }
+  }
+}
+
 static uint8_t SUMO_PrintHelp(const CLS1_StdIOType *io) {
-  CLS1_SendHelpStr("sumo", "Group of sumo commands\r\n", io->stdOut);
-  CLS1_SendHelpStr("  help|status", "Print help or status information\r\n", io->stdOut);
-  CLS1_SendHelpStr("  start|stop", "Start and stop Sumo mode\r\n", io->stdOut);
-#if PL_HAS_TOF_SENSOR
-  CLS1_SendHelpStr("  radar (on|off)", "Sumo radar buzzer on or off\r\n", io->stdOut);
-#endif
+  CLS1_SendHelpStr((unsigned char*)"sumo", (unsigned char*)"Group of sumo commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Print help or status information\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  start|stop", (unsigned char*)"Start and stop Sumo mode\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  strategy <name>", (unsigned char*)"Selects a strategy: primitive, spiral or defensive (resets the rules)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  param <name> <val>", (unsigned char*)"Sets a parameter: front, side, rear (mm) or delay (ms)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  rule <n> <in> <l> <r> <ms>", (unsigned char*)"Sets rule n: inputs (hex mask, 0 always), motor % left/right, time (0 until next rule)\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  rules", (unsigned char*)"Prints the rules with count and latency from sensors to motors\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  reset", (unsigned char*)"Resets the counts and latencies\r\n", io->stdOut);
   return ERR_OK;
 }
 
@@ -107,41 +374,171 @@ static uint8_t SUMO_PrintHelp(const CLS1_StdIOType *io) {
  * \return ERR_OK or failure code
  */
 static uint8_t SUMO_PrintStatus(const CLS1_StdIOType *io) {
-  CLS1_SendStatusStr("sumo", "\r\n", io->stdOut);
+  unsigned char buf[48];
+  int i;
+
+  CLS1_SendStatusStr((unsigned char*)"sumo", (unsigned char*)"\r\n", io->stdOut);
   if (sumoState==SUMO_STATE_IDLE) {
-    CLS1_SendStatusStr("  running", "no\r\n", io->stdOut);
+    CLS1_SendStatusStr((unsigned char*)"  running", (unsigned char*)"no\r\n", io->stdOut);
   } else {
-    CLS1_SendStatusStr("  running", "yes\r\n", io->stdOut);
+    CLS1_SendStatusStr((unsigned char*)"  running", (unsigned char*)"yes\r\n", io->stdOut);
+  }
+  UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)STBL_Strategies[SUMO_strategyIdx].name);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  strategy", buf, io->stdOut);
+  buf[0] = '\0';
+  for(i=0;i<SUMO_NOF_PARAMS;i++) {
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)SUMO_ParamNames[i]);
+    UTIL1_chcat(buf, sizeof(buf), ' ');
+    UTIL1_strcatNum16s(buf, sizeof(buf), SUMO_params[i]);
+    UTIL1_strcat(buf, sizeof(buf), i<SUMO_NOF_PARAMS-1?(unsigned char*)", ":(unsigned char*)"\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  params", buf, io->stdOut);
+  buf[0] = '\0';
+  InputsToStr(buf, sizeof(buf), SUMO_lastInputs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  inputs", buf, io->stdOut);
+  if (SUMO_engine.activeRule==STBL_RULE_NONE) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"none\r\n");
+  } else {
+    UTIL1_Num8uToStr(buf, sizeof(buf), SUMO_engine.activeRule);
+    UTIL1_strcat(buf, sizeof(buf), SUMO_engine.actionTimed?(unsigned char*)" (timed)\r\n":(unsigned char*)"\r\n");
+  }
+  CLS1_SendStatusStr((unsigned char*)"  active rule", buf, io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), SUMO_inputLastUs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us, max ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), SUMO_inputMaxUs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  sensor time", buf, io->stdOut);
+  UTIL1_Num16uToStr(buf, sizeof(buf), SUMO_evalLastUs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us, max ");
+  UTIL1_strcatNum16u(buf, sizeof(buf), SUMO_evalMaxUs);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  table time", buf, io->stdOut);
+  return ERR_OK;
+}
+
+static uint8_t SUMO_PrintRules(const CLS1_StdIOType *io) {
+  unsigned char buf[72], name[8];
+  int i;
+
+  for(i=0;i<SUMO_engine.nofRules;i++) {
+    UTIL1_strcpy(name, sizeof(name), (unsigned char*)"  ");
+    UTIL1_strcatNum8u(name, sizeof(name), (uint8_t)i);
+    buf[0] = '\0';
+    InputsToStr(buf, sizeof(buf), SUMO_engine.rules[i].inputs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)": ");
+    UTIL1_strcatNum8s(buf, sizeof(buf), SUMO_engine.rules[i].left);
+    UTIL1_chcat(buf, sizeof(buf), '/');
+    UTIL1_strcatNum8s(buf, sizeof(buf), SUMO_engine.rules[i].right);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"% ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), SUMO_engine.rules[i].ms);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" ms, fired ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), SUMO_ruleStats[i].fired);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), SUMO_ruleStats[i].lastUs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us, max ");
+    UTIL1_strcatNum16u(buf, sizeof(buf), SUMO_ruleStats[i].maxUs);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" us\r\n");
+    CLS1_SendStatusStr(name, buf, io->stdOut);
   }
   return ERR_OK;
 }
 
+static uint8_t ParseRule(const unsigned char *p, const CLS1_StdIOType *io) {
+  int32_t idx, inputs, left, right, ms;
+
+  if (   UTIL1_xatoi(&p, &idx)!=ERR_OK || UTIL1_xatoi(&p, &inputs)!=ERR_OK
+      || UTIL1_xatoi(&p, &left)!=ERR_OK || UTIL1_xatoi(&p, &right)!=ERR_OK
+      || UTIL1_xatoi(&p, &ms)!=ERR_OK)
+  {
+    CLS1_SendStr((unsigned char*)"**** wrong arguments, use: sumo rule <n> <inputs> <left> <right> <ms>\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  if (   idx<0 || idx>SUMO_engine.nofRules || idx>=STBL_MAX_RULES || inputs<0 || inputs>=(1<<STBL_NOF_INPUTS)
+      || left<-100 || left>100 || right<-100 || right>100 || ms<0 || ms>0xffff)
+  {
+    CLS1_SendStr((unsigned char*)"**** value out of range\r\n", io->stdErr);
+    return ERR_RANGE;
+  }
+  taskENTER_CRITICAL();
+  SUMO_engine.rules[idx].inputs = (uint16_t)inputs;
+  SUMO_engine.rules[idx].left = (int8_t)left;
+  SUMO_engine.rules[idx].right = (int8_t)right;
+  SUMO_engine.rules[idx].ms = (uint16_t)ms;
+  if (idx==SUMO_engine.nofRules) { /* append a new rule */
+    SUMO_engine.nofRules++;
+  }
+  STBL_Reset(&SUMO_engine); /* apply again */
+  taskEXIT_CRITICAL();
+  return ERR_OK;
+}
+
 uint8_t SUMO_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  const unsigned char *p;
+  int32_t val;
+  int i;
+
   if (UTIL1_strcmp((char*)cmd, CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, "sumo help")==0) {
     *handled = TRUE;
     return SUMO_PrintHelp(io);
   } else if (UTIL1_strcmp((char*)cmd, CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, "sumo status")==0) {
     *handled = TRUE;
     return SUMO_PrintStatus(io);
-  } else if (UTIL1_strcmp(cmd, "sumo start")==0) {
+  } else if (UTIL1_strcmp((char*)cmd, "sumo start")==0) {
     *handled = TRUE;
     SUMO_StartSumo();
-  } else if (UTIL1_strcmp(cmd, "sumo stop")==0) {
+  } else if (UTIL1_strcmp((char*)cmd, "sumo stop")==0) {
     *handled = TRUE;
     SUMO_StopSumo();
-#if PL_HAS_TOF_SENSOR
-  } else if (UTIL1_strcmp(cmd, "sumo radar on")==0) {
+  } else if (UTIL1_strncmp((char*)cmd, "sumo strategy ", sizeof("sumo strategy ")-1)==0) {
     *handled = TRUE;
-    sumoRadar = TRUE;
-  } else if (UTIL1_strcmp(cmd, "sumo radar off")==0) {
+    p = cmd+sizeof("sumo strategy ")-1;
+    if (SUMO_IsRunningSumo()) {
+      CLS1_SendStr((unsigned char*)"**** stop sumo first\r\n", io->stdErr);
+      return ERR_BUSY;
+    }
+    for(i=0;i<STBL_NofStrategies;i++) {
+      if (UTIL1_strcmp((char*)p, STBL_Strategies[i].name)==0) {
+        return SUMO_SelectStrategy((uint8_t)i);
+      }
+    }
+    CLS1_SendStr((unsigned char*)"**** unknown strategy\r\n", io->stdErr);
+    return ERR_FAILED;
+  } else if (UTIL1_strncmp((char*)cmd, "sumo param ", sizeof("sumo param ")-1)==0) {
     *handled = TRUE;
-    sumoRadar = FALSE;
-#endif
+    p = cmd+sizeof("sumo param ")-1;
+    for(i=0;i<SUMO_NOF_PARAMS;i++) {
+      size_t len = UTIL1_strlen(SUMO_ParamNames[i]);
+
+      if (UTIL1_strncmp((char*)p, SUMO_ParamNames[i], len)==0 && p[len]==' ') {
+        p += len;
+        if (UTIL1_xatoi(&p, &val)==ERR_OK && val>=0 && val<=0x7fff) {
+          return SUMO_SetParam((uint8_t)i, (int16_t)val);
+        }
+        CLS1_SendStr((unsigned char*)"**** wrong value\r\n", io->stdErr);
+        return ERR_FAILED;
+      }
+    }
+    CLS1_SendStr((unsigned char*)"**** unknown parameter\r\n", io->stdErr);
+    return ERR_FAILED;
+  } else if (UTIL1_strncmp((char*)cmd, "sumo rule ", sizeof("sumo rule ")-1)==0) {
+    *handled = TRUE;
+    return ParseRule(cmd+sizeof("sumo rule ")-1, io);
+  } else if (UTIL1_strcmp((char*)cmd, "sumo rules")==0) {
+    *handled = TRUE;
+    return SUMO_PrintRules(io);
+  } else if (UTIL1_strcmp((char*)cmd, "sumo reset")==0) {
+    *handled = TRUE;
+    ResetStats();
   }
   return ERR_OK;
 }
 
 void SUMO_Init(void) {
+  DEMCR |= (1<<24); /* TRCENA: enable the DWT, for the timing of the rules */
+  DWT_CTRL |= (1<<0); /* CYCCNTENA: enable the cycle counter */
+  (void)SUMO_SelectStrategy(0);
   if (xTaskCreate(SumoTask, "Sumo", 500/sizeof(StackType_t), NULL, tskIDLE_PRIORITY+2, &sumoTaskHndl) != pdPASS) {
     for(;;){} /* error case only, stay here! */
   }
@@ -150,4 +547,5 @@ void SUMO_Init(void) {
 void SUMO_Deinit(void) {
 }
 
-#endif /* PL_CONFIG_HAS_SUMO */
+#endif /* STBL_HOST */
+#endif /* SUMO_ENABLED */
@@ -8,6 +8,42 @@
 #ifndef SOURCES_INTRO_COMMON_SUMO_C_
 #define SOURCES_INTRO_COMMON_SUMO_C_
 
+#include <stdint.h>
+#include "SumoTable.h"
+#include "Reflectance.h"
+
+/* parameters */
+typedef enum {
+  SUMO_PARAM_FRONT,  /* front detection range in mm */
+  SUMO_PARAM_SIDE,   /* side detection range in mm */
+  SUMO_PARAM_REAR,   /* rear detection range in mm */
+  SUMO_PARAM_DELAY,  /* delay after start in ms */
+  SUMO_NOF_PARAMS
+} SUMO_Param;
+
+/*!
+ * \brief Sensor values of one control cycle, read by the Sumo task on the robot or simulated by INTRO_SumoSim.
+ */
+typedef struct {
+  uint8_t reflex; /*!< border reflex has set the motors since the last cycle */
+  REF_LineKind lineKind; /*!< REF_LINE_FULL while all line sensors are inside the ring */
+  uint16_t ref[REF_NOF_SENSORS]; /*!< calibrated line sensor values, sensor 0 is on the left */
+  int16_t front, rear, left, right; /*!< ToF ranges in mm, negative for no object or sensor errors */
+  uint8_t oppValid; /*!< if the opponent tracker has a target */
+  int16_t oppBearing; /*!< bearing of the target in degrees, positive to the left */
+} SUMO_Sensors;
+
+/*!
+ * \brief Fuses the sensor values into the inputs of the behavior table. Hardware independent, so it is compiled for
+ * the host with STBL_HOST defined too.
+ * \param engine Behavior table engine, reset if the border reflex has changed the motors.
+ * \param sensors Sensor values of this cycle.
+ * \param params Sumo parameters (SUMO_Param), with the detection ranges.
+ * \return Inputs present in this cycle (STBL_IN_ bits).
+ */
+uint16_t SUMO_FuseInputs(STBL_Engine *engine, const SUMO_Sensors *sensors, const int16_t params[SUMO_NOF_PARAMS]);
+
+#ifndef STBL_HOST
 #include "Platform.h"
 
 #if PL_CONFIG_HAS_SHELL
@@ -23,6 +59,17 @@
   uint8_t SUMO_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
 #endif
 
+#if PL_CONFIG_HAS_RADIO
+  #include "RApp.h"
+  #include "RNWK.h"
+  #include "RPHY.h"
+
+  /*!
+   * \brief Radio message handler: start/stop, strategy selection and parameters with RAPP_MSG_TYPE_REQUEST_SET_VALUE.
+   */
+  uint8_t SUMO_HandleRadioRxMessage(RAPP_MSG_Type type, uint8_t size, uint8_t *data, RNWK_ShortAddrType srcAddr, bool *handled, RPHY_PacketDesc *packet);
+#endif
+
 void SUMO_StartStopSumo(void);
 void SUMO_StartSumo(void);
 void SUMO_StopSumo(void);
@@ -31,5 +78,6 @@ bool SUMO_IsRunningSumo(void);
 void SUMO_Init(void);
 
 void SUMO_Deinit(void);
+#endif /* STBL_HOST */
 
 #endif /* SOURCES_INTRO_COMMON_SUMO_C_ */
@@ -0,0 +1,96 @@
+/**
+ * \file
+ * \brief Sumo behavior table.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Evaluation of the sumo behavior table and the built-in strategies. Hardware independent, so it can be
+ * compiled for the host with STBL_HOST defined (see INTRO_SumoSim).
+ */
+
+#ifdef STBL_HOST
+  #define STBL_ENABLED  1
+#else
+  #include "Platform.h"
+  #define STBL_ENABLED  PL_CONFIG_HAS_SUMO
+#endif
+#if STBL_ENABLED
+#include "SumoTable.h"
+
+const char *const STBL_InputNames[STBL_NOF_INPUTS] = {
+  "border", "bleft", "bright", "front", "rear", "left", "right", "oleft", "oright"
+};
+
+/*! \todo adopt the strategies to your robot */
+const STBL_Strategy STBL_Strategies[] = {
+  { "primitive", 9, { /* same as PrimitiveFight */
+      {STBL_IN_BORDER|STBL_IN_BORDER_LEFT, -100, 20, 400}, /* back up to the right */
+      {STBL_IN_BORDER,                     20, -100, 400}, /* back up to the left */
+      {STBL_IN_FRONT,                      100, 100, 0},   /* charge */
+      {STBL_IN_REAR,                       -100, -100, 0}, /* push backwards */
+      {STBL_IN_LEFT,                       -70, 70, 200},
+      {STBL_IN_RIGHT,                      70, -70, 200},
+      {STBL_IN_OPP_LEFT,                   -70, 70, 0},
+      {STBL_IN_OPP_RIGHT,                  70, -70, 0},
+      {0,                                  60, 60, 0},     /* search forward */
+    }
+  },
+  { "spiral", 3, { /* same as SpiralFight */
+      {STBL_IN_BORDER,                     25, 70, 500},   /* spiral in */
+      {STBL_IN_FRONT,                      100, 100, 0},
+      {0,                                  30, 65, 0},     /* spiral out */
+    }
+  },
+  { "defensive", 7, { /* stay in place and turn to the opponent, charge if it is in front */
+      {STBL_IN_BORDER|STBL_IN_BORDER_LEFT, -100, 20, 300},
+      {STBL_IN_BORDER,                     20, -100, 300},
+      {STBL_IN_FRONT,                      100, 100, 0},
+      {STBL_IN_REAR,                       70, -70, 400},  /* turn around */
+      {STBL_IN_LEFT,                       -60, 60, 0},
+      {STBL_IN_RIGHT,                      60, -60, 0},
+      {0,                                  0, 0, 0},
+    }
+  },
+};
+const uint8_t STBL_NofStrategies = sizeof(STBL_Strategies)/sizeof(STBL_Strategies[0]);
+
+void STBL_Load(STBL_Engine *engine, const STBL_Strategy *strategy) {
+  int i;
+
+  engine->nofRules = strategy->nofRules;
+  for(i=0;i<strategy->nofRules;i++) {
+    engine->rules[i] = strategy->rules[i]; /* struct copy */
+  }
+  STBL_Reset(engine);
+}
+
+void STBL_Reset(STBL_Engine *engine) {
+  engine->activeRule = STBL_RULE_NONE;
+  engine->actionTimed = 0;
+}
+
+uint8_t STBL_Step(STBL_Engine *engine, uint16_t inputs, uint32_t nowMs, int8_t *left, int8_t *right) {
+  uint8_t i, last;
+
+  if (engine->actionTimed && (int32_t)(nowMs-engine->actionEndMs)>=0) {
+    STBL_Reset(engine); /* timed action has finished: apply the next rule, even if it is the same */
+  }
+  last = engine->actionTimed?engine->activeRule:engine->nofRules; /* timed action: only rules above can interrupt it */
+  for(i=0;i<last;i++) {
+    if ((engine->rules[i].inputs&inputs)==engine->rules[i].inputs) {
+      break;
+    }
+  }
+  if (i>=last || i==engine->activeRule) {
+    return STBL_RULE_NONE; /* no change */
+  }
+  *left = engine->rules[i].left;
+  *right = engine->rules[i].right;
+  engine->activeRule = i;
+  engine->actionTimed = engine->rules[i].ms!=0;
+  if (engine->actionTimed) {
+    engine->actionEndMs = nowMs+engine->rules[i].ms;
+  }
+  return i;
+}
+
+#endif /* STBL_ENABLED */
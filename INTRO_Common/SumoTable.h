@@ -0,0 +1,83 @@
+/**
+ * \file
+ * \brief Interface to the sumo behavior table.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module evaluates the sumo behavior table: a list of rules with the inputs which have to be present and
+ * the motor speeds to apply. It does not use any hardware or RTOS, so it is used by the Sumo task on the robot
+ * and by the host simulator in INTRO_SumoSim.
+ */
+
+#ifndef SUMOTABLE_H_
+#define SUMOTABLE_H_
+
+#include <stdint.h>
+
+/* inputs of the rules, fused from the sensors every cycle */
+#define STBL_IN_BORDER        (1<<0) /* ring border seen by any line sensor */
+#define STBL_IN_BORDER_LEFT   (1<<1) /* ring border under the left sensor */
+#define STBL_IN_BORDER_RIGHT  (1<<2) /* ring border under the right sensor */
+#define STBL_IN_FRONT         (1<<3) /* object in front (ToF) */
+#define STBL_IN_REAR          (1<<4) /* object behind */
+#define STBL_IN_LEFT          (1<<5) /* object on the left side */
+#define STBL_IN_RIGHT         (1<<6) /* object on the right side */
+#define STBL_IN_OPP_LEFT      (1<<7) /* opponent tracker: opponent is to the left */
+#define STBL_IN_OPP_RIGHT     (1<<8) /* opponent tracker: opponent is to the right */
+#define STBL_NOF_INPUTS       9
+
+#define STBL_MAX_RULES        12
+#define STBL_RULE_NONE        0xff
+
+typedef struct {
+  uint16_t inputs; /*!< inputs which all need to be present, 0 for always */
+  int8_t left, right; /*!< motor speeds in percent */
+  uint16_t ms; /*!< duration of the action, 0 until another rule fires */
+} STBL_Rule;
+
+typedef struct {
+  const char *name;
+  uint8_t nofRules;
+  STBL_Rule rules[STBL_MAX_RULES];
+} STBL_Strategy;
+
+typedef struct {
+  uint8_t nofRules;
+  STBL_Rule rules[STBL_MAX_RULES]; /*!< copy of the strategy, can be changed at runtime */
+  uint8_t activeRule; /*!< rule which has set the motors, STBL_RULE_NONE if none */
+  uint8_t actionTimed; /*!< if the active rule is a timed action which is still running */
+  uint32_t actionEndMs; /*!< end of a timed action */
+} STBL_Engine;
+
+/*! \brief Built-in strategies */
+extern const STBL_Strategy STBL_Strategies[];
+/*! \brief Number of built-in strategies */
+extern const uint8_t STBL_NofStrategies;
+/*! \brief Names of the inputs, for printing */
+extern const char *const STBL_InputNames[STBL_NOF_INPUTS];
+
+/*!
+ * \brief Loads a strategy into the engine.
+ * \param engine Engine to initialize.
+ * \param strategy Strategy with the rules to copy.
+ */
+void STBL_Load(STBL_Engine *engine, const STBL_Strategy *strategy);
+
+/*!
+ * \brief Forgets the active rule, so the next STBL_Step() sets the motors again (e.g. after somebody else changed them).
+ * \param engine Engine to use.
+ */
+void STBL_Reset(STBL_Engine *engine);
+
+/*!
+ * \brief Evaluates the table for one control cycle. The first rule with all its inputs present wins, a running
+ * timed action can only be interrupted by a rule above it.
+ * \param engine Engine to use.
+ * \param inputs Inputs present in this cycle (STBL_IN_ bits).
+ * \param nowMs Current time in ms.
+ * \param left Where to store the left motor speed in percent, if a new rule fires.
+ * \param right Where to store the right motor speed in percent, if a new rule fires.
+ * \return Number of the rule which has fired, STBL_RULE_NONE if the motors do not need to change.
+ */
+uint8_t STBL_Step(STBL_Engine *engine, uint16_t inputs, uint32_t nowMs, int8_t *left, int8_t *right);
+
+#endif /* SUMOTABLE_H_ */
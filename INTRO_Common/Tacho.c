@@ -11,6 +11,9 @@
 #include "Tacho.h"    /* our own interface */
 #include "Q4CLeft.h"
 #include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
 #if PL_CONFIG_HAS_SHELL
   #include "CLS1.h"
 #endif
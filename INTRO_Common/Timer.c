@@ -18,12 +18,30 @@
 #if PL_CONFIG_HAS_MOTOR_TACHO
   #include "Tacho.h"
 #endif
+#if PL_HAS_FRONT_DISTANCE
+  #include "Distance.h"
+#endif
+#if PL_CONFIG_HAS_ADC_SERVICE
+  #include "AdcService.h"
+#endif
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
 #include "TMOUT1.h"
 #include "TmDt1.h"
 
 
 void TMR_OnInterrupt(void) {
   TRG_AddTick();
+#if PL_HAS_FRONT_DISTANCE
+  DIST_IR_OnInterrupt();
+#endif
+#if PL_CONFIG_HAS_ADC_SERVICE
+  ADCS_OnInterrupt();
+#endif
+#if PL_CONFIG_HAS_QUAD_FTM
+  QFTM_OnInterrupt();
+#endif
 }
 
 void TMR_Init(void) {
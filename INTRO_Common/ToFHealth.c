@@ -0,0 +1,147 @@
+/**
+ * \file
+ * \brief Health monitoring and recovery of the ToF sensors.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Hardware independent part of the ToF error handling, so it can be compiled for the host with TOFH_HOST
+ * defined (see INTRO_HostTest).
+ */
+
+#ifdef TOFH_HOST
+  #define TOFH_ENABLED  1
+#else
+  #include "Platform.h"
+  #define TOFH_ENABLED  PL_HAS_TOF_SENSOR
+#endif
+#if TOFH_ENABLED
+#include "ToFHealth.h"
+
+#if TOFH_CONFIG_FAULT_INJECTION
+void TOFH_InjectFaults(TOFH_Device *dev, uint8_t nofFaults) {
+  dev->nofInjectedFaults = nofFaults;
+}
+
+static uint8_t FaultInjected(TOFH_Device *dev, uint8_t consume) {
+  if (dev->nofInjectedFaults==0) {
+    return 0;
+  }
+  if (consume) {
+    dev->nofInjectedFaults--;
+  }
+  return 1; /* simulate I2C failure */
+}
+#endif
+
+static uint8_t ReadSingle(TOFH_Device dev[], uint8_t i, const TOFH_Bus *bus, int16_t *rangeP) {
+#if TOFH_CONFIG_FAULT_INJECTION
+  if (FaultInjected(&dev[i], 1)) {
+    *rangeP = TOFH_RANGE_DEVICE_ERROR;
+    return 0;
+  }
+#else
+  (void)dev;
+#endif
+  return bus->readSingle(i, rangeP);
+}
+
+static uint8_t ReInit(TOFH_Device dev[], uint8_t i, const TOFH_Bus *bus) {
+#if TOFH_CONFIG_FAULT_INJECTION
+  if (FaultInjected(&dev[i], 1)) {
+    return 0;
+  }
+#else
+  (void)dev;
+#endif
+  return bus->reInit(i);
+}
+
+static void ReadError(TOFH_Device *dev) {
+  dev->mm = TOFH_RANGE_DEVICE_ERROR;
+  dev->nofErrors++;
+  dev->errCntr++;
+  if (dev->errCntr>=TOFH_MAX_READ_RETRIES) {
+    dev->state = TOFH_STATE_REINIT;
+  } else {
+    dev->state = TOFH_STATE_RETRY;
+  }
+}
+
+void TOFH_Reset(TOFH_Device dev[], uint8_t nofDevices) {
+  uint8_t i;
+
+  for(i=0;i<nofDevices;i++) {
+    dev[i].mm = 0;
+    dev[i].state = TOFH_STATE_OK;
+    dev[i].errCntr = 0;
+    dev[i].reinitCntr = 0;
+#if TOFH_CONFIG_FAULT_INJECTION
+    dev[i].nofInjectedFaults = 0; /* power cycle clears any simulated fault */
+#endif
+  }
+}
+
+uint8_t TOFH_Read(TOFH_Device dev[], uint8_t nofDevices, const TOFH_Bus *bus) {
+  uint8_t devIdx[TOFH_MAX_DEVICES]; /* index of the healthy devices in dev[] */
+  int16_t range[TOFH_MAX_DEVICES];
+  uint8_t multipleFailed = 0, ok;
+  uint8_t i, nof;
+
+  /* measure all healthy devices at the same time */
+  nof = 0;
+  for(i=0;i<nofDevices && i<TOFH_MAX_DEVICES;i++) {
+    if (dev[i].state==TOFH_STATE_OK) {
+#if TOFH_CONFIG_FAULT_INJECTION
+      if (FaultInjected(&dev[i], 0)) {
+        multipleFailed = 1; /* simulate a failed bus transfer */
+      }
+#endif
+      devIdx[nof] = i;
+      nof++;
+    }
+  }
+  if (nof>0 && !multipleFailed) {
+    if (bus->readMultiple(devIdx, range, nof)) {
+      for(i=0;i<nof;i++) {
+        dev[devIdx[i]].mm = range[i];
+        dev[devIdx[i]].errCntr = 0;
+      }
+    } else {
+      multipleFailed = 1;
+    }
+  }
+  /* read devices one by one: this finds the failing device, or checks if a device has recovered */
+  for(i=0;i<nofDevices && i<TOFH_MAX_DEVICES;i++) {
+    if (dev[i].state==TOFH_STATE_RETRY || (multipleFailed && dev[i].state==TOFH_STATE_OK)) {
+      if (ReadSingle(dev, i, bus, &range[0])) {
+        dev[i].mm = range[0];
+        dev[i].errCntr = 0;
+        dev[i].state = TOFH_STATE_OK;
+      } else {
+        ReadError(&dev[i]);
+      }
+    }
+  }
+  /* re-initialize devices which failed too many times */
+  ok = 1;
+  for(i=0;i<nofDevices && i<TOFH_MAX_DEVICES;i++) {
+    if (dev[i].state==TOFH_STATE_REINIT) {
+      dev[i].nofReinit++;
+      if (ReInit(dev, i, bus)) {
+        dev[i].errCntr = 0;
+        dev[i].reinitCntr = 0;
+        dev[i].state = TOFH_STATE_OK;
+      } else {
+        dev[i].reinitCntr++;
+        if (dev[i].reinitCntr>=TOFH_MAX_DEVICE_REINIT) {
+          dev[i].state = TOFH_STATE_FAILED;
+        }
+      }
+    }
+    if (dev[i].state==TOFH_STATE_FAILED) {
+      ok = 0; /* device cannot be recovered on its own */
+    }
+  }
+  return ok;
+}
+
+#endif /* TOFH_ENABLED */
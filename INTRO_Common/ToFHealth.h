@@ -0,0 +1,80 @@
+/**
+ * \file
+ * \brief Interface to the health monitoring and recovery of the ToF sensors.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module keeps track of read errors of the ToF devices on the shared I2C bus and decides when a device is
+ * read on its own, when it gets re-initialized and when the whole bus needs to be reset. The I2C accesses are done
+ * by the caller through callbacks, so the module does not use any hardware or RTOS: it is used by the distance
+ * module on the robot and by the fault injection check in INTRO_HostTest.
+ */
+
+#ifndef TOFHEALTH_H_
+#define TOFHEALTH_H_
+
+#include <stdint.h>
+
+#ifndef TOFH_CONFIG_FAULT_INJECTION
+  #define TOFH_CONFIG_FAULT_INJECTION  (1) /* 1: support simulated I2C faults (e.g. with 'dist tof fault'); 0: no fault injection */
+#endif
+
+#define TOFH_MAX_DEVICES         4    /* maximum number of devices on the bus */
+#define TOFH_MAX_READ_RETRIES    3    /* number of consecutive read errors before a device gets re-addressed and re-initialized */
+#define TOFH_MAX_DEVICE_REINIT   3    /* number of consecutive failed device re-initializations before the whole bus gets reset */
+#define TOFH_RANGE_DEVICE_ERROR  (-3) /* range value reported for a device which is not available */
+
+typedef enum {
+  TOFH_STATE_OK,     /*!< device is working, used in the combined measurement */
+  TOFH_STATE_RETRY,  /*!< device had a read error, gets read on its own until it recovers */
+  TOFH_STATE_REINIT, /*!< device failed too often, needs to be re-addressed and re-initialized */
+  TOFH_STATE_FAILED  /*!< device re-initialization failed too, only a bus reset can help */
+} TOFH_State;
+
+typedef struct {
+  int16_t mm; /*!< distance in mm, negative values are error values */
+  TOFH_State state; /*!< device health state */
+  uint8_t errCntr; /*!< number of consecutive read errors */
+  uint8_t reinitCntr; /*!< number of consecutive failed re-initializations */
+  uint16_t nofErrors; /*!< total number of read errors */
+  uint16_t nofReinit; /*!< total number of device re-initializations */
+#if TOFH_CONFIG_FAULT_INJECTION
+  uint8_t nofInjectedFaults; /*!< number of simulated I2C faults still to be reported */
+#endif
+} TOFH_Device;
+
+typedef struct {
+  /*! reads the devices in devIdx[] with one combined measurement, returns 1 on success */
+  uint8_t (*readMultiple)(const uint8_t devIdx[], int16_t range[], uint8_t nof);
+  /*! reads a single device, returns 1 on success */
+  uint8_t (*readSingle)(uint8_t dev, int16_t *rangeP);
+  /*! re-addresses and re-initializes a single device, returns 1 on success */
+  uint8_t (*reInit)(uint8_t dev);
+} TOFH_Bus;
+
+/*!
+ * \brief Resets the state of all devices, e.g. after the bus has been power-cycled. The totals are kept.
+ * \param dev Device descriptors.
+ * \param nofDevices Number of devices.
+ */
+void TOFH_Reset(TOFH_Device dev[], uint8_t nofDevices);
+
+/*!
+ * \brief Reads the range of all devices. Healthy devices are measured together, devices with errors
+ * are read on their own and get re-initialized if they keep failing.
+ * \param dev Device descriptors.
+ * \param nofDevices Number of devices.
+ * \param bus Callbacks to access the devices.
+ * \return 1 if all devices are working or are still recovering, 0 if a bus reset is needed.
+ */
+uint8_t TOFH_Read(TOFH_Device dev[], uint8_t nofDevices, const TOFH_Bus *bus);
+
+#if TOFH_CONFIG_FAULT_INJECTION
+/*!
+ * \brief Simulates I2C faults: the next accesses of the device fail without using the bus.
+ * \param dev Device descriptor.
+ * \param nofFaults Number of failing accesses. E.g. 2: device recovers with retries, 4: device gets re-initialized, 6: bus reset.
+ */
+void TOFH_InjectFaults(TOFH_Device *dev, uint8_t nofFaults);
+#endif
+
+#endif /* TOFHEALTH_H_ */
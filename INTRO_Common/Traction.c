@@ -0,0 +1,241 @@
+/**
+ * \file
+ * \brief Traction estimator.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * For each wheel, a first order motor model predicts the speed out of the commanded effort.
+ * The measured speed is compared with the model:
+ * - much faster than the model: the wheel slips (spins freely)
+ * - much slower than the model on both wheels: the robot pushes against something
+ * - not turning at all with enough effort: the wheel stalls
+ * Additionally, the left/right encoder difference is compared with the difference of the models,
+ * to detect a single slipping wheel while the other one has grip.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TRACTION
+#include "Traction.h"
+#include "Motor.h"
+#include "Tacho.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
+#include "UTIL1.h"
+#if PL_CONFIG_HAS_EVENTS
+  #include "Event.h"
+#endif
+
+/*! \todo adopt the values for your robot */
+#define TRAC_SAMPLE_MS            5     /* period of TRAC_Update(), same as the drive task */
+#define TRAC_FULL_EFFORT_SPEED    4000  /* wheel speed in steps/sec with full effort and no load */
+#define TRAC_MODEL_SHIFT          3     /* time constant of the motor model, 2^3 samples */
+#define TRAC_MIN_MODEL_SPEED      200   /* below this model speed (steps/sec) the ratio is not used */
+#define TRAC_SLIP_PERCENT         150   /* wheel is faster than this percentage of the model: slip */
+#define TRAC_PUSH_PERCENT         50    /* wheel is slower than this percentage of the model: load */
+#define TRAC_STALL_EFFORT         0x4000 /* minimum effort to detect a stall */
+#define TRAC_STALL_SPEED          50    /* wheel is slower than this speed (steps/sec): stall */
+#define TRAC_DIFF_SHIFT           3     /* filter constant of the left/right difference error */
+#define TRAC_DIFF_SLIP_MSTEPS     40000 /* filtered left/right difference error (in 1/1000 steps) for slip */
+#define TRAC_DEBOUNCE_SAMPLES     10    /* number of samples a new state has to be present */
+
+typedef struct {
+  int32_t modelSpeed; /* speed predicted by the motor model, in steps/sec */
+  int32_t speed; /* measured speed, in steps/sec */
+  int32_t ratioPercent; /* measured speed in percent of the model speed */
+  TRAC_State state; /* state of the wheel in the last sample */
+} TRAC_Wheel;
+
+static TRAC_Wheel TRAC_left, TRAC_right;
+static Q4CLeft_QuadCntrType TRAC_lastLeft; /* encoder positions of last sample */
+static Q4CRight_QuadCntrType TRAC_lastRight;
+static int32_t TRAC_diffError; /* filtered left/right difference error, in 1/1000 steps */
+static TRAC_State TRAC_state = TRAC_STATE_GRIP; /* debounced state of the robot */
+static TRAC_State TRAC_candidate = TRAC_STATE_GRIP; /* new state, not debounced yet */
+static uint8_t TRAC_candidateCnt = 0; /* number of samples TRAC_candidate is present */
+
+TRAC_State TRAC_GetState(void) {
+  return TRAC_state;
+}
+
+static int32_t Abs(int32_t val) {
+  return val<0?-val:val;
+}
+
+static void UpdateWheel(TRAC_Wheel *wheel, MOT_MotorDevice *motor, int32_t speed) {
+  int32_t effort, target;
+
+  effort = MOT_GetEffort(motor);
+  if (MOT_GetDirection(motor)==MOT_DIR_BACKWARD) {
+    effort = -effort;
+  }
+  target = (effort*TRAC_FULL_EFFORT_SPEED)/0xffff; /* steady state speed for this effort */
+  wheel->modelSpeed += (target-wheel->modelSpeed)/(1<<TRAC_MODEL_SHIFT); /* first order lag */
+  wheel->speed = speed;
+  if (Abs(effort)>=TRAC_STALL_EFFORT && Abs(wheel->modelSpeed)>=TRAC_MIN_MODEL_SPEED && Abs(speed)<TRAC_STALL_SPEED) {
+    wheel->ratioPercent = 0;
+    wheel->state = TRAC_STATE_STALL;
+  } else if (Abs(wheel->modelSpeed)>=TRAC_MIN_MODEL_SPEED) {
+    wheel->ratioPercent = (speed*100)/wheel->modelSpeed; /* negative if turning against the effort */
+    if (wheel->ratioPercent>TRAC_SLIP_PERCENT) {
+      wheel->state = TRAC_STATE_SLIP;
+    } else if (wheel->ratioPercent<TRAC_PUSH_PERCENT) {
+      wheel->state = TRAC_STATE_PUSH;
+    } else {
+      wheel->state = TRAC_STATE_GRIP;
+    }
+  } else { /* not enough effort to tell */
+    wheel->ratioPercent = 100;
+    wheel->state = TRAC_STATE_GRIP;
+  }
+}
+
+static void UpdateDifference(void) {
+  Q4CLeft_QuadCntrType left;
+  Q4CRight_QuadCntrType right;
+  int32_t measured, expected;
+
+  left = Q4CLeft_GetPos();
+  right = Q4CRight_GetPos();
+  measured = ((int32_t)(left-TRAC_lastLeft)-(int32_t)(right-TRAC_lastRight))*1000; /* in 1/1000 steps */
+  TRAC_lastLeft = left;
+  TRAC_lastRight = right;
+  expected = (TRAC_left.modelSpeed-TRAC_right.modelSpeed)*TRAC_SAMPLE_MS; /* in 1/1000 steps */
+  TRAC_diffError += measured-expected-TRAC_diffError/(1<<TRAC_DIFF_SHIFT); /* leaky integration */
+  /* the wheel running ahead of the other one, compared with the models, is slipping if it is not slower than its model */
+  if (TRAC_diffError>TRAC_DIFF_SLIP_MSTEPS && TRAC_left.state==TRAC_STATE_GRIP && TRAC_left.ratioPercent>=100) {
+    TRAC_left.state = TRAC_STATE_SLIP;
+  } else if (TRAC_diffError<-TRAC_DIFF_SLIP_MSTEPS && TRAC_right.state==TRAC_STATE_GRIP && TRAC_right.ratioPercent>=100) {
+    TRAC_right.state = TRAC_STATE_SLIP;
+  }
+}
+
+static void SetState(TRAC_State state) {
+  TRAC_state = state;
+#if PL_CONFIG_HAS_EVENTS
+  switch(state) {
+    case TRAC_STATE_GRIP:  EVNT_SetEvent(EVNT_TRAC_GRIP); break;
+    case TRAC_STATE_SLIP:  EVNT_SetEvent(EVNT_TRAC_SLIP); break;
+    case TRAC_STATE_PUSH:  EVNT_SetEvent(EVNT_TRAC_PUSH); break;
+    case TRAC_STATE_STALL: EVNT_SetEvent(EVNT_TRAC_STALL); break;
+    default: break;
+  }
+#endif
+}
+
+static void Reset(void) {
+  TRAC_left.modelSpeed = TRAC_right.modelSpeed = 0;
+  TRAC_left.ratioPercent = TRAC_right.ratioPercent = 100;
+  TRAC_left.state = TRAC_right.state = TRAC_STATE_GRIP;
+  TRAC_lastLeft = Q4CLeft_GetPos();
+  TRAC_lastRight = Q4CRight_GetPos();
+  TRAC_diffError = 0;
+  TRAC_candidate = TRAC_STATE_GRIP;
+  TRAC_candidateCnt = 0;
+}
+
+TRAC_State TRAC_Update(bool active) {
+  TRAC_State candidate;
+
+  if (!active) {
+    Reset();
+    if (TRAC_state!=TRAC_STATE_GRIP) {
+      SetState(TRAC_STATE_GRIP);
+    }
+    return TRAC_state;
+  }
+  UpdateWheel(&TRAC_left, MOT_GetMotorHandle(MOT_MOTOR_LEFT), TACHO_GetSpeed(TRUE));
+  UpdateWheel(&TRAC_right, MOT_GetMotorHandle(MOT_MOTOR_RIGHT), TACHO_GetSpeed(FALSE));
+  UpdateDifference();
+  /* combine the wheels: stall and slip of one wheel count, push needs both wheels loaded */
+  if (TRAC_left.state==TRAC_STATE_STALL || TRAC_right.state==TRAC_STATE_STALL) {
+    candidate = TRAC_STATE_STALL;
+  } else if (TRAC_left.state==TRAC_STATE_SLIP || TRAC_right.state==TRAC_STATE_SLIP) {
+    candidate = TRAC_STATE_SLIP;
+  } else if (TRAC_left.state==TRAC_STATE_PUSH && TRAC_right.state==TRAC_STATE_PUSH) {
+    candidate = TRAC_STATE_PUSH;
+  } else {
+    candidate = TRAC_STATE_GRIP;
+  }
+  /* debounce */
+  if (candidate==TRAC_state) {
+    TRAC_candidateCnt = 0;
+  } else if (candidate==TRAC_candidate) {
+    TRAC_candidateCnt++;
+    if (TRAC_candidateCnt>=TRAC_DEBOUNCE_SAMPLES) {
+      TRAC_candidateCnt = 0;
+      SetState(candidate);
+    }
+  } else {
+    TRAC_candidate = candidate;
+    TRAC_candidateCnt = 1;
+  }
+  return TRAC_state;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static const unsigned char *StateStr(TRAC_State state) {
+  switch(state) {
+    case TRAC_STATE_GRIP:  return (const unsigned char*)"grip";
+    case TRAC_STATE_SLIP:  return (const unsigned char*)"slip";
+    case TRAC_STATE_PUSH:  return (const unsigned char*)"push";
+    case TRAC_STATE_STALL: return (const unsigned char*)"stall";
+    default:               return (const unsigned char*)"unknown";
+  }
+}
+
+static void PrintWheel(const unsigned char *label, TRAC_Wheel *wheel, const CLS1_StdIOType *io) {
+  unsigned char buf[64];
+
+  UTIL1_strcpy(buf, sizeof(buf), StateStr(wheel->state));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", speed ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), wheel->speed);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)", model ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), wheel->modelSpeed);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps/sec, ");
+  UTIL1_strcatNum32s(buf, sizeof(buf), wheel->ratioPercent);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"%\r\n");
+  CLS1_SendStatusStr(label, buf, io->stdOut);
+}
+
+static void TRAC_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"trac", (unsigned char*)"Group of traction estimator commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows traction help or status\r\n", io->stdOut);
+}
+
+static void TRAC_PrintStatus(const CLS1_StdIOType *io) {
+  unsigned char buf[32];
+
+  CLS1_SendStatusStr((unsigned char*)"trac", (unsigned char*)"\r\n", io->stdOut);
+  UTIL1_strcpy(buf, sizeof(buf), StateStr(TRAC_state));
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  state", buf, io->stdOut);
+  PrintWheel((unsigned char*)"  left", &TRAC_left, io);
+  PrintWheel((unsigned char*)"  right", &TRAC_right, io);
+  UTIL1_Num32sToStr(buf, sizeof(buf), TRAC_diffError/1000);
+  UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps\r\n");
+  CLS1_SendStatusStr((unsigned char*)"  diff error", buf, io->stdOut);
+}
+
+uint8_t TRAC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  if (UTIL1_strcmp((char*)cmd, CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, "trac help")==0) {
+    TRAC_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, "trac status")==0) {
+    TRAC_PrintStatus(io);
+    *handled = TRUE;
+  }
+  return ERR_OK;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void TRAC_Deinit(void) {
+}
+
+void TRAC_Init(void) {
+  TRAC_state = TRAC_STATE_GRIP;
+  Reset();
+}
+
+#endif /* PL_CONFIG_HAS_TRACTION */
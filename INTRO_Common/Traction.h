@@ -0,0 +1,57 @@
+/**
+ * \file
+ * \brief Interface to the traction estimator.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This module compares the commanded motor effort with the measured wheel speeds and the
+ * left/right encoder difference against a simple motor model, and detects if a wheel slips
+ * (spins freely), stalls, or if the robot is pushing against an obstacle.
+ */
+
+#ifndef TRACTION_H_
+#define TRACTION_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TRACTION
+
+typedef enum {
+  TRAC_STATE_GRIP,  /*!< wheels move as expected by the motor model */
+  TRAC_STATE_SLIP,  /*!< a wheel spins faster than expected, e.g. lifted or on a slippery surface */
+  TRAC_STATE_PUSH,  /*!< both wheels are slower than expected: robot has contact and pushes */
+  TRAC_STATE_STALL, /*!< a wheel does not turn despite of the effort */
+} TRAC_State;
+
+/*!
+ * \brief Returns the current traction state of the robot.
+ * \return Traction state.
+ */
+TRAC_State TRAC_GetState(void);
+
+/*!
+ * \brief Updates the estimator, called by the drive task after the motor efforts have been updated.
+ * \param active TRUE if the motors are closed loop controlled, FALSE otherwise (estimator is reset).
+ * \return New traction state.
+ */
+TRAC_State TRAC_Update(bool active);
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t TRAC_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void TRAC_Deinit(void);
+
+/*! \brief Initialization of the module */
+void TRAC_Init(void);
+
+#endif /* PL_CONFIG_HAS_TRACTION */
+
+#endif /* TRACTION_H_ */
@@ -10,6 +10,7 @@
 #if PL_CONFIG_HAS_TURN
 #include "Turn.h"
 #include "WAIT1.h"
+#include "FRTOS1.h"
 #include "Motor.h"
 #include "UTIL1.h"
 #if PL_CONFIG_HAS_SHELL
@@ -20,6 +21,9 @@
 #if PL_CONFIG_HAS_QUADRATURE
   #include "Q4CLeft.h"
   #include "Q4CRight.h"
+  #if PL_CONFIG_HAS_QUAD_FTM
+    #include "QuadFtm.h"
+  #endif
   #include "Pid.h"
 #endif
 #if PL_CONFIG_HAS_DRIVE
@@ -41,6 +45,14 @@
 #define TURN_STEPS_LINE_TIMEOUT_MS      200
 #define TURN_STEPS_POST_LINE_TIMEOUT_MS 200
 #define TURN_STEPS_STOP_TIMEOUT_MS      150
+#if PL_CONFIG_HAS_REFLECTANCE
+#define TURN_LINE_SPEED                 1500
+  /*!< rotation speed (steps/sec) for the coarse part of a line referenced turn */
+#define TURN_LINE_CAPTURE_SPEED         600
+  /*!< rotation speed (steps/sec) while searching the line */
+#define TURN_LINE_CENTER_TOLERANCE      300
+  /*!< allowed deviation from REF_MIDDLE_LINE_VALUE to consider the line as centered */
+#endif
 
 static int32_t TURN_Steps90 = TURN_STEPS_90;
 static int32_t TURN_StepsLine = TURN_STEPS_LINE;
@@ -71,29 +83,50 @@ const unsigned char *TURN_TurnKindStr(TURN_Kind kind) {
   }
 }
 
+void TURN_SetSteps(int32_t steps90, int32_t stepsLine, int32_t stepsPostLine) {
+  TURN_Steps90 = steps90;
+  TURN_StepsLine = stepsLine;
+  TURN_StepsPostLine = stepsPostLine;
+}
+
+void TURN_GetSteps(int32_t *steps90, int32_t *stepsLine, int32_t *stepsPostLine) {
+  *steps90 = TURN_Steps90;
+  *stepsLine = TURN_StepsLine;
+  *stepsPostLine = TURN_StepsPostLine;
+}
+
 void TURN_MoveToPos(int32_t targetLPos, int32_t targetRPos, bool wait, TURN_StopFct stopIt, int32_t timeoutMs) {
+  uint8_t res;
+
   (void)DRV_SetPos(targetLPos, targetRPos);
   (void)DRV_SetMode(DRV_MODE_POS);
-  for(;;) { /* breaks */
-    if (stopIt!=NULL) {
+  if (!wait) {
+    return;
+  }
+  if (DRV_WaitRegister(DRV_WAIT_TARGET_REACHED)!=ERR_OK) {
+    return; /* too many waiting tasks */
+  }
+  if (stopIt==NULL) {
+    res = DRV_WaitCompletion(timeoutMs); /* notified by the drive task as soon as the position is reached */
+  } else {
+    for(;;) { /* breaks */
       if (stopIt()) { /* check stop condition */
+        res = ERR_OK;
         break;
       }
-    }
-    WAIT1_WaitOSms(1); /* wait some time, and give Drive module enough time to use new value */
-    timeoutMs--;
-    if (timeoutMs<=0) {
-      break; /* timeout */
-    }
-    if (wait && DRV_HasTurned()) {
-      break;
-    }
-    if (!wait) {
-      break;
-    }
-  } /* for */
+      res = DRV_WaitCompletion(1); /* wait one ms for the position, then check stop condition again */
+      if (res==ERR_OK) {
+        break; /* position reached */
+      }
+      timeoutMs--;
+      if (timeoutMs<=0) {
+        break; /* timeout */
+      }
+    } /* for */
+  }
+  DRV_WaitUnregister();
 #if PL_CONFIG_HAS_SHELL
-  if (timeoutMs<=0) {
+  if (res!=ERR_OK) {
     SHELL_SendString((unsigned char*)"MoveToPos Timeout.\r\n");
   }
 #endif
@@ -101,21 +134,17 @@ void TURN_MoveToPos(int32_t targetLPos, int32_t targetRPos, bool wait, TURN_Stop
 
 static void StepsTurn(int32_t stepsL, int32_t stepsR, TURN_StopFct stopIt, int32_t timeOutMS) {
   int32_t currLPos, currRPos, targetLPos, targetRPos;
+  uint8_t res;
+
   /* stop before turn */
-  int timeout = TURN_STEPS_STOP_TIMEOUT_MS;
-  
   DRV_SetMode(DRV_MODE_STOP); /* stop it */
-  WAIT1_WaitOSms(5);
-
-  while (timeout>0 && !DRV_IsStopped()) {
-    /* wait until stopped */
-    timeout-=5;
-    WAIT1_WaitOSms(5);
-  }
+  res = DRV_WaitFor(DRV_WAIT_STOPPED, TURN_STEPS_STOP_TIMEOUT_MS); /* notified by the drive task as soon as stopped */
 #if PL_CONFIG_HAS_SHELL
-  if (timeout<=0) {
+  if (res!=ERR_OK) {
     SHELL_SendString((unsigned char*)"StepsTurn Stopping Timeout.\r\n");
   }
+#else
+  (void)res;
 #endif
   currLPos = Q4CLeft_GetPos();
   currRPos = Q4CRight_GetPos();
@@ -196,11 +225,82 @@ void TURN_TurnAngle(int16_t angle, TURN_StopFct stopIt) {
   }
 }
 
+#if PL_CONFIG_HAS_REFLECTANCE
+uint8_t TURN_TurnToLine(TURN_Kind kind, TURN_StopFct stopIt) {
+  int32_t steps, window, travel, speed, timeoutMs;
+  int32_t startLPos, startRPos;
+  uint16_t lineVal;
+  bool isLeft;
+  uint8_t res;
+
+  switch(kind) {
+    case TURN_LEFT90:   isLeft = TRUE;  steps = TURN_Steps90; break;
+    case TURN_RIGHT90:  isLeft = FALSE; steps = TURN_Steps90; break;
+    case TURN_LEFT180:  isLeft = TRUE;  steps = 2*TURN_Steps90; break;
+    case TURN_RIGHT180: isLeft = FALSE; steps = 2*TURN_Steps90; break;
+    default:
+      TURN_Turn(kind, stopIt); /* not a turn onto a line */
+      return ERR_OK;
+  }
+  window = TURN_Steps90/4; /* the line is searched +/- 22.5 degree around the nominal angle */
+  timeoutMs = ((steps/TURN_Steps90)+1)*TURN_STEPS_90_TIMEOUT_MS;
+  startLPos = Q4CLeft_GetPos();
+  startRPos = Q4CRight_GetPos();
+  speed = TURN_LINE_SPEED;
+  (void)DRV_SetMode(DRV_MODE_SPEED); /* no stop before the turn */
+  for(;;) { /* breaks */
+    if (stopIt!=NULL && stopIt()) { /* check stop condition */
+      res = ERR_OK;
+      break;
+    }
+    travel = (Q4CRight_GetPos()-startRPos)-(Q4CLeft_GetPos()-startLPos);
+    if (!isLeft) {
+      travel = -travel;
+    }
+    travel /= 2; /* average rotation of both wheels */
+    if (travel>=steps+window || timeoutMs<=0) {
+      res = ERR_FAILED; /* did not find the line */
+      break;
+    }
+    if (travel>=steps-window) { /* close to the target: slow down and use the line as reference */
+      speed = TURN_LINE_CAPTURE_SPEED;
+      lineVal = REF_GetLineValue();
+      if (REF_GetLineKind()==REF_LINE_STRAIGHT
+          && lineVal>=REF_MIDDLE_LINE_VALUE-TURN_LINE_CENTER_TOLERANCE
+          && lineVal<=REF_MIDDLE_LINE_VALUE+TURN_LINE_CENTER_TOLERANCE)
+      {
+        res = ERR_OK; /* line is centered under the middle sensors */
+        break;
+      }
+    }
+    if (isLeft) {
+      (void)DRV_SetSpeed(-speed, speed);
+    } else {
+      (void)DRV_SetSpeed(speed, -speed);
+    }
+    FRTOS1_vTaskDelay(1/portTICK_PERIOD_MS);
+    timeoutMs--;
+  } /* for */
+  if (res==ERR_OK) {
+    (void)DRV_SetMode(DRV_MODE_NONE); /* keep the motors running, the line following takes over */
+  } else {
+    (void)DRV_SetMode(DRV_MODE_STOP);
+#if PL_CONFIG_HAS_SHELL
+    SHELL_SendString((unsigned char*)"TurnToLine: no line found.\r\n");
+#endif
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_REFLECTANCE */
+
 #if PL_CONFIG_HAS_SHELL
 static void TURN_PrintHelp(const CLS1_StdIOType *io) {
   CLS1_SendHelpStr((unsigned char*)"turn", (unsigned char*)"Group of turning commands\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows turn help or status\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  <angle>", (unsigned char*)"Turn the robot by angle, negative is counter-clockwise, e.g. 'turn -90'\r\n", io->stdOut);
+#if PL_CONFIG_HAS_REFLECTANCE
+  CLS1_SendHelpStr((unsigned char*)"  line <angle>", (unsigned char*)"Turn by -90, 90, -180 or 180 degree and stop on the line\r\n", io->stdOut);
+#endif
   CLS1_SendHelpStr((unsigned char*)"  forward", (unsigned char*)"Move one step forward\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  forward postline", (unsigned char*)"Move one step forward post the line\r\n", io->stdOut);
   CLS1_SendHelpStr((unsigned char*)"  backward", (unsigned char*)"Move one step backward\r\n", io->stdOut);
@@ -270,6 +370,28 @@ uint8_t TURN_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_St
       CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
       res = ERR_FAILED;
     }
+#if PL_CONFIG_HAS_REFLECTANCE
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"turn line ", sizeof("turn line ")-1)==0) {
+    int32_t angle;
+
+    p = cmd+sizeof("turn line ")-1;
+    if (UTIL1_xatoi(&p, &angle)==ERR_OK && (angle==-90 || angle==90 || angle==-180 || angle==180)) {
+      if (angle==-90) {
+        res = TURN_TurnToLine(TURN_LEFT90, NULL);
+      } else if (angle==90) {
+        res = TURN_TurnToLine(TURN_RIGHT90, NULL);
+      } else if (angle==-180) {
+        res = TURN_TurnToLine(TURN_LEFT180, NULL);
+      } else {
+        res = TURN_TurnToLine(TURN_RIGHT180, NULL);
+      }
+      TURN_Turn(TURN_STOP, NULL);
+      *handled = TRUE;
+    } else {
+      CLS1_SendStr((unsigned char*)"Wrong argument\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+#endif
   } else if (UTIL1_strcmp((char*)cmd, (char*)"turn forward postline")==0) {
     TURN_Turn(TURN_STEP_LINE_FW_POST_LINE, NULL);
     TURN_Turn(TURN_STOP, NULL);
@@ -42,6 +42,22 @@ typedef bool (*TURN_StopFct)(void);
  */
 const unsigned char *TURN_TurnKindStr(TURN_Kind kind);
 
+/*!
+ * \brief Sets the number of steps used for the turns, e.g. from a calibration.
+ * \param steps90 Steps of each wheel for a 90 degree turn on the spot.
+ * \param stepsLine Steps for stepping over the line.
+ * \param stepsPostLine Steps after the line, before making a turn.
+ */
+void TURN_SetSteps(int32_t steps90, int32_t stepsLine, int32_t stepsPostLine);
+
+/*!
+ * \brief Returns the number of steps used for the turns.
+ * \param steps90 Where to store the steps for a 90 degree turn.
+ * \param stepsLine Where to store the steps for stepping over the line.
+ * \param stepsPostLine Where to store the steps after the line.
+ */
+void TURN_GetSteps(int32_t *steps90, int32_t *stepsLine, int32_t *stepsPostLine);
+
 /*!
  * \brief Turns the robot.
  * \param kind How much the robot has to turn.
@@ -64,6 +80,18 @@ void TURN_MoveToPos(int32_t targetLPos, int32_t targetRPos, bool wait, TURN_Stop
  */
 void TURN_TurnAngle(int16_t angle, TURN_StopFct stopIt);
 
+#if PL_CONFIG_HAS_REFLECTANCE
+/*!
+ * \brief Turns the robot onto a line: the coarse rotation is done with the encoders, then the robot
+ * turns slowly until the line is centered under the middle sensors. The motors are not stopped at the
+ * end (drive mode is DRV_MODE_NONE), so line following with PID_Line() can continue without a stop.
+ * \param kind TURN_LEFT90, TURN_RIGHT90, TURN_LEFT180 or TURN_RIGHT180. Other kinds are passed to TURN_Turn().
+ * \param stopIt Callback to stop turning, or NULL.
+ * \return ERR_OK if the line has been found, ERR_FAILED otherwise (robot is stopped).
+ */
+uint8_t TURN_TurnToLine(TURN_Kind kind, TURN_StopFct stopIt);
+#endif
+
 #if PL_CONFIG_HAS_SHELL
 #include "CLS1.h"
 /*!
@@ -0,0 +1,343 @@
+/**
+ * \file
+ * \brief Turn and wheel geometry calibration.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This is the implementation of the turn calibration module.
+ * For the turn, the robot spins on the spot on a line (or a cross) and records the wheel steps each time the line
+ * is centered under the sensors: the line comes back every 180 degree (90 degree for a cross).
+ * For the distance, the robot drives straight over parallel lines with a known spacing and records the steps at each line.
+ * A least squares line through the recorded steps gives the steps per 90 degree or the distance per step, and the
+ * deviation of the measurements from it is reported as residual. The wheel base follows from both values.
+ */
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TURN_CALIBRATION
+#include "TurnCalib.h"
+#include "Turn.h"
+#include "Drive.h"
+#include "Reflectance.h"
+#include "NVM_Config.h"
+#include "IntMath.h"
+#include "Q4CLeft.h"
+#include "Q4CRight.h"
+#if PL_CONFIG_HAS_QUAD_FTM
+  #include "QuadFtm.h"
+#endif
+#include "Odometry.h" /* default geometry, used without odometry too */
+#include "WAIT1.h"
+#include "UTIL1.h"
+#include <stddef.h> /* offsetof() */
+#if PL_CONFIG_HAS_SHELL
+  #include "CLS1.h"
+#endif
+
+#define TCAL_SPIN_SPEED           400    /* speed of the wheels while spinning, steps/sec */
+#define TCAL_STRAIGHT_SPEED       400    /* speed while driving over the lines, steps/sec */
+#define TCAL_CENTER_TOLERANCE     500    /* line value tolerance around REF_MIDDLE_LINE_VALUE for a centered line */
+#define TCAL_MAX_CROSSINGS        16     /* maximum number of line crossings recorded */
+#define TCAL_SPIN_TURNS           2      /* number of full turns for the spin calibration */
+#define TCAL_SPIN_TIMEOUT_MS      20000  /* timeout for the spin calibration */
+#define TCAL_SAMPLE_MS            2      /* sampling period of the line sensor */
+#define TCAL_DEFAULT_NM_PER_STEP  (ODO_UM_PER_STEP*1000) /* distance per step if not calibrated */
+#define TCAL_LINE_UM              10000  /* distance to step over the line (TURN_STEPS_LINE at the default distance per step) */
+#define TCAL_POST_LINE_UM         5000   /* distance after the line before a turn (TURN_STEPS_POST_LINE at the default distance per step) */
+#define TCAL_PI_MILLI             3142   /* pi*1000 */
+#define TCAL_NVM_VERSION          1      /* increment if the content of TCAL_Data changes */
+
+typedef struct {
+  uint16_t version; /* TCAL_NVM_VERSION */
+  uint16_t size; /* sizeof(TCAL_Data), detects layout changes */
+  int32_t steps90; /* steps of each wheel for a 90 degree turn on the spot */
+  int32_t nmPerStep; /* driven distance for one step */
+  int32_t wheelBaseUm; /* distance between the wheels */
+  uint16_t checksum; /* Fletcher-16 of all bytes before */
+} TCAL_Data; /* data stored in NVM */
+
+typedef bool (*TCAL_OnLineFct)(void);
+
+static TCAL_Data TCAL_data; /* data from NVM or from the last calibration */
+static bool TCAL_isValid = FALSE; /* if TCAL_data contains a calibration */
+static int32_t TCAL_spinResidual = -1; /* residual of the last spin calibration in 0.1 degree, -1 if none */
+static int32_t TCAL_straightResidual = -1; /* residual of the last straight calibration in 0.1 mm, -1 if none */
+
+static void Apply(void) {
+  int32_t stepsLine, stepsPostLine;
+
+  if (!TCAL_isValid) {
+    return; /* keep the defaults */
+  }
+  stepsLine = (TCAL_LINE_UM*1000)/TCAL_data.nmPerStep;
+  stepsPostLine = (TCAL_POST_LINE_UM*1000)/TCAL_data.nmPerStep;
+  TURN_SetSteps(TCAL_data.steps90, stepsLine, stepsPostLine);
+#if PL_CONFIG_HAS_ODOMETRY
+  ODO_SetGeometry(TCAL_data.nmPerStep, TCAL_data.steps90);
+#endif
+}
+
+static int32_t WheelBaseUm(int32_t steps90, int32_t nmPerStep) {
+  /* on the spot, each wheel drives a quarter circle with half the wheel base as radius for 90 degree */
+  return (int32_t)((4LL*steps90*nmPerStep)/TCAL_PI_MILLI);
+}
+
+static void UpdateWheelBase(void) {
+  TCAL_data.wheelBaseUm = WheelBaseUm(TCAL_data.steps90, TCAL_data.nmPerStep);
+}
+
+#if PL_CONFIG_HAS_SHELL
+static uint8_t SaveData(void) {
+  TCAL_data.version = TCAL_NVM_VERSION;
+  TCAL_data.size = sizeof(TCAL_Data);
+  TCAL_data.checksum = NVMC_Checksum(&TCAL_data, offsetof(TCAL_Data, checksum));
+  return NVMC_SaveTurnCalData(&TCAL_data, sizeof(TCAL_data));
+}
+#endif
+
+static uint8_t LoadData(void) {
+  TCAL_Data *ptr;
+
+  ptr = (TCAL_Data*)NVMC_GetTurnCalData();
+  if (ptr==NULL) {
+    return ERR_FAILED; /* nothing stored */
+  }
+  if (ptr->version!=TCAL_NVM_VERSION || ptr->size!=sizeof(TCAL_Data)) {
+    return ERR_FAILED; /* stored with a different firmware */
+  }
+  if (ptr->checksum!=NVMC_Checksum(ptr, offsetof(TCAL_Data, checksum))) {
+    return ERR_CRC;
+  }
+  if (ptr->steps90<=0 || ptr->nmPerStep<=0 || ptr->wheelBaseUm!=WheelBaseUm(ptr->steps90, ptr->nmPerStep)) {
+    return ERR_RANGE; /* not a calibration */
+  }
+  TCAL_data = *ptr; /* struct copy */
+  return ERR_OK;
+}
+
+#if PL_CONFIG_HAS_SHELL
+static bool IsLineCentered(void) {
+  uint16_t val;
+
+  val = REF_GetLineValue();
+  return REF_GetLineKind()==REF_LINE_STRAIGHT
+      && val>=REF_MIDDLE_LINE_VALUE-TCAL_CENTER_TOLERANCE
+      && val<=REF_MIDDLE_LINE_VALUE+TCAL_CENTER_TOLERANCE;
+}
+
+static bool IsLineAcross(void) {
+  return REF_GetLineKind()==REF_LINE_FULL;
+}
+
+/*!
+ * \brief Moves the robot and records the steps in the middle of each line crossing.
+ * \param spin TRUE to spin counter-clockwise on the spot (rotation steps), FALSE to drive forward (driven steps).
+ * \param onLine Function returning TRUE while the line is detected.
+ * \param pos Where to store the steps of each crossing.
+ * \param nofPos Number of crossings to record.
+ * \param timeoutMs Timeout in milliseconds.
+ * \return ERR_OK if all crossings have been recorded, ERR_FAILED for a timeout.
+ */
+static uint8_t Measure(bool spin, TCAL_OnLineFct onLine, int32_t *pos, uint8_t nofPos, int32_t timeoutMs) {
+  int32_t startL, startR, dl, dr, travel, enterPos = 0;
+  bool inside, entered = FALSE, on;
+  uint8_t n = 0, res = ERR_FAILED;
+
+  startL = Q4CLeft_GetPos();
+  startR = Q4CRight_GetPos();
+  inside = onLine(); /* starting on the line: wait until it is left, as the start is unknown */
+  if (spin) {
+    (void)DRV_SetSpeed(-TCAL_SPIN_SPEED, TCAL_SPIN_SPEED);
+  } else {
+    (void)DRV_SetSpeed(TCAL_STRAIGHT_SPEED, TCAL_STRAIGHT_SPEED);
+  }
+  (void)DRV_SetMode(DRV_MODE_SPEED);
+  while (timeoutMs>0) {
+    dl = (int32_t)Q4CLeft_GetPos()-startL;
+    dr = (int32_t)Q4CRight_GetPos()-startR;
+    travel = spin?(dr-dl)/2:(dr+dl)/2;
+    on = onLine();
+    if (!inside && on) {
+      inside = TRUE;
+      entered = TRUE;
+      enterPos = travel;
+    } else if (inside && !on) {
+      inside = FALSE;
+      if (entered) { /* middle of the crossing: independent of the sensor threshold */
+        pos[n] = (enterPos+travel)/2;
+        n++;
+        if (n==nofPos) {
+          res = ERR_OK;
+          break;
+        }
+      }
+    }
+    WAIT1_WaitOSms(TCAL_SAMPLE_MS);
+    timeoutMs -= TCAL_SAMPLE_MS;
+  }
+  (void)DRV_Stop(1000);
+  return res;
+}
+
+static void SendTenths(unsigned char *name, int32_t val, const unsigned char *unit, const CLS1_StdIOType *io) {
+  uint8_t buf[32];
+
+  if (val<0) {
+    UTIL1_strcpy(buf, sizeof(buf), (unsigned char*)"n/a\r\n");
+  } else {
+    UTIL1_Num32sToStr(buf, sizeof(buf), val/10);
+    UTIL1_chcat(buf, sizeof(buf), '.');
+    UTIL1_strcatNum32s(buf, sizeof(buf), val%10);
+    UTIL1_strcat(buf, sizeof(buf), unit);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)"\r\n");
+  }
+  CLS1_SendStatusStr(name, buf, io->stdOut);
+}
+
+static uint8_t CalibrateSpin(bool isCross, const CLS1_StdIOType *io) {
+  int32_t pos[TCAL_MAX_CROSSINGS];
+  int32_t slopeQ8, residualQ8, degrees;
+  uint8_t nofPos;
+
+  if (!REF_IsReady()) {
+    CLS1_SendStr((unsigned char*)"**** reflectance sensor not calibrated\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  degrees = isCross?90:180; /* rotation between two line crossings */
+  nofPos = (uint8_t)((TCAL_SPIN_TURNS*360)/degrees+1);
+  CLS1_SendStr((unsigned char*)"Spinning on the line...\r\n", io->stdOut);
+  if (Measure(TRUE, IsLineCentered, pos, nofPos, TCAL_SPIN_TIMEOUT_MS)!=ERR_OK) {
+    CLS1_SendStr((unsigned char*)"**** not all line crossings detected\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  if (!IMATH_FitLine(pos, nofPos, &slopeQ8, &residualQ8)) {
+    CLS1_SendStr((unsigned char*)"**** robot has not turned\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  if (!TCAL_isValid) {
+    TCAL_data.nmPerStep = TCAL_DEFAULT_NM_PER_STEP;
+  }
+  TCAL_data.steps90 = ((slopeQ8*90)/degrees+128)>>8;
+  UpdateWheelBase();
+  TCAL_isValid = TRUE;
+  TCAL_spinResidual = (residualQ8*degrees*10)/slopeQ8;
+  Apply();
+  CLS1_SendStatusStr((unsigned char*)"steps 90", (unsigned char*)"", io->stdOut);
+  CLS1_SendNum32s(TCAL_data.steps90, io->stdOut);
+  CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+  SendTenths((unsigned char*)"residual", TCAL_spinResidual, (unsigned char*)" deg", io);
+  return ERR_OK;
+}
+
+static uint8_t CalibrateStraight(int32_t mm, uint8_t nofLines, const CLS1_StdIOType *io) {
+  int32_t pos[TCAL_MAX_CROSSINGS];
+  int32_t slopeQ8, residualQ8, timeoutMs;
+
+  if (!REF_IsReady()) {
+    CLS1_SendStr((unsigned char*)"**** reflectance sensor not calibrated\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  /* twice the expected time with the default distance per step */
+  timeoutMs = (int32_t)((2000LL*nofLines*mm*1000000/TCAL_DEFAULT_NM_PER_STEP)/TCAL_STRAIGHT_SPEED);
+  CLS1_SendStr((unsigned char*)"Driving over the lines...\r\n", io->stdOut);
+  if (Measure(FALSE, IsLineAcross, pos, nofLines, timeoutMs)!=ERR_OK) {
+    CLS1_SendStr((unsigned char*)"**** not all lines detected\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  if (!IMATH_FitLine(pos, nofLines, &slopeQ8, &residualQ8)) {
+    CLS1_SendStr((unsigned char*)"**** robot has not moved\r\n", io->stdErr);
+    return ERR_FAILED;
+  }
+  if (!TCAL_isValid) {
+    int32_t stepsLine, stepsPostLine;
+
+    TURN_GetSteps(&TCAL_data.steps90, &stepsLine, &stepsPostLine);
+  }
+  TCAL_data.nmPerStep = (int32_t)(((int64_t)mm*1000000*256)/slopeQ8);
+  UpdateWheelBase();
+  TCAL_isValid = TRUE;
+  TCAL_straightResidual = (residualQ8*mm*10)/slopeQ8;
+  Apply();
+  CLS1_SendStatusStr((unsigned char*)"nm/step", (unsigned char*)"", io->stdOut);
+  CLS1_SendNum32s(TCAL_data.nmPerStep, io->stdOut);
+  CLS1_SendStr((unsigned char*)"\r\n", io->stdOut);
+  SendTenths((unsigned char*)"residual", TCAL_straightResidual, (unsigned char*)" mm", io);
+  return ERR_OK;
+}
+
+static void TCAL_PrintHelp(const CLS1_StdIOType *io) {
+  CLS1_SendHelpStr((unsigned char*)"tcal", (unsigned char*)"Group of turn calibration commands\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  help|status", (unsigned char*)"Shows turn calibration help or status\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  spin line|cross", (unsigned char*)"Spins two turns centered on a line or a cross and measures the steps for 90 degree\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  straight <mm> <n>", (unsigned char*)"Drives over n (2..16) parallel lines <mm> apart and measures the distance per step\r\n", io->stdOut);
+  CLS1_SendHelpStr((unsigned char*)"  save", (unsigned char*)"Saves the calibration to FLASH\r\n", io->stdOut);
+}
+
+static void TCAL_PrintStatus(const CLS1_StdIOType *io) {
+  uint8_t buf[32];
+
+  CLS1_SendStatusStr((unsigned char*)"tcal", (unsigned char*)"\r\n", io->stdOut);
+  CLS1_SendStatusStr((unsigned char*)"  calibrated", TCAL_isValid?(unsigned char*)"yes\r\n":(unsigned char*)"no\r\n", io->stdOut);
+  if (TCAL_isValid) {
+    UTIL1_Num32sToStr(buf, sizeof(buf), TCAL_data.steps90);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" steps\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  90 deg", buf, io->stdOut);
+    UTIL1_Num32sToStr(buf, sizeof(buf), TCAL_data.nmPerStep);
+    UTIL1_strcat(buf, sizeof(buf), (unsigned char*)" nm/step\r\n");
+    CLS1_SendStatusStr((unsigned char*)"  distance", buf, io->stdOut);
+    SendTenths((unsigned char*)"  wheel base", TCAL_data.wheelBaseUm/100, (unsigned char*)" mm", io);
+  }
+  SendTenths((unsigned char*)"  spin res", TCAL_spinResidual, (unsigned char*)" deg", io);
+  SendTenths((unsigned char*)"  straight res", TCAL_straightResidual, (unsigned char*)" mm", io);
+}
+
+uint8_t TCAL_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io) {
+  uint8_t res = ERR_OK;
+  const unsigned char *p;
+  int32_t mm, nofLines;
+
+  if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_HELP)==0 || UTIL1_strcmp((char*)cmd, (char*)"tcal help")==0) {
+    TCAL_PrintHelp(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)CLS1_CMD_STATUS)==0 || UTIL1_strcmp((char*)cmd, (char*)"tcal status")==0) {
+    TCAL_PrintStatus(io);
+    *handled = TRUE;
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"tcal spin line")==0) {
+    *handled = TRUE;
+    res = CalibrateSpin(FALSE, io);
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"tcal spin cross")==0) {
+    *handled = TRUE;
+    res = CalibrateSpin(TRUE, io);
+  } else if (UTIL1_strncmp((char*)cmd, (char*)"tcal straight ", sizeof("tcal straight ")-1)==0) {
+    *handled = TRUE;
+    p = cmd+sizeof("tcal straight ")-1;
+    if (UTIL1_xatoi(&p, &mm)==ERR_OK && mm>0 && UTIL1_xatoi(&p, &nofLines)==ERR_OK && nofLines>=2 && nofLines<=TCAL_MAX_CROSSINGS) {
+      res = CalibrateStraight(mm, (uint8_t)nofLines, io);
+    } else {
+      CLS1_SendStr((unsigned char*)"**** wrong arguments, e.g. 'tcal straight 200 3'\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  } else if (UTIL1_strcmp((char*)cmd, (char*)"tcal save")==0) {
+    *handled = TRUE;
+    if (!TCAL_isValid) {
+      CLS1_SendStr((unsigned char*)"**** not calibrated, use 'tcal spin' or 'tcal straight' first\r\n", io->stdErr);
+      res = ERR_FAILED;
+    } else if (SaveData()!=ERR_OK) {
+      CLS1_SendStr((unsigned char*)"**** failed saving to FLASH\r\n", io->stdErr);
+      res = ERR_FAILED;
+    }
+  }
+  return res;
+}
+#endif /* PL_CONFIG_HAS_SHELL */
+
+void TCAL_Deinit(void) {
+  /* nothing needed */
+}
+
+void TCAL_Init(void) {
+  TCAL_isValid = LoadData()==ERR_OK;
+  TCAL_spinResidual = -1;
+  TCAL_straightResidual = -1;
+  Apply();
+}
+
+#endif /* PL_CONFIG_HAS_TURN_CALIBRATION */
@@ -0,0 +1,37 @@
+/**
+ * \file
+ * \brief Turn and wheel geometry calibration.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * This is the interface to the turn calibration module: it measures the steps for a 90 degree turn
+ * and the driven distance per step with the help of lines on the floor, instead of hand-tuning them.
+ */
+
+#ifndef TURNCALIB_H_
+#define TURNCALIB_H_
+
+#include "Platform.h"
+#if PL_CONFIG_HAS_TURN_CALIBRATION
+
+#if PL_CONFIG_HAS_SHELL
+#include "CLS1.h"
+
+/*!
+ * \brief Parses a command
+ * \param cmd Command string to be parsed
+ * \param handled Sets this variable to TRUE if command was handled
+ * \param io I/O stream to be used for input/output
+ * \return Error code, ERR_OK if everything was fine
+ */
+uint8_t TCAL_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
+#endif
+
+/*! \brief De-initialization of the module */
+void TCAL_Deinit(void);
+
+/*! \brief Initialization of the module, loads the calibration from NVM */
+void TCAL_Init(void);
+
+#endif /* PL_CONFIG_HAS_TURN_CALIBRATION */
+
+#endif /* TURNCALIB_H_ */
@@ -0,0 +1,32 @@
+/**
+ * \file
+ * \brief Minimal check macros for the host checks.
+ * \author Erich Styger, erich.styger@hslu.ch
+ */
+
+#ifndef HOSTTEST_H_
+#define HOSTTEST_H_
+
+#include <stdio.h>
+
+static int HT_nofFailed = 0;
+
+/* prints the failed condition and continues, so one run reports all failures */
+#define HT_CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      printf("**** %s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      HT_nofFailed++; \
+    } \
+  } while(0)
+
+static int HT_Result(const char *name) {
+  if (HT_nofFailed!=0) {
+    printf("**** %s: %d check(s) failed\n", name, HT_nofFailed);
+    return 1;
+  }
+  printf("%s: OK\n", name);
+  return 0;
+}
+
+#endif /* HOSTTEST_H_ */
@@ -0,0 +1,144 @@
+/**
+ * \file
+ * \brief Host check of the integer math helpers.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Compares the integer square roots with the definition (r*r<=val<(r+1)*(r+1)) for small values, around the
+ * squares and at the range limits, checks the absolute value, and compares the line fit with a floating point
+ * least squares fit. Build and run with 'make check'.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "IntMath.h"
+#include "HostTest.h"
+
+/* r has to be the rounded down square root of val */
+static int IsSqrt(uint64_t val, uint64_t r) {
+  return r*r<=val && (r+1)*(r+1)>val;
+}
+
+/* least squares fit in floating point, as reference for IMATH_FitLine() */
+static void FitLine(const int32_t *pos, int n, double *slope, double *residual) {
+  double sk = 0, skk = 0, sp = 0, skp = 0, intercept, dev, sum = 0;
+  int i;
+
+  for(i=0;i<n;i++) {
+    sk += i;
+    skk += (double)i*i;
+    sp += pos[i];
+    skp += (double)i*pos[i];
+  }
+  *slope = (n*skp-sk*sp)/(n*skk-sk*sk);
+  intercept = (sp-*slope*sk)/n;
+  for(i=0;i<n;i++) {
+    dev = pos[i]-(intercept+*slope*i);
+    sum += dev*dev;
+  }
+  *residual = sqrt(sum/n);
+}
+
+/* fits the line like a calibration does, returns the largest deviation from the reference in steps */
+static double FitError(const int32_t *pos, uint8_t n) {
+  int32_t slopeQ8, residualQ8;
+  double slope, residual, errSlope, errRes;
+
+  if (!IMATH_FitLine(pos, n, &slopeQ8, &residualQ8)) {
+    return 1e9;
+  }
+  FitLine(pos, n, &slope, &residual);
+  errSlope = fabs(slopeQ8/256.0-slope);
+  errRes = fabs(residualQ8/256.0-residual);
+  return errSlope>errRes?errSlope:errRes;
+}
+
+int main(void) {
+  int32_t i, v, pos[16], slopeQ8, residualQ8;
+  uint64_t u, r;
+  int k, n, ok32 = 1, ok64 = 1;
+  double err, maxErr = 0;
+
+  /* 32bit: all small values, and each square with its neighbors */
+  for(i=0;i<100000;i++) {
+    if (!IsSqrt((uint64_t)i, (uint64_t)IMATH_Sqrt32(i))) {
+      ok32 = 0;
+    }
+  }
+  for(i=1;i<=46340;i++) { /* 46340^2 is the largest square below 2^31 */
+    v = i*i;
+    if (IMATH_Sqrt32(v)!=i || IMATH_Sqrt32(v-1)!=i-1 || (i<46340 && IMATH_Sqrt32(v+1)!=i)) {
+      ok32 = 0;
+    }
+  }
+  HT_CHECK(ok32);
+  HT_CHECK(IMATH_Sqrt32(INT32_MAX)==46340);
+  HT_CHECK(IMATH_Sqrt32(0)==0);
+  HT_CHECK(IMATH_Sqrt32(-1)==0);
+  HT_CHECK(IMATH_Sqrt32(INT32_MIN)==0);
+
+  /* 64bit: values spread over the whole range, and each square of a power of two with its neighbors */
+  for(u=1;u<(UINT64_MAX/3);u=u*3+1) {
+    if (!IsSqrt(u, IMATH_Sqrt64(u)) || !IsSqrt(u-1, IMATH_Sqrt64(u-1))) {
+      ok64 = 0;
+    }
+  }
+  for(i=0;i<32;i++) {
+    r = 1ULL<<i;
+    if (IMATH_Sqrt64(r*r)!=r || IMATH_Sqrt64(r*r-1)!=r-1 || IMATH_Sqrt64(r*r+1)!=r) {
+      ok64 = 0;
+    }
+  }
+  HT_CHECK(ok64);
+  HT_CHECK(IMATH_Sqrt64(0)==0);
+  HT_CHECK(IMATH_Sqrt64(UINT64_MAX)==UINT32_MAX);
+  HT_CHECK(IMATH_Sqrt64((uint64_t)INT32_MAX)==(uint32_t)IMATH_Sqrt32(INT32_MAX));
+
+  HT_CHECK(IMATH_Abs32(0)==0);
+  HT_CHECK(IMATH_Abs32(-5)==5);
+  HT_CHECK(IMATH_Abs32(5)==5);
+  HT_CHECK(IMATH_Abs32(-INT32_MAX)==INT32_MAX);
+  printf("square roots checked up to 2^64\n");
+
+  /* exact line: slope is exact, no residual */
+  for(i=0;i<5;i++) {
+    pos[i] = 100+1400*i; /* spin: 1400 steps per 180 degree */
+  }
+  HT_CHECK(IMATH_FitLine(pos, 5, &slopeQ8, &residualQ8));
+  HT_CHECK(slopeQ8==1400*256 && residualQ8==0);
+  HT_CHECK(IMATH_FitLine(pos, 5, &slopeQ8, NULL) && slopeQ8==1400*256); /* residual is optional */
+  /* measurements alternating +/-10 steps around the line */
+  for(i=0;i<16;i++) {
+    pos[i] = 2000*i+((i&1)?10:-10);
+  }
+  HT_CHECK(IMATH_FitLine(pos, 16, &slopeQ8, &residualQ8));
+  HT_CHECK(FitError(pos, 16)<0.05);
+  HT_CHECK(residualQ8>9*256 && residualQ8<=10*256);
+  /* noisy measurements at large encoder positions, against the floating point fit */
+  srand(1);
+  for(k=0;k<1000;k++) {
+    n = 2+k%15;
+    for(i=0;i<n;i++) {
+      pos[i] = 2000000000-100000+(k%500+1)*10*i+(rand()%41-20);
+    }
+    err = FitError(pos, (uint8_t)n);
+    if (err>maxErr) {
+      maxErr = err;
+    }
+  }
+  printf("line fit: max deviation from the floating point fit %.3f steps\n", maxErr);
+  HT_CHECK(maxErr<0.05);
+  /* unusable measurements */
+  HT_CHECK(!IMATH_FitLine(pos, 0, &slopeQ8, &residualQ8));
+  HT_CHECK(!IMATH_FitLine(pos, 1, &slopeQ8, &residualQ8));
+  for(i=0;i<4;i++) {
+    pos[i] = 500; /* has not moved */
+  }
+  HT_CHECK(!IMATH_FitLine(pos, 4, &slopeQ8, &residualQ8));
+  for(i=0;i<4;i++) {
+    pos[i] = 500-100*i; /* moved backwards */
+  }
+  HT_CHECK(!IMATH_FitLine(pos, 4, &slopeQ8, &residualQ8));
+  return HT_Result("IntMathTest");
+}
@@ -0,0 +1,99 @@
+/**
+ * \file
+ * \brief Host check of the motor linearization against a motor model.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Sweeps the PWM duty of a motor model with deadband and nonlinear response like 'motcal run' does, builds the
+ * table with MotorLin.c and checks that the speed is proportional to the effort with the table applied.
+ * Build and run with 'make check'.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "MotorLin.h"
+#include "HostTest.h"
+
+/* motor model. \todo adopt to your motors */
+#define MODEL_MAX_SPEED  3000   /* steps/sec at full PWM */
+#define MODEL_DEADBAND   0x3000 /* no movement below this duty */
+#define MODEL_EXPONENT   0.6    /* speed rises faster than the duty after the deadband */
+
+static int32_t ModelSpeed(uint16_t duty, int32_t maxSpeed) {
+  if (duty<=MODEL_DEADBAND) {
+    return 0;
+  }
+  return (int32_t)(maxSpeed*pow((double)(duty-MODEL_DEADBAND)/(0xffff-MODEL_DEADBAND), MODEL_EXPONENT));
+}
+
+static void Sweep(uint16_t duty[MLIN_NOF_POINTS], int32_t speed[MLIN_NOF_POINTS], int32_t maxSpeed) {
+  int i;
+
+  for(i=0;i<MLIN_NOF_POINTS;i++) {
+    duty[i] = (uint16_t)((i*0xffffUL)/(MLIN_NOF_POINTS-1)); /* same points as the sweep on the robot */
+    speed[i] = ModelSpeed(duty[i], maxSpeed);
+  }
+}
+
+/* largest deviation from a speed proportional to the effort, in percent of the maximum speed */
+static double MaxLinError(const uint16_t table[MLIN_NOF_POINTS], int32_t maxSpeed) {
+  uint32_t effort;
+  double err, maxErr = 0;
+
+  for(effort=0x1000;effort<=0xffff;effort+=0x80) { /* first segment starts at the end of the deadband */
+    err = fabs(ModelSpeed(MLIN_Duty(table, (uint16_t)effort), maxSpeed)-(double)maxSpeed*effort/0xffff);
+    if (err>maxErr) {
+      maxErr = err;
+    }
+  }
+  return (maxErr*100)/maxSpeed;
+}
+
+int main(void) {
+  uint16_t duty[MLIN_NOF_POINTS], table[MLIN_NOF_POINTS];
+  int32_t speed[MLIN_NOF_POINTS];
+  double linErr, rawErr;
+  int i, monotonic;
+
+  Sweep(duty, speed, MODEL_MAX_SPEED);
+  HT_CHECK(MLIN_BuildTable(duty, speed, table));
+  monotonic = 1;
+  for(i=1;i<MLIN_NOF_POINTS;i++) {
+    if (table[i]<table[i-1]) {
+      monotonic = 0;
+    }
+  }
+  HT_CHECK(monotonic);
+  HT_CHECK(table[0]>=MODEL_DEADBAND-0x1000 && table[0]<=MODEL_DEADBAND); /* starts at the end of the deadband */
+  HT_CHECK(table[MLIN_NOF_POINTS-1]==0xffff);
+  HT_CHECK(MLIN_Duty(table, 0)==0);
+  HT_CHECK(MLIN_Duty(table, 0xffff)==0xffff);
+  linErr = MaxLinError(table, MODEL_MAX_SPEED);
+  for(i=0;i<MLIN_NOF_POINTS;i++) { /* identity table: no linearization */
+    duty[i] = (uint16_t)((i*0xffffUL)/(MLIN_NOF_POINTS-1));
+  }
+  rawErr = MaxLinError(duty, MODEL_MAX_SPEED);
+  printf("linearity error: %.1f%% with table, %.1f%% without\n", linErr, rawErr);
+  HT_CHECK(linErr<5.0);
+  HT_CHECK(linErr<rawErr/4);
+
+  /* backward sweep (negative speeds) and a noisy, not monotonic measurement */
+  Sweep(duty, speed, MODEL_MAX_SPEED);
+  for(i=0;i<MLIN_NOF_POINTS;i++) {
+    speed[i] = -speed[i];
+  }
+  speed[10] = speed[9]/2; /* glitch */
+  HT_CHECK(MLIN_BuildTable(duty, speed, table));
+  monotonic = 1;
+  for(i=1;i<MLIN_NOF_POINTS;i++) {
+    if (table[i]<table[i-1]) {
+      monotonic = 0;
+    }
+  }
+  HT_CHECK(monotonic);
+
+  /* motor not moving */
+  Sweep(duty, speed, MLIN_MIN_SPEED-1);
+  HT_CHECK(!MLIN_BuildTable(duty, speed, table));
+  return HT_Result("MotorLinTest");
+}
@@ -0,0 +1,185 @@
+/**
+ * \file
+ * \brief Host simulation of the opponent tracker with scripted opponent motion.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Moves the robot and the opponent in a world frame, simulates the four ToF sensors with their narrow cones and runs
+ * the tracker of OppTrack.c with the simulated ranges and robot motion, like the opponent task does every 10 ms.
+ * Checks that the estimate follows the opponent while it is outside of the sensor cones and that a lost opponent
+ * gets dropped. Build and run with 'make check'.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "OppTrack.h"
+#include "HostTest.h"
+
+#define SIM_PERIOD_MS      10    /* same as the opponent task */
+#define SIM_CONE_DEG       12.5  /* half opening angle of a ToF sensor cone */
+#define SIM_SENSOR_MM      40    /* distance of the sensors from the robot center */
+#define SIM_MAX_RANGE_MM   500   /* ToF sensor range */
+#define SIM_PI             3.14159265358979
+#define SIM_CONE_ERR(mm)   ((mm)*tan(SIM_CONE_DEG*SIM_PI/180)+20) /* position error of a measurement at the cone edge */
+
+typedef struct {
+  double x, y, theta; /* robot pose in the world, in mm and rad */
+  double ox, oy; /* opponent position in the world, in mm */
+  double dist, rot; /* driven distance (mm) and rotation (rad) since start */
+  int32_t lastDistMm, lastRotMrad; /* last values passed to the tracker */
+  OPPT_Tracker tracker;
+  uint8_t seen; /* opponent is in one of the sensor cones */
+  double maxErr; /* largest position error while tracking, in mm */
+} Sim;
+
+/* opponent position in the robot frame */
+static void Relative(const Sim *sim, double *rx, double *ry) {
+  double dx = sim->ox-sim->x, dy = sim->oy-sim->y;
+
+  *rx = cos(sim->theta)*dx+sin(sim->theta)*dy;
+  *ry = -sin(sim->theta)*dx+cos(sim->theta)*dy;
+}
+
+static void Init(Sim *sim, double ox, double oy) {
+  sim->x = sim->y = sim->theta = 0;
+  sim->ox = ox;
+  sim->oy = oy;
+  sim->dist = sim->rot = 0;
+  sim->lastDistMm = sim->lastRotMrad = 0;
+  sim->maxErr = 0;
+  OPPT_Init(&sim->tracker);
+}
+
+/* simulates the sensors and runs the tracker for one period */
+static void Step(Sim *sim, double speedMmS, double rotRadS, double oppVx, double oppVy) {
+  static const double sensorDir[OPPT_NOF_SENSORS] = {0, SIM_PI, SIM_PI/2, -SIM_PI/2}; /* front, rear, left, right */
+  int16_t range[OPPT_NOF_SENSORS];
+  double dt = SIM_PERIOD_MS/1000.0, rx, ry, along, across, err;
+  int32_t distMm, rotMrad;
+  int i;
+
+  /* move robot and opponent */
+  sim->theta += rotRadS*dt;
+  sim->x += cos(sim->theta)*speedMmS*dt;
+  sim->y += sin(sim->theta)*speedMmS*dt;
+  sim->dist += speedMmS*dt;
+  sim->rot += rotRadS*dt;
+  sim->ox += oppVx*dt;
+  sim->oy += oppVy*dt;
+  /* motion in the integer units of the odometry, difference of the absolute values like in the opponent task */
+  distMm = (int32_t)floor(sim->dist);
+  rotMrad = (int32_t)floor(sim->rot*1000);
+  OPPT_Predict(&sim->tracker, distMm-sim->lastDistMm, rotMrad-sim->lastRotMrad, SIM_PERIOD_MS);
+  sim->lastDistMm = distMm;
+  sim->lastRotMrad = rotMrad;
+  /* ToF sensors: see the opponent if it is within the cone and range */
+  Relative(sim, &rx, &ry);
+  sim->seen = 0;
+  for(i=0;i<OPPT_NOF_SENSORS;i++) {
+    along = cos(sensorDir[i])*rx+sin(sensorDir[i])*ry;
+    across = -sin(sensorDir[i])*rx+cos(sensorDir[i])*ry;
+    range[i] = -1;
+    if (along>SIM_SENSOR_MM && fabs(atan2(across, along))<=SIM_CONE_DEG*SIM_PI/180 && along-SIM_SENSOR_MM<=SIM_MAX_RANGE_MM) {
+      range[i] = (int16_t)(along-SIM_SENSOR_MM);
+      sim->seen = 1;
+    }
+  }
+  OPPT_Update(&sim->tracker, range);
+  if (sim->tracker.valid) {
+    err = hypot(sim->tracker.x-rx, sim->tracker.y-ry);
+    if (err>sim->maxErr) {
+      sim->maxErr = err;
+    }
+  }
+}
+
+/* difference between the tracked and the real bearing */
+static double BearingError(const Sim *sim) {
+  int16_t bearing, range;
+  double rx, ry, diff;
+
+  if (!OPPT_GetTarget(&sim->tracker, &bearing, &range)) {
+    return 360;
+  }
+  Relative(sim, &rx, &ry);
+  diff = bearing-atan2(ry, rx)*180/SIM_PI;
+  while (diff>180) {
+    diff -= 360;
+  }
+  while (diff<-180) {
+    diff += 360;
+  }
+  return fabs(diff);
+}
+
+int main(void) {
+  Sim sim;
+  int i, validAll, lostAfter, nofSeen, seenOk;
+  int16_t bearing, range;
+
+  /* opponent ahead, robot turns 90 degree to the left on the spot: the opponent leaves the front cone
+   * and shows up in the right sensor 0.4 seconds later */
+  Init(&sim, 300, 0);
+  Step(&sim, 0, 0, 0, 0);
+  HT_CHECK(sim.tracker.valid && BearingError(&sim)<2);
+  validAll = 1;
+  for(i=0;i<52;i++) { /* 3 rad/s */
+    Step(&sim, 0, 3.0, 0, 0);
+    validAll &= sim.tracker.valid;
+  }
+  for(i=0;i<20;i++) {
+    Step(&sim, 0, 0, 0, 0);
+    validAll &= sim.tracker.valid;
+  }
+  printf("turn: bearing error %.1f deg, max position error %.0f mm\n", BearingError(&sim), sim.maxErr);
+  HT_CHECK(validAll);
+  HT_CHECK(sim.maxErr<SIM_CONE_ERR(340)); /* sensors measure along their axis only */
+  HT_CHECK(BearingError(&sim)<5);
+  HT_CHECK(OPPT_GetTarget(&sim.tracker, &bearing, &range) && bearing<-80 && bearing>-100);
+
+  /* robot drives towards the opponent */
+  Init(&sim, 450, 0);
+  for(i=0;i<80;i++) { /* 400 mm/s */
+    Step(&sim, 400, 0, 0, 0);
+  }
+  printf("approach: max position error %.0f mm\n", sim.maxErr);
+  HT_CHECK(sim.tracker.valid && sim.maxErr<30);
+  HT_CHECK(OPPT_GetTarget(&sim.tracker, &bearing, &range) && range>110 && range<150);
+
+  /* opponent drives around the robot: the track gets lost between the cones, as the opponent could be
+   * anywhere after a while, and has to be picked up again by each sensor */
+  Init(&sim, 290, 0);
+  nofSeen = 0;
+  seenOk = 1;
+  for(i=0;i<1300;i++) { /* 0.5 rad/s, 145 mm/s, a bit more than one turn */
+    double a = atan2(sim.oy, sim.ox)+0.5*SIM_PERIOD_MS/1000.0;
+    Step(&sim, 0, 0, (290*cos(a)-sim.ox)*1000/SIM_PERIOD_MS, (290*sin(a)-sim.oy)*1000/SIM_PERIOD_MS);
+    if (sim.seen) {
+      nofSeen++;
+      seenOk &= sim.tracker.valid && BearingError(&sim)<SIM_CONE_DEG+2;
+    }
+  }
+  printf("circling opponent: seen %d ms, max position error %.0f mm\n", nofSeen*SIM_PERIOD_MS, sim.maxErr);
+  HT_CHECK(seenOk);
+  HT_CHECK(nofSeen>=(int)(4*2*SIM_CONE_DEG*SIM_PI/180/0.5*1000/SIM_PERIOD_MS)-8); /* seen in each of the 4 cones */
+  HT_CHECK(sim.maxErr<SIM_CONE_ERR(330)+145*0.75); /* opponent moves on until the track is dropped after about 0.75 s */
+
+  /* opponent leaves the front cone sideways and stays out of sight: the track gets dropped */
+  Init(&sim, 300, 0);
+  lostAfter = -1;
+  for(i=0;i<200 && lostAfter<0;i++) {
+    Step(&sim, 0, 0, 0, 300);
+    if (!sim.tracker.valid) {
+      lostAfter = i*SIM_PERIOD_MS;
+    }
+  }
+  printf("opponent escapes: track dropped after %d ms\n", lostAfter);
+  HT_CHECK(lostAfter>500 && lostAfter<1500);
+  HT_CHECK(!OPPT_GetTarget(&sim.tracker, &bearing, &range));
+
+  /* new opponent: starts a new track with the closest object */
+  Init(&sim, -200, 0);
+  Step(&sim, 0, 0, 0, 0);
+  HT_CHECK(OPPT_GetTarget(&sim.tracker, &bearing, &range) && (bearing>=178 || bearing<=-178) && range==200);
+  return HT_Result("OppTrackTest");
+}
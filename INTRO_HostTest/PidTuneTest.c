@@ -0,0 +1,216 @@
+/**
+ * \file
+ * \brief Host check of the PID auto-tuning against a plant model.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Runs the relay experiment of PidTune.c on a model of the wheel (motor with first order lag and measurement
+ * delay), compares the measured ultimate gain and period with the ones found by a sweep of a P controller on the
+ * same model, and checks that the computed gains give a stable, settling step response. Build and run with 'make check'.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "PidTune.h"
+#include "HostTest.h"
+
+/* wheel model, sampled with the period of the drive task. \todo adopt to your robot */
+#define PLANT_TS_MS       5     /* control period */
+#define PLANT_TAU_MS      60    /* motor time constant */
+#define PLANT_MAX_SPEED   3000  /* speed (steps/sec) at full effort */
+#define PLANT_DELAY       2     /* samples between effort and measured speed */
+
+typedef struct {
+  double speed; /* steps/sec */
+  double pos; /* steps */
+  int32_t effort[PLANT_DELAY+1]; /* delay line */
+} Plant;
+
+static void PlantInit(Plant *p) {
+  int i;
+
+  p->speed = 0;
+  p->pos = 0;
+  for(i=0;i<=PLANT_DELAY;i++) {
+    p->effort[i] = 0;
+  }
+}
+
+static void PlantStep(Plant *p, int32_t effort) {
+  int i;
+
+  if (effort>0xffff) {
+    effort = 0xffff;
+  } else if (effort<-0xffff) {
+    effort = -0xffff;
+  }
+  for(i=PLANT_DELAY;i>0;i--) {
+    p->effort[i] = p->effort[i-1];
+  }
+  p->effort[0] = effort;
+  p->speed += ((double)p->effort[PLANT_DELAY]*PLANT_MAX_SPEED/0xffff-p->speed)*PLANT_TS_MS/PLANT_TAU_MS;
+  p->pos += p->speed*PLANT_TS_MS/1000.0;
+}
+
+/* same integer PID as in Pid.c */
+typedef struct {
+  PIDT_Gains gains;
+  int32_t iAntiWindup;
+  int32_t lastError, integral;
+} Pid;
+
+static int32_t PidStep(Pid *pid, int32_t currVal, int32_t setVal) {
+  int32_t error, out;
+
+  error = setVal-currVal;
+  out = (error*pid->gains.pFactor100)/100;
+  pid->integral += error;
+  if (pid->integral>pid->iAntiWindup) {
+    pid->integral = pid->iAntiWindup;
+  } else if (pid->integral<-pid->iAntiWindup) {
+    pid->integral = -pid->iAntiWindup;
+  }
+  out += (pid->integral*pid->gains.iFactor100)/100;
+  out += ((error-pid->lastError)*pid->gains.dFactor100)/100;
+  pid->lastError = error;
+  return out;
+}
+
+/* runs the relay experiment on the speed (or position) of the model */
+static PIDT_RelayState RunRelay(PIDT_Relay *relay, int isPos, int32_t setVal, int32_t amplitude, int32_t hysteresis, int32_t bias) {
+  Plant plant;
+  PIDT_RelayState state;
+  int32_t out, i;
+
+  PlantInit(&plant);
+  for(i=0;i<200;i++) { /* settle at the bias, like the robot does before the experiment */
+    PlantStep(&plant, bias);
+  }
+  PIDT_RelayStart(relay, amplitude, hysteresis, bias);
+  if (isPos) {
+    setVal += (int32_t)plant.pos;
+  }
+  for(;;) {
+    state = PIDT_RelayStep(relay, setVal-(int32_t)(isPos?plant.pos:plant.speed), &out);
+    if (state!=PIDT_RELAY_RUNNING) {
+      return state;
+    }
+    PlantStep(&plant, out);
+  }
+}
+
+/* ultimate gain (effort per step/sec) of a P controller on the speed model, found by bisection */
+static double UltimateGain(double *periodSamples) {
+  double lo = 1, hi = 1000, k = 0;
+  int iter, i, lastCross, nofCross;
+  Plant plant;
+  double e, lastE, peakFirst, peakLast;
+
+  for(iter=0;iter<40;iter++) {
+    k = (lo+hi)/2;
+    PlantInit(&plant);
+    plant.speed = 10; /* small initial disturbance, so the effort stays within its range */
+    lastE = -10;
+    lastCross = -1;
+    nofCross = 0;
+    peakFirst = peakLast = 0;
+    *periodSamples = 0;
+    for(i=0;i<4000;i++) {
+      e = -plant.speed;
+      PlantStep(&plant, (int32_t)(k*e));
+      if (i>=500 && i<1000 && (e<0?-e:e)>peakFirst) {
+        peakFirst = e<0?-e:e;
+      }
+      if (i>=3000 && (e<0?-e:e)>peakLast) {
+        peakLast = e<0?-e:e;
+      }
+      if (lastE<0 && e>=0) { /* upward zero crossing */
+        if (lastCross>=0) {
+          *periodSamples = i-lastCross;
+        }
+        lastCross = i;
+        nofCross++;
+      }
+      lastE = e;
+    }
+    if (peakLast>peakFirst || peakLast>100) {
+      hi = k; /* oscillation grows, or has reached the effort limit */
+    } else {
+      lo = k;
+    }
+  }
+  return k;
+}
+
+/* step response of the speed loop with the given gains */
+static void SpeedStep(const PIDT_Gains *gains, double *overshoot, int *settleSamples, double *lastError) {
+  Plant plant;
+  Pid pid;
+  int i;
+  double maxSpeed = 0, err;
+
+  PlantInit(&plant);
+  pid.gains = *gains;
+  pid.iAntiWindup = 65000;
+  pid.lastError = pid.integral = 0;
+  *settleSamples = -1;
+  *lastError = 0;
+  for(i=0;i<1000;i++) {
+    PlantStep(&plant, PidStep(&pid, (int32_t)plant.speed, 1000));
+    if (plant.speed>maxSpeed) {
+      maxSpeed = plant.speed;
+    }
+    err = plant.speed-1000;
+    if (err<0) {
+      err = -err;
+    }
+    if (err>50) {
+      *settleSamples = -1;
+    } else if (*settleSamples<0) {
+      *settleSamples = i;
+    }
+    if (err>*lastError && i>=800) {
+      *lastError = err;
+    }
+  }
+  *overshoot = (maxSpeed-1000)/1000;
+}
+
+int main(void) {
+  PIDT_Relay relay;
+  PIDT_Gains gains;
+  double ku, tu, kuRelay, overshoot, lastError;
+  int settle;
+
+  /* speed loop: same amplitude as 'pid tune speed L' */
+  HT_CHECK(RunRelay(&relay, 0, 1000, 0x3000, 2, 1000*0xffff/PLANT_MAX_SPEED)==PIDT_RELAY_DONE); /* small hysteresis, the model has no noise */
+  ku = UltimateGain(&tu);
+  kuRelay = (4.0*relay.amplitude)/(3.14159*relay.oscAmplitude);
+  printf("speed: relay Ku %.2f Tu %d, model Ku %.2f Tu %.0f (samples)\n", kuRelay, (int)relay.oscPeriod, ku, tu);
+  HT_CHECK(kuRelay>0.7*ku && kuRelay<1.3*ku); /* describing function is an approximation */
+  HT_CHECK(relay.oscPeriod>0.8*tu && relay.oscPeriod<1.2*tu);
+  HT_CHECK(PIDT_CalcGains(relay.amplitude, relay.oscAmplitude, relay.oscPeriod, 1, 1, &gains));
+  printf("speed: p %d i %d d %d\n", (int)gains.pFactor100, (int)gains.iFactor100, (int)gains.dFactor100);
+  SpeedStep(&gains, &overshoot, &settle, &lastError);
+  printf("speed step: overshoot %.0f%%, settled after %d ms, remaining error %.1f steps/sec\n", overshoot*100, settle*PLANT_TS_MS, lastError);
+  HT_CHECK(overshoot<0.6);
+  HT_CHECK(settle>=0 && settle*PLANT_TS_MS<1000);
+  HT_CHECK(lastError<=50);
+  /* with the hysteresis used on the robot the relay sees a lower gain, the gains have to be stable too */
+  HT_CHECK(RunRelay(&relay, 0, 1000, 0x3000, 50, 1000*0xffff/PLANT_MAX_SPEED)==PIDT_RELAY_DONE);
+  HT_CHECK(PIDT_CalcGains(relay.amplitude, relay.oscAmplitude, relay.oscPeriod, 1, 1, &gains));
+  SpeedStep(&gains, &overshoot, &settle, &lastError);
+  HT_CHECK(overshoot<0.6);
+  HT_CHECK(settle>=0 && settle*PLANT_TS_MS<1000);
+
+  /* position loop: PD, PID value is scaled by 1000 */
+  HT_CHECK(RunRelay(&relay, 1, 0, 0x2000, 2, 0)==PIDT_RELAY_DONE);
+  HT_CHECK(PIDT_CalcGains(relay.amplitude, relay.oscAmplitude, relay.oscPeriod, 1000, 0, &gains));
+  HT_CHECK(gains.iFactor100==0);
+
+  /* unusable results */
+  HT_CHECK(!PIDT_CalcGains(0x3000, 0, 20, 1, 1, &gains));
+  HT_CHECK(!PIDT_CalcGains(0x3000, 100, 2, 1, 1, &gains));
+  HT_CHECK(RunRelay(&relay, 0, 1000000, 0x100, 50, 0)==PIDT_RELAY_FAILED); /* set value out of reach */
+  return HT_Result("PidTuneTest");
+}
@@ -0,0 +1,81 @@
+/**
+ * \file
+ * \brief Host check of the software extension of the FTM quadrature counters.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Moves the simulated 16bit hardware counters of QuadFtm.c and checks that the 32bit positions follow them over
+ * the wrap around of the counter, backwards, with swapped phases and after setting the position.
+ * Build and run with 'make check'.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "QuadFtm.h"
+#include "HostTest.h"
+
+/* moves the counter in chunks, with an update (timer interrupt) after each chunk */
+static void Move(QFTM_Channel ch, int32_t steps, int32_t chunk) {
+  while (steps!=0) {
+    if (steps>chunk) {
+      QFTM_MockMove(ch, chunk);
+      steps -= chunk;
+    } else if (steps<-chunk) {
+      QFTM_MockMove(ch, -chunk);
+      steps += chunk;
+    } else {
+      QFTM_MockMove(ch, steps);
+      steps = 0;
+    }
+    QFTM_OnInterrupt();
+  }
+}
+
+int main(void) {
+  QFTM_Init();
+  HT_CHECK(QFTM_GetPos(QFTM_LEFT)==0 && QFTM_GetPos(QFTM_RIGHT)==0);
+
+  /* forward over the 16bit wrap around, the other channel does not move */
+  Move(QFTM_LEFT, 70000, 1000);
+  HT_CHECK(QFTM_GetPos(QFTM_LEFT)==70000);
+  HT_CHECK(QFTM_GetPos(QFTM_RIGHT)==0);
+  /* backwards below zero */
+  Move(QFTM_LEFT, -150000, 1000);
+  HT_CHECK(QFTM_GetPos(QFTM_LEFT)==-80000);
+
+  /* largest move between two reads, without any interrupt */
+  QFTM_MockMove(QFTM_RIGHT, 32767);
+  HT_CHECK(QFTM_GetPos(QFTM_RIGHT)==32767);
+  QFTM_MockMove(QFTM_RIGHT, -32767);
+  HT_CHECK(QFTM_GetPos(QFTM_RIGHT)==0);
+  /* reading in the interrupt keeps the count, even if the task reads it much later */
+  Move(QFTM_RIGHT, 200000, 30000);
+  HT_CHECK(QFTM_GetPos(QFTM_RIGHT)==200000);
+
+  /* setting the position does not count the hardware steps so far */
+  QFTM_MockMove(QFTM_RIGHT, 123);
+  HT_CHECK(QFTM_SetPos(QFTM_RIGHT, 5)==ERR_OK);
+  HT_CHECK(QFTM_GetPos(QFTM_RIGHT)==5);
+  Move(QFTM_RIGHT, 10, 1000);
+  HT_CHECK(QFTM_GetPos(QFTM_RIGHT)==15);
+
+  /* swapped phases count in the other direction, the steps before the swap are kept */
+  HT_CHECK(QFTM_SetPos(QFTM_LEFT, 0)==ERR_OK);
+  QFTM_MockMove(QFTM_LEFT, 100);
+  HT_CHECK(QFTM_SwapPins(QFTM_LEFT, true)==ERR_OK);
+  Move(QFTM_LEFT, 70000, 1000);
+  HT_CHECK(QFTM_GetPos(QFTM_LEFT)==100-70000);
+  HT_CHECK(QFTM_SwapPins(QFTM_LEFT, false)==ERR_OK);
+  Move(QFTM_LEFT, 50, 1000);
+  HT_CHECK(QFTM_GetPos(QFTM_LEFT)==100-70000+50);
+
+  /* large 32bit totals */
+  HT_CHECK(QFTM_SetPos(QFTM_RIGHT, 0x7fff0000)==ERR_OK);
+  Move(QFTM_RIGHT, 0x8000, 1000);
+  HT_CHECK(QFTM_GetPos(QFTM_RIGHT)==0x7fff8000);
+
+  HT_CHECK(QFTM_SetPos(QFTM_NOF_CHANNELS, 0)==ERR_FAILED);
+  HT_CHECK(QFTM_GetPos(QFTM_NOF_CHANNELS)==0);
+  HT_CHECK(QFTM_NofErrors(QFTM_LEFT)==0 && QFTM_NofErrors(QFTM_RIGHT)==0);
+  QFTM_Deinit();
+  return HT_Result("QuadFtmTest");
+}
@@ -0,0 +1,168 @@
+/**
+ * \file
+ * \brief Host check of the ToF sensor error handling with injected I2C faults.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Runs the ToF read cycle of ToFHealth.c on a simulated bus with four devices, injects consecutive I2C faults like
+ * 'dist tof fault' does and breaks devices on the bus, and checks the device state transitions and the recovery.
+ * Build and run with 'make check'.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "ToFHealth.h"
+#include "HostTest.h"
+
+#define NOF_DEVICES  4
+
+/* simulated bus */
+static uint8_t busBroken[NOF_DEVICES]; /* device does not answer until it gets re-initialized */
+static uint8_t busReInitFixes; /* re-initialization repairs a broken device */
+static uint8_t busLastNofMultiple; /* number of devices in the last combined measurement */
+static int busNofReInit; /* number of re-initializations on the bus */
+
+static int16_t Range(uint8_t dev) {
+  return (int16_t)(10*(dev+1)); /* each device sees its own distance */
+}
+
+static uint8_t BusReadMultiple(const uint8_t devIdx[], int16_t range[], uint8_t nof) {
+  uint8_t i;
+
+  busLastNofMultiple = nof;
+  for(i=0;i<nof;i++) {
+    if (busBroken[devIdx[i]]) {
+      return 0; /* the failing device blocks the whole transfer */
+    }
+    range[i] = Range(devIdx[i]);
+  }
+  return 1;
+}
+
+static uint8_t BusReadSingle(uint8_t dev, int16_t *rangeP) {
+  if (busBroken[dev]) {
+    return 0;
+  }
+  *rangeP = Range(dev);
+  return 1;
+}
+
+static uint8_t BusReInit(uint8_t dev) {
+  busNofReInit++;
+  if (busReInitFixes) {
+    busBroken[dev] = 0;
+  }
+  return !busBroken[dev];
+}
+
+static const TOFH_Bus bus = {
+  .readMultiple = BusReadMultiple,
+  .readSingle = BusReadSingle,
+  .reInit = BusReInit,
+};
+
+static TOFH_Device dev[NOF_DEVICES];
+
+static void Restart(void) {
+  int i;
+
+  TOFH_Reset(dev, NOF_DEVICES);
+  for(i=0;i<NOF_DEVICES;i++) {
+    dev[i].nofErrors = dev[i].nofReinit = 0;
+    busBroken[i] = 0;
+  }
+  busReInitFixes = 0;
+  busNofReInit = 0;
+}
+
+/* the other devices keep on measuring */
+static int OthersOk(uint8_t failing) {
+  uint8_t i;
+
+  for(i=0;i<NOF_DEVICES;i++) {
+    if (i!=failing && (dev[i].state!=TOFH_STATE_OK || dev[i].mm!=Range(i))) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(void) {
+  uint8_t ok;
+
+  /* all devices healthy */
+  Restart();
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(OthersOk(NOF_DEVICES) && busLastNofMultiple==NOF_DEVICES);
+
+  /* 2 faults: device recovers with retries */
+  Restart();
+  TOFH_InjectFaults(&dev[1], 2);
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[1].state==TOFH_STATE_RETRY && dev[1].mm==TOFH_RANGE_DEVICE_ERROR && dev[1].errCntr==1);
+  HT_CHECK(OthersOk(1));
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[1].state==TOFH_STATE_RETRY && dev[1].errCntr==2);
+  HT_CHECK(busLastNofMultiple==NOF_DEVICES-1); /* retrying device is not in the combined measurement */
+  HT_CHECK(OthersOk(1));
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[1].state==TOFH_STATE_OK && dev[1].mm==Range(1) && dev[1].errCntr==0);
+  HT_CHECK(dev[1].nofErrors==2 && dev[1].nofReinit==0 && dev[1].nofInjectedFaults==0);
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(busLastNofMultiple==NOF_DEVICES);
+
+  /* 4 faults: device gets re-initialized, the first re-initialization fails */
+  Restart();
+  TOFH_InjectFaults(&dev[2], 4);
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[2].state==TOFH_STATE_RETRY);
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus)); /* 3rd read error and failing re-initialization */
+  HT_CHECK(dev[2].state==TOFH_STATE_REINIT && dev[2].reinitCntr==1 && dev[2].nofReinit==1 && busNofReInit==0);
+  HT_CHECK(OthersOk(2));
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[2].state==TOFH_STATE_OK && dev[2].reinitCntr==0 && dev[2].nofReinit==2 && busNofReInit==1);
+  HT_CHECK(dev[2].nofErrors==3);
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[2].mm==Range(2));
+
+  /* 6 faults: re-initialization keeps failing, the bus needs a reset */
+  Restart();
+  TOFH_InjectFaults(&dev[0], 6);
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[0].state==TOFH_STATE_REINIT && dev[0].reinitCntr==2);
+  HT_CHECK(!TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[0].state==TOFH_STATE_FAILED && dev[0].nofReinit==TOFH_MAX_DEVICE_REINIT);
+  HT_CHECK(OthersOk(0));
+  HT_CHECK(!TOFH_Read(dev, NOF_DEVICES, &bus)); /* stays failed until the bus reset */
+  TOFH_Reset(dev, NOF_DEVICES); /* bus reset: power cycle clears the state, but keeps the totals */
+  HT_CHECK(dev[0].state==TOFH_STATE_OK && dev[0].nofInjectedFaults==0 && dev[0].nofErrors==3);
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(OthersOk(NOF_DEVICES));
+
+  /* device hangs on the bus and blocks the combined measurement, re-initialization repairs it */
+  Restart();
+  busBroken[3] = 1;
+  busReInitFixes = 1;
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[3].state==TOFH_STATE_RETRY && OthersOk(3)); /* the others are read on their own */
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(dev[3].state==TOFH_STATE_OK && busNofReInit==1 && dev[3].nofReinit==1);
+  HT_CHECK(TOFH_Read(dev, NOF_DEVICES, &bus));
+  HT_CHECK(OthersOk(NOF_DEVICES));
+
+  /* device is dead: bus reset after the retries and re-initializations */
+  Restart();
+  busBroken[1] = 1;
+  ok = 1;
+  while (ok && dev[1].nofErrors<100) {
+    ok = TOFH_Read(dev, NOF_DEVICES, &bus);
+    HT_CHECK(OthersOk(1));
+  }
+  HT_CHECK(!ok && dev[1].state==TOFH_STATE_FAILED);
+  HT_CHECK(dev[1].nofErrors==TOFH_MAX_READ_RETRIES && busNofReInit==TOFH_MAX_DEVICE_REINIT);
+  return HT_Result("ToFHealthTest");
+}
@@ -38,6 +38,9 @@ extern "C" {
 #include "Timer.h"
 #include "Keys.h"
 #include "Tacho.h"
+#if PL_CONFIG_HAS_ODOMETRY
+  #include "Odometry.h"
+#endif
 /*
 ** ===================================================================
 **     Event       :  Cpu_OnNMIINT (module Events)
@@ -160,6 +163,9 @@ void FRTOS1_vApplicationTickHook(void)
 {
   /* Called for every RTOS tick. */
   TACHO_Sample();
+#if PL_CONFIG_HAS_ODOMETRY
+  ODO_Sample();
+#endif
 }
 
 /*
@@ -221,8 +227,10 @@ void FRTOS1_vApplicationMallocFailedHook(void)
 */
 void QuadInt_OnInterrupt(void)
 {
+#if !PL_CONFIG_HAS_QUAD_FTM /* otherwise counted by the FTM hardware, QuadInt can be disabled */
 	Q4CLeft_Sample();
 	Q4CRight_Sample();
+#endif
 }
 
 /*
@@ -60,18 +60,30 @@
 #define PL_LOCAL_CONFIG_HAS_BLUETOOTH_DISABLED            /* disable Bluetooth */
 //#define PL_LOCAL_CONFIG_HAS_MOTOR_DISABLED                /* disable motor */
 //#define PL_LOCAL_CONFIG_HAS_QUADRATURE_DISABLED           /* disable quadrature encoder */
+#define PL_LOCAL_CONFIG_HAS_QUAD_FTM_DISABLED             /* disable FTM hardware quadrature decoder (encoders need to be on the FTM QD pins) */
 //#define PL_LOCAL_CONFIG_HAS_MPC4728_DISABLED              /* disable MPC4728 (only for V1 robot) */
 #define PL_LOCAL_CONFIG_HAS_QUAD_CALIBRATION_DISABLED     /* disable quadrature calibration (only for V1 robot) */
 //#define PL_LOCAL_CONFIG_HAS_MOTOR_TACHO_DISABLED          /* disable tacho */
+//#define PL_LOCAL_CONFIG_HAS_MOTOR_CALIBRATION_DISABLED    /* disable motor deadband and nonlinearity calibration */
 //#define PL_LOCAL_CONFIG_HAS_PID_DISABLED                  /* disable PID */
 //#define PL_LOCAL_CONFIG_HAS_DRIVE_DISABLED                /* disable drive module */
+//#define PL_LOCAL_CONFIG_HAS_PID_AUTOTUNE_DISABLED         /* disable PID auto-tuning */
+//#define PL_LOCAL_CONFIG_HAS_TRACTION_DISABLED             /* disable traction (slip, stall and push) estimator */
 #define PL_LOCAL_CONFIG_HAS_LINE_FOLLOW_DISABLED          /* disable line following */
+//#define PL_LOCAL_CONFIG_HAS_LAP_LEARN_DISABLED            /* disable lap learning for line following */
 
 //#define PL_LOCAL_CONFIG_HAS_DISTANCE_DISABLED             /* disabling distance sensors */
 //#define PL_LOCAL_CONFIG_HAS_TOF_SENSOR_DISABLED           /* disabling ToF sensors */
+//#define PL_LOCAL_CONFIG_HAS_ODOMETRY_DISABLED             /* disable odometry */
+//#define PL_LOCAL_CONFIG_HAS_OPPONENT_DISABLED             /* disable opponent tracker */
+//#define PL_LOCAL_CONFIG_HAS_SUMO_DISABLED                 /* disable sumo strategy engine */
 
 //#define PL_LOCAL_CONFIG_HAS_TURN_DISABLED                 /* disable turning module */
+//#define PL_LOCAL_CONFIG_HAS_TURN_CALIBRATION_DISABLED     /* disable turn and wheel geometry calibration */
 #define PL_LOCAL_CONFIG_HAS_LINE_MAZE_DISABLED            /* disable maze solving */
+//#define PL_LOCAL_CONFIG_HAS_MAZE_MAP_DISABLED             /* disable maze map and shortest path */
+//#define PL_LOCAL_CONFIG_HAS_MAZE_RUN_DISABLED             /* disable maze speed run */
 #define PL_LOCAL_CONFIG_HAS_BATTERY_ADC_DISABLED          /* disable battery ADC */
+//#define PL_LOCAL_CONFIG_HAS_ADC_SERVICE_DISABLED          /* disable continuous ADC service */
 
 #endif /* SOURCES_PLATFORM_LOCAL_H_ */
@@ -0,0 +1,523 @@
+/**
+ * \file
+ * \brief Host sumo match simulator and strategy tournament runner.
+ * \author Erich Styger, erich.styger@hslu.ch
+ *
+ * Runs sumo matches between the strategies of the behavior table (INTRO_Common/SumoTable.c, the same code as
+ * on the robot) in a 2D arena: ring with white border, line sensors, ToF sensor cones, motors with a first order
+ * lag and pushing on contact. The simulated sensors go through the input fusion of Sumo.c and the opponent
+ * tracker of OppTrack.c, as on the robot. Matches are seeded and run in parallel on all cores. For each pairing it
+ * reports the win rate, the time to the first contact (of the matches with a contact) and how the matches ended
+ * (pushed out or drove out).
+ *
+ * Build and run on the host (Linux/macOS/MinGW), 'make check' runs a short tournament (also from INTRO_HostTest):
+ *   make
+ *   ./SumoSim -n 2000                          all strategies against each other
+ *   ./SumoSim -n 5000 primitive spiral:front=150  one pairing, variant with a different parameter
+ *
+ * Options: -n matches per pairing, -s seed, -j threads, -t time limit in s, -v to print each match.
+ * A strategy is a name of the table with optional parameters: name[:front=mm][:side=mm][:rear=mm]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "SumoTable.h"
+#include "Sumo.h"
+#include "OppTrack.h"
+
+#ifndef M_PI
+  #define M_PI 3.14159265358979323846
+#endif
+
+/* arena and robot, in mm and s. \todo adopt to your ring and robot */
+#define SIM_RING_RADIUS       385.0  /* mini sumo ring, 77 cm */
+#define SIM_BORDER_WIDTH      25.0   /* white border at the edge of the ring */
+#define SIM_ROBOT_RADIUS      55.0   /* robots are circles for the contact */
+#define SIM_WHEEL_BASE        90.0
+#define SIM_MAX_SPEED         700.0  /* wheel speed at 100% */
+#define SIM_MOTOR_TAU         0.08   /* motor time constant */
+#define SIM_MOTOR_SPREAD      0.05   /* +/- variation of the motor gain between robots */
+#define SIM_START_DIST        120.0  /* distance of the robots from the center at the start */
+#define SIM_SENSOR_X          45.0   /* line sensors in front of the center */
+#define SIM_NOF_LINE_SENSORS  6      /* sensor 0 is on the left, like on the robot */
+#define SIM_SENSOR_PITCH      10.0
+#define SIM_TOF_RANGE         200.0  /* maximum range of the ToF sensors */
+#define SIM_TOF_CONE_DEG      12.5   /* half angle of the ToF cone */
+#define SIM_TOF_NOISE         3.0    /* standard deviation of the ToF distance */
+#define SIM_DT                0.001  /* physics step */
+#define SIM_CONTROL_MS        10     /* control cycle of the strategy */
+#define SIM_PUSHED_MS         300    /* a ring out within this time after a contact counts as pushed out */
+#define SIM_REF_WHITE         100    /* calibrated line sensor value on the white border */
+#define SIM_REF_BLACK         900    /* calibrated line sensor value on the black ring */
+
+#if SIM_NOF_LINE_SENSORS!=REF_NOF_SENSORS
+  #error "simulated line sensors have to match the robot"
+#endif
+
+typedef struct {
+  const STBL_Strategy *strategy;
+  char name[48];
+  int16_t params[SUMO_NOF_PARAMS]; /* sumo parameters, with the detection ranges */
+} SIM_Player;
+
+typedef struct {
+  double x, y, heading; /* position and heading (rad) */
+  double vl, vr; /* wheel speeds */
+  double cmdL, cmdR; /* commanded wheel speeds */
+  double gain; /* motor gain */
+  STBL_Engine engine;
+  OPPT_Tracker tracker;
+  double lastX, lastY, lastHeading; /* pose at the last control cycle, for the wheel motion of the tracker */
+  const SIM_Player *player;
+} SIM_Robot;
+
+typedef enum {
+  SIM_RESULT_DRAW,
+  SIM_RESULT_WIN_A,
+  SIM_RESULT_WIN_B
+} SIM_Result;
+
+typedef struct {
+  SIM_Result result;
+  int pushedOut; /* loser was pushed out, otherwise it drove out */
+  int timeMs; /* end of the match */
+  int contactMs; /* first contact, -1 if none */
+} SIM_Match;
+
+/* random numbers, one generator per match so results do not depend on the threads */
+typedef struct {
+  uint64_t s;
+} SIM_Rand;
+
+static uint64_t RandNext(SIM_Rand *r) { /* xorshift64* */
+  r->s ^= r->s>>12;
+  r->s ^= r->s<<25;
+  r->s ^= r->s>>27;
+  return r->s*2685821657736338717ULL;
+}
+
+static double RandUniform(SIM_Rand *r) { /* 0..1 */
+  return (RandNext(r)>>11)*(1.0/9007199254740992.0);
+}
+
+static double RandGauss(SIM_Rand *r) {
+  double u1, u2;
+
+  u1 = RandUniform(r);
+  u2 = RandUniform(r);
+  if (u1<1e-12) {
+    u1 = 1e-12;
+  }
+  return sqrt(-2.0*log(u1))*cos(2.0*M_PI*u2);
+}
+
+static double WrapAngle(double a) {
+  while (a>M_PI) {
+    a -= 2.0*M_PI;
+  }
+  while (a<-M_PI) {
+    a += 2.0*M_PI;
+  }
+  return a;
+}
+
+/* point in robot coordinates (x forward, y left) to world */
+static void ToWorld(const SIM_Robot *rb, double px, double py, double *wx, double *wy) {
+  double c = cos(rb->heading), s = sin(rb->heading);
+
+  *wx = rb->x+c*px-s*py;
+  *wy = rb->y+s*px+c*py;
+}
+
+static int IsBlack(double x, double y) {
+  return sqrt(x*x+y*y)<SIM_RING_RADIUS-SIM_BORDER_WIDTH;
+}
+
+/* distance seen by a ToF sensor at (px,py) in robot coordinates, looking in direction dir, or -1 */
+static double ToF(const SIM_Robot *rb, const SIM_Robot *other, double px, double py, double dir, SIM_Rand *rnd) {
+  double sx, sy, dx, dy, d, angle, halfWidth;
+
+  ToWorld(rb, px, py, &sx, &sy);
+  dx = other->x-sx;
+  dy = other->y-sy;
+  d = sqrt(dx*dx+dy*dy);
+  if (d<=SIM_ROBOT_RADIUS) {
+    return 0.0; /* touching */
+  }
+  angle = fabs(WrapAngle(atan2(dy, dx)-(rb->heading+dir)));
+  halfWidth = asin(SIM_ROBOT_RADIUS/d);
+  if (angle-halfWidth>SIM_TOF_CONE_DEG*M_PI/180.0) {
+    return -1.0; /* not in the cone */
+  }
+  d -= SIM_ROBOT_RADIUS;
+  d += RandGauss(rnd)*SIM_TOF_NOISE;
+  if (d>SIM_TOF_RANGE) {
+    return -1.0;
+  }
+  return d<0?0:d;
+}
+
+/* ToF range in mm as returned by DIST_GetDistance(), negative if nothing is seen */
+static int16_t ToFRange(const SIM_Robot *rb, const SIM_Robot *other, double px, double py, double dir, SIM_Rand *rnd) {
+  double d = ToF(rb, other, px, py, dir, rnd);
+
+  return d<0?-1:(int16_t)(d+0.5);
+}
+
+/* simulates the sensors read by the sumo task, like ReadSensors() in Sumo.c */
+static void ReadSensors(SIM_Robot *rb, const SIM_Robot *other, SIM_Rand *rnd, SUMO_Sensors *sensors) {
+  int16_t range[OPPT_NOF_SENSORS], oppRange;
+  double dx, dy;
+  int i, black = 0;
+  double wx, wy;
+
+  for(i=0;i<SIM_NOF_LINE_SENSORS;i++) {
+    ToWorld(rb, SIM_SENSOR_X, ((SIM_NOF_LINE_SENSORS-1)/2.0-i)*SIM_SENSOR_PITCH, &wx, &wy);
+    if (IsBlack(wx, wy)) {
+      sensors->ref[i] = SIM_REF_BLACK;
+      black++;
+    } else {
+      sensors->ref[i] = SIM_REF_WHITE;
+    }
+  }
+  sensors->lineKind = black==SIM_NOF_LINE_SENSORS?REF_LINE_FULL:REF_LINE_NONE; /* the fusion only checks for REF_LINE_FULL */
+  sensors->reflex = 0; /* border reflex is not simulated, the table reacts within one control cycle */
+  sensors->front = range[OPPT_SENSOR_FRONT] = ToFRange(rb, other, SIM_ROBOT_RADIUS, 0, 0, rnd);
+  sensors->rear = range[OPPT_SENSOR_REAR] = ToFRange(rb, other, -SIM_ROBOT_RADIUS, 0, M_PI, rnd);
+  sensors->left = range[OPPT_SENSOR_LEFT] = ToFRange(rb, other, 0, SIM_ROBOT_RADIUS, M_PI/2, rnd);
+  sensors->right = range[OPPT_SENSOR_RIGHT] = ToFRange(rb, other, 0, -SIM_ROBOT_RADIUS, -M_PI/2, rnd);
+  /* opponent tracker with the wheel motion since the last cycle, like the task in Opponent.c */
+  dx = rb->x-rb->lastX;
+  dy = rb->y-rb->lastY;
+  OPPT_Predict(&rb->tracker, (int32_t)(dx*cos(rb->lastHeading)+dy*sin(rb->lastHeading)),
+    (int32_t)(WrapAngle(rb->heading-rb->lastHeading)*1000.0), SIM_CONTROL_MS);
+  OPPT_Update(&rb->tracker, range);
+  rb->lastX = rb->x;
+  rb->lastY = rb->y;
+  rb->lastHeading = rb->heading;
+  sensors->oppValid = OPPT_GetTarget(&rb->tracker, &sensors->oppBearing, &oppRange);
+}
+
+static void Control(SIM_Robot *rb, const SIM_Robot *other, uint32_t nowMs, SIM_Rand *rnd) {
+  SUMO_Sensors sensors;
+  int8_t left, right;
+
+  ReadSensors(rb, other, rnd, &sensors);
+  if (STBL_Step(&rb->engine, SUMO_FuseInputs(&rb->engine, &sensors, rb->player->params), nowMs, &left, &right)!=STBL_RULE_NONE) {
+    rb->cmdL = left*SIM_MAX_SPEED/100.0*rb->gain;
+    rb->cmdR = right*SIM_MAX_SPEED/100.0*rb->gain;
+  }
+}
+
+static void Move(SIM_Robot *rb) {
+  double v, w;
+
+  rb->vl += (rb->cmdL-rb->vl)*SIM_DT/SIM_MOTOR_TAU;
+  rb->vr += (rb->cmdR-rb->vr)*SIM_DT/SIM_MOTOR_TAU;
+  v = (rb->vl+rb->vr)/2.0;
+  w = (rb->vr-rb->vl)/SIM_WHEEL_BASE;
+  rb->x += v*cos(rb->heading)*SIM_DT;
+  rb->y += v*sin(rb->heading)*SIM_DT;
+  rb->heading = WrapAngle(rb->heading+w*SIM_DT);
+}
+
+/* resolves an overlap: the robot pushing harder along the contact normal moves the other one. Returns 1 on contact */
+static int Contact(SIM_Robot *a, SIM_Robot *b) {
+  double dx, dy, d, nx, ny, depth, pa, pb, shareA;
+
+  dx = b->x-a->x;
+  dy = b->y-a->y;
+  d = sqrt(dx*dx+dy*dy);
+  if (d>=2*SIM_ROBOT_RADIUS) {
+    return 0;
+  }
+  if (d<1e-6) {
+    dx = 1; dy = 0; d = 1;
+  }
+  nx = dx/d;
+  ny = dy/d;
+  depth = 2*SIM_ROBOT_RADIUS-d;
+  /* push of each robot towards the other one */
+  pa = ((a->vl+a->vr)/2.0)*(cos(a->heading)*nx+sin(a->heading)*ny);
+  pb = -((b->vl+b->vr)/2.0)*(cos(b->heading)*nx+sin(b->heading)*ny);
+  pa = pa>0?pa:0;
+  pb = pb>0?pb:0;
+  shareA = (pa+pb)>0?pb/(pa+pb):0.5; /* part of the correction done by moving a back */
+  a->x -= nx*depth*shareA;
+  a->y -= ny*depth*shareA;
+  b->x += nx*depth*(1.0-shareA);
+  b->y += ny*depth*(1.0-shareA);
+  return 1;
+}
+
+static int IsOut(const SIM_Robot *rb) {
+  return sqrt(rb->x*rb->x+rb->y*rb->y)>SIM_RING_RADIUS;
+}
+
+static void InitRobot(SIM_Robot *rb, const SIM_Player *player, double x, SIM_Rand *rnd) {
+  memset(rb, 0, sizeof(*rb));
+  rb->player = player;
+  rb->x = x;
+  rb->y = (RandUniform(rnd)-0.5)*20.0;
+  rb->heading = (RandUniform(rnd)*2.0-1.0)*M_PI;
+  rb->gain = 1.0+(RandUniform(rnd)*2.0-1.0)*SIM_MOTOR_SPREAD;
+  rb->lastX = rb->x;
+  rb->lastY = rb->y;
+  rb->lastHeading = rb->heading;
+  STBL_Load(&rb->engine, player->strategy);
+  OPPT_Init(&rb->tracker);
+}
+
+static void RunMatch(const SIM_Player *pa, const SIM_Player *pb, uint64_t seed, int timeLimitMs, SIM_Match *m) {
+  SIM_Robot a, b;
+  SIM_Rand rnd;
+  int ms, step, outA, outB, lastContactMs = -100000;
+  int stepsPerMs = (int)(0.001/SIM_DT+0.5);
+
+  rnd.s = seed*0x9E3779B97F4A7C15ULL+1;
+  InitRobot(&a, pa, -SIM_START_DIST, &rnd);
+  InitRobot(&b, pb, SIM_START_DIST, &rnd);
+  m->contactMs = -1;
+  m->pushedOut = 0;
+  for(ms=0;ms<timeLimitMs;ms++) {
+    if (ms%SIM_CONTROL_MS==0) {
+      Control(&a, &b, (uint32_t)ms, &rnd);
+      Control(&b, &a, (uint32_t)ms, &rnd);
+    }
+    for(step=0;step<stepsPerMs;step++) {
+      Move(&a);
+      Move(&b);
+      if (Contact(&a, &b)) {
+        lastContactMs = ms;
+        if (m->contactMs<0) {
+          m->contactMs = ms;
+        }
+      }
+    }
+    outA = IsOut(&a);
+    outB = IsOut(&b);
+    if (outA || outB) {
+      m->timeMs = ms;
+      if (outA && outB) {
+        m->result = SIM_RESULT_DRAW;
+      } else {
+        m->result = outA?SIM_RESULT_WIN_B:SIM_RESULT_WIN_A;
+        m->pushedOut = ms-lastContactMs<=SIM_PUSHED_MS;
+      }
+      return;
+    }
+  }
+  m->timeMs = timeLimitMs;
+  m->result = SIM_RESULT_DRAW;
+}
+
+/* work shared by the threads: one pairing at a time */
+typedef struct {
+  const SIM_Player *a, *b;
+  uint64_t seed;
+  int nofMatches;
+  int timeLimitMs;
+  int next; /* next match to run, atomic */
+  SIM_Match *matches;
+} SIM_Work;
+
+static void *Worker(void *arg) {
+  SIM_Work *w = (SIM_Work*)arg;
+  int i;
+
+  for(;;) {
+    i = __sync_fetch_and_add(&w->next, 1);
+    if (i>=w->nofMatches) {
+      break;
+    }
+    RunMatch(w->a, w->b, w->seed+(uint64_t)i, w->timeLimitMs, &w->matches[i]);
+  }
+  return NULL;
+}
+
+static void PrintHeader(void) {
+  printf("%-24s %-24s %6s %6s %6s %9s %7s %7s %7s %7s\n",
+    "A", "B", "win A", "win B", "draw", "contact", "no cont", "pushed", "drove", "length");
+  printf("%-24s %-24s %6s %6s %6s %9s %7s %7s %7s %7s\n",
+    "", "", "%", "%", "%", "ms (avg)", "%", "%", "%", "ms (avg)");
+}
+
+static void RunPairing(const SIM_Player *a, const SIM_Player *b, int nofMatches, uint64_t seed, int nofThreads, int timeLimitMs, int verbose) {
+  SIM_Work w;
+  pthread_t *threads;
+  int i, winA = 0, winB = 0, draw = 0, contacts = 0, pushed = 0, drove = 0;
+  double contactSum = 0, lengthSum = 0;
+  char contact[32];
+
+  w.a = a;
+  w.b = b;
+  w.seed = seed;
+  w.nofMatches = nofMatches;
+  w.timeLimitMs = timeLimitMs;
+  w.next = 0;
+  w.matches = calloc((size_t)nofMatches, sizeof(SIM_Match));
+  threads = calloc((size_t)nofThreads, sizeof(pthread_t));
+  if (w.matches==NULL || threads==NULL) {
+    fprintf(stderr, "**** out of memory\n");
+    exit(EXIT_FAILURE);
+  }
+  for(i=0;i<nofThreads;i++) {
+    if (pthread_create(&threads[i], NULL, Worker, &w)!=0) {
+      fprintf(stderr, "**** cannot create thread\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for(i=0;i<nofThreads;i++) {
+    pthread_join(threads[i], NULL);
+  }
+  for(i=0;i<nofMatches;i++) {
+    const SIM_Match *m = &w.matches[i];
+
+    if (verbose) {
+      if (m->contactMs>=0) {
+        snprintf(contact, sizeof(contact), "contact %d ms", m->contactMs);
+      } else {
+        snprintf(contact, sizeof(contact), "no contact");
+      }
+      printf("match %d seed %llu: %s, %d ms, %s%s\n", i, (unsigned long long)(seed+(uint64_t)i),
+        m->result==SIM_RESULT_WIN_A?"A wins":m->result==SIM_RESULT_WIN_B?"B wins":"draw",
+        m->timeMs, contact, m->result!=SIM_RESULT_DRAW?(m->pushedOut?", pushed out":", drove out"):"");
+    }
+    switch(m->result) {
+      case SIM_RESULT_WIN_A: winA++; break;
+      case SIM_RESULT_WIN_B: winB++; break;
+      default: draw++; break;
+    }
+    if (m->contactMs>=0) { /* matches without contact do not count for the average */
+      contacts++;
+      contactSum += m->contactMs;
+    }
+    if (m->result!=SIM_RESULT_DRAW) {
+      if (m->pushedOut) {
+        pushed++;
+      } else {
+        drove++;
+      }
+    }
+    lengthSum += m->timeMs;
+  }
+  if (contacts>0) {
+    snprintf(contact, sizeof(contact), "%.0f", contactSum/contacts);
+  } else {
+    snprintf(contact, sizeof(contact), "-"); /* no match with a contact */
+  }
+  printf("%-24s %-24s %6.1f %6.1f %6.1f %9s %7.1f %7.1f %7.1f %7.0f\n",
+    a->name, b->name,
+    100.0*winA/nofMatches, 100.0*winB/nofMatches, 100.0*draw/nofMatches,
+    contact,
+    100.0*(nofMatches-contacts)/nofMatches,
+    100.0*pushed/nofMatches, 100.0*drove/nofMatches,
+    lengthSum/nofMatches);
+  fflush(stdout);
+  free(threads);
+  free(w.matches);
+}
+
+/* parses name[:front=mm][:side=mm][:rear=mm] */
+static int ParsePlayer(const char *arg, SIM_Player *p) {
+  char buf[64], *tok, *save;
+  int i, val;
+
+  strncpy(buf, arg, sizeof(buf)-1);
+  buf[sizeof(buf)-1] = '\0';
+  strncpy(p->name, arg, sizeof(p->name)-1);
+  p->name[sizeof(p->name)-1] = '\0';
+  p->params[SUMO_PARAM_FRONT] = 100; /* same defaults as in Sumo.c */
+  p->params[SUMO_PARAM_SIDE] = 200;
+  p->params[SUMO_PARAM_REAR] = 100;
+  p->params[SUMO_PARAM_DELAY] = 0;
+  p->strategy = NULL;
+  tok = strtok_r(buf, ":", &save);
+  for(i=0;tok!=NULL && i<STBL_NofStrategies;i++) {
+    if (strcmp(tok, STBL_Strategies[i].name)==0) {
+      p->strategy = &STBL_Strategies[i];
+    }
+  }
+  if (p->strategy==NULL) {
+    fprintf(stderr, "**** unknown strategy '%s'\n", arg);
+    return -1;
+  }
+  while ((tok=strtok_r(NULL, ":", &save))!=NULL) {
+    if (sscanf(tok, "front=%d", &val)==1) {
+      p->params[SUMO_PARAM_FRONT] = (int16_t)val;
+    } else if (sscanf(tok, "side=%d", &val)==1) {
+      p->params[SUMO_PARAM_SIDE] = (int16_t)val;
+    } else if (sscanf(tok, "rear=%d", &val)==1) {
+      p->params[SUMO_PARAM_REAR] = (int16_t)val;
+    } else {
+      fprintf(stderr, "**** unknown parameter '%s'\n", tok);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void Usage(const char *prog) {
+  int i;
+
+  fprintf(stderr, "usage: %s [-n matches] [-s seed] [-j threads] [-t seconds] [-v] [strategyA strategyB]\n", prog);
+  fprintf(stderr, "strategy: name[:front=mm][:side=mm][:rear=mm], names:");
+  for(i=0;i<STBL_NofStrategies;i++) {
+    fprintf(stderr, " %s", STBL_Strategies[i].name);
+  }
+  fprintf(stderr, "\nwithout strategies, all built-in strategies play against each other.\n");
+}
+
+int main(int argc, char *argv[]) {
+  int opt, i, j, nofMatches = 1000, nofThreads, timeLimitS = 30, verbose = 0;
+  uint64_t seed = 1;
+  SIM_Player players[2], *all;
+
+  nofThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nofThreads<1) {
+    nofThreads = 1;
+  }
+  while ((opt=getopt(argc, argv, "n:s:j:t:vh"))!=-1) {
+    switch(opt) {
+      case 'n': nofMatches = atoi(optarg); break;
+      case 's': seed = strtoull(optarg, NULL, 0); break;
+      case 'j': nofThreads = atoi(optarg); break;
+      case 't': timeLimitS = atoi(optarg); break;
+      case 'v': verbose = 1; break;
+      default: Usage(argv[0]); return EXIT_FAILURE;
+    }
+  }
+  if (nofMatches<1 || nofThreads<1 || timeLimitS<1 || (argc-optind!=0 && argc-optind!=2)) {
+    Usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  printf("%d matches per pairing, seed %llu, %d threads, %d s time limit\n", nofMatches, (unsigned long long)seed, nofThreads, timeLimitS);
+  PrintHeader();
+  if (argc-optind==2) {
+    if (ParsePlayer(argv[optind], &players[0])!=0 || ParsePlayer(argv[optind+1], &players[1])!=0) {
+      return EXIT_FAILURE;
+    }
+    RunPairing(&players[0], &players[1], nofMatches, seed, nofThreads, timeLimitS*1000, verbose);
+  } else { /* tournament: every strategy against every other one, including itself */
+    all = calloc(STBL_NofStrategies, sizeof(SIM_Player));
+    if (all==NULL) {
+      fprintf(stderr, "**** out of memory\n");
+      return EXIT_FAILURE;
+    }
+    for(i=0;i<STBL_NofStrategies;i++) {
+      (void)ParsePlayer(STBL_Strategies[i].name, &all[i]);
+    }
+    for(i=0;i<STBL_NofStrategies;i++) {
+      for(j=i;j<STBL_NofStrategies;j++) {
+        RunPairing(&all[i], &all[j], nofMatches, seed, nofThreads, timeLimitS*1000, verbose);
+      }
+    }
+    free(all);
+  }
+  return EXIT_SUCCESS;
+}